@@ -0,0 +1,117 @@
+//Pin assignments and device configuration for the gps_clock board.
+//Everything here is a compile-time constant, so the static inline helpers below only choose between constants.  The SPI queue passes the
+//device at run time, so each helper is a test of the device number followed by an sbi/cbi or a constant register image (not yet measured
+//with avr-size or the profiler).  To port to different wiring, only this file should need changing.
+
+#ifndef BOARD_H
+#define BOARD_H
+
+#include <avr/io.h>
+
+//SPI bus.
+#define SPI_PORT	PORTB	//Port B utilised for SPI comms
+#define SPI_DDR		DDRB	//Data Direction Register B used to set SPI comms input/output pins.
+#define SPI_MOSI	PB3	//Pin B3 used for SPI MOSI (Master Out, Slave In)
+#define SPI_MISO	PB4	//Pin B4 used for SPI MOSI (Master In, Slave Out)
+#define SPI_SCK		PB5	//Pin B5 used for SPI SCK (Synchronous Clock)
+#define SPI_SS		PB2	//Pin B2 is the hardware SS.  Must be an output for the SPI to remain master.
+
+//SPI clock rates.  Bits 1-0 are SPR1:SPR0 in SPCR, bit 2 is SPI2X in SPSR.
+#define SPI_CLOCK_DIV_2		0b100	//4MHz at 8MHz
+#define SPI_CLOCK_DIV_4		0b000	//2MHz at 8MHz
+#define SPI_CLOCK_DIV_8		0b101	//1MHz at 8MHz
+#define SPI_CLOCK_DIV_16	0b001	//500kHz at 8MHz
+#define SPI_CLOCK_DIV_32	0b110	//250kHz at 8MHz
+#define SPI_CLOCK_DIV_64	0b010	//125kHz at 8MHz
+#define SPI_CLOCK_DIV_128	0b011	//62.5kHz at 8MHz
+
+//Register images for a clock rate and mode (SPIE, SPE and MSTR are added when applied).
+#define SPI_SPCR(clock, polarity, phase)	(((clock) & 0b011) | ((polarity) << CPOL) | ((phase) << CPHA))
+#define SPI_SPSR(clock)				(((clock) >> 2) << SPI2X)
+
+//Devices on the SPI bus.
+#define SPI_DEVICE_RTC		0	//DS3234 real-time clock.
+#define SPI_DEVICE_SEV_SEG	1	//Cascaded MAX7219 display drivers.
+
+//DS3234 RTC.
+#define RTC_PORT	PORTB		//Port on which the slave select pin is found.
+#define RTC_DDR		DDRB		//Data direction register for the slave select pin.
+#define RTC_SS		PB2		//RTC SPI Slave Select Pin = Port B Pin 2
+#define RTC_POL 	1		//RTC SPI Polarity = 1 (clock idles high) (DS2334 works in mode 1 or 3)
+#define RTC_PHA 	1		//RTC SPI Phase = 1 (DS2334 works in mode 1 or 3)
+#define RTC_CLOCK	SPI_CLOCK_DIV_4	//RTC SPI Clock = 2MHz (DS3234 maximum is 4MHz)
+#define RTC_SQW_WIRED	0		//1 if the RTC square wave is wired to the AVR.  It isn't on the cl0ck_control PCB: DS3234 !INT/SQW
+					//(IC2 pin 5) and PD2/INT0 (IC1 pin 32) are each left unconnected, so a bodge wire between them is needed.
+					//Without it the second isn't marked, so there is no tick-committed display or ZDA sentence, no oscillator
+					//calibration and no fraction of a second modes, and the time is shown once the RTC seconds are seen to change.
+#define RTC_SQW_PORT	PORTD		//Port on which the RTC square wave (!INT/SQW, open drain) is received.
+#define RTC_SQW_DDR	DDRD		//Data direction register for the square wave pin.
+#define RTC_SQW		PD2		//RTC 1Hz square wave = Port D Pin 2 (INT0).  The falling edge marks the start of each second.
+#define RTC_SQW_INT	INT0		//External interrupt enabled in EIMSK (only if RTC_SQW_WIRED).
+#define RTC_SQW_EDGE	(1 << ISC01)	//EICRA: interrupt on the falling edge.
+#define RTC_SQW_VECTOR	INT0_vect	//Square wave interrupt sub-routine vector.
+
+//MAX7219 display drivers.
+#define SEV_SEG_PORT	PORTB		//Port on which the load pin is found.
+#define SEV_SEG_DDR	DDRB		//Data direction register for the load pin.
+#define SEV_SEG_LOAD	PB1		//Although MAX7219 is not true SPI, LOAD pin triggers latching (on rising edge) and acts similarly to SS/CS.
+#define SEV_SEG_POL	1		//Set polarity for SPI comms.
+#define SEV_SEG_PHA	1		//Set phase for SPI comms
+#define SEV_SEG_CLOCK	SPI_CLOCK_DIV_2	//Set clock rate for SPI comms - 4MHz (MAX7219 maximum is 10MHz).
+#define SEV_SEG_CHIPS	2		//Number of cascaded MAX7219s (8 digits each).  Chip 0 (digits 0-7) is connected to MOSI.
+
+//GPS receiver.
+#define GPS_POWER_SAVE	0		//1 to put the receiver into backup mode between syncs (the USART TXD must be wired to its RXD).
+					//Any activity on its RXD wakes it, so everything else sent on the same TXD is discarded while it
+					//sleeps (up to RESYNC_INTERVAL_MAX): telemetry frames, ZDA sentences, the OSCCAL search report and
+					//the rest of a profiler or sync log dump.  A console command wakes it first, so replies are sent.
+
+//Buttons.
+#define BUTTON_DDR			DDRC		//DDRC: Data Direction Register C - For setting IO to input or output at port C.
+#define BUTTON_PORT			PORTC		//PORTC: Port C - For writing to IO.
+#define BUTTON_PINS			PINC		//PINC: Pin C - For reading from IO.
+#define BUTTON_PCIE			PCIE1		//PCIE1: Pin Change Interrupt Enable 1 - For enabling interrupts on IO level change.
+#define BUTTON_PCMSK			PCMSK1		//PCMSK1: Pin Change Mask Register 1 - For masking which IO lines to trigger interrupt.
+#define BUTTON_MODE			PC0		//PC0: PCINT8
+#define BUTTON_SYNC			PC1		//PC1: PCINT9
+#define BUTTON_PCI_VECTOR		PCINT1_vect	//PCINT1: Pin-Change Interrupt 1 - Define the interrupt sub-routine vector function name.
+
+//Select (drive low) a device on the SPI bus.  A test of the device number then a cbi (a single cbi only for a constant device).
+static inline void spi_device_select(uint8_t device)
+{
+	if(device == SPI_DEVICE_RTC)
+	{
+		RTC_PORT &= ~(1 << RTC_SS);
+	}
+	else
+	{
+		SEV_SEG_PORT &= ~(1 << SEV_SEG_LOAD);
+	}
+}
+
+//Release (drive high) a device on the SPI bus.  A test of the device number then an sbi (a single sbi only for a constant device).
+static inline void spi_device_release(uint8_t device)
+{
+	if(device == SPI_DEVICE_RTC)
+	{
+		RTC_PORT |= (1 << RTC_SS);
+	}
+	else
+	{
+		SEV_SEG_PORT |= (1 << SEV_SEG_LOAD);	//LOAD rising edge latches the MAX7219s.
+	}
+}
+
+//SPCR image (clock rate and mode) for a device.
+static inline uint8_t spi_device_spcr(uint8_t device)
+{
+	return((device == SPI_DEVICE_RTC) ? SPI_SPCR(RTC_CLOCK, RTC_POL, RTC_PHA) : SPI_SPCR(SEV_SEG_CLOCK, SEV_SEG_POL, SEV_SEG_PHA));
+}
+
+//SPSR image (double speed bit) for a device.
+static inline uint8_t spi_device_spsr(uint8_t device)
+{
+	return((device == SPI_DEVICE_RTC) ? SPI_SPSR(RTC_CLOCK) : SPI_SPSR(SEV_SEG_CLOCK));
+}
+
+#endif
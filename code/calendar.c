@@ -0,0 +1,136 @@
+//Functions for the calendar arithmetic on the (packed BCD) time structure.
+
+#include <calendar.h>
+
+//The following 2-dimensional array serves as a look-up table to determine the number of days elapsed within the current 4-year block.
+//This is required so that leap-days are included when calculating epoch time.
+//Each element represents the number of days elapsed from the start of the 4-year block to the start of the selected month.
+//Stored in flash (PROGMEM) so must be read with pgm_read_word().
+const uint16_t days_table[4][12] PROGMEM =
+{	//Jan  Feb  Mar  Apr  May  Jun  Jul  Aug  Sep  Oct  Nov  Dec
+	{   0,  31,  60,  91, 121, 152, 182, 213, 244, 274, 305, 335},	//First year (leap year).
+	{ 366, 397, 425, 456, 486, 517, 547, 578, 609, 639, 670, 700},	//Second year.
+	{ 731, 762, 790, 821, 851, 882, 912, 943, 974,1004,1035,1065},	//Third year.
+	{1096,1127,1155,1186,1216,1247,1277,1308,1339,1369,1400,1430},	//Fourth year.
+};
+
+//Advance a time structure by one second, carrying into the minutes, hours, date, month, year and century flag.
+//Used to render a frame before its second begins.  Digits are carried in BCD without converting to binary.
+void next_second(rtc_time *time)
+{
+	uint8_t days;				//Days in the current month.
+
+	time->seconds = BCD_INCREMENT(time->seconds);
+	if (time->seconds < 0x60)
+	{
+		return;
+	}
+	time->seconds = 0x00;
+
+	time->minutes = BCD_INCREMENT(time->minutes);
+	if (time->minutes < 0x60)
+	{
+		return;
+	}
+	time->minutes = 0x00;
+
+	time->hours = BCD_INCREMENT(time->hours);
+	if (time->hours < 0x24)
+	{
+		return;
+	}
+	time->hours = 0x00;
+
+	if ((EPOCH_MONTH < JAN) || (EPOCH_MONTH >= DEC))	//December (or an invalid month that would index outside of days_table).
+	{
+		days = 31;
+	}
+	else
+	{
+		days = pgm_read_word(&days_table[EPOCH_YEAR % 4][EPOCH_MONTH]) - pgm_read_word(&days_table[EPOCH_YEAR % 4][EPOCH_MONTH - 1]);
+	}
+
+	if (EPOCH_DAY < days)
+	{
+		time->date = BCD_INCREMENT(time->date);
+		return;
+	}
+	time->date = 0x01;
+
+	if ((time->month & RTC_MONTH) < 0x12)
+	{
+		time->month = (time->month & RTC_CENTURY) | BCD_INCREMENT(time->month & RTC_MONTH);
+		return;
+	}
+	time->month = (time->month & RTC_CENTURY) | 0x01;
+
+	time->year = BCD_INCREMENT(time->year);
+	if (time->year > 0x99)			//Year 99 rolls over to 00 of the next century.
+	{
+		time->year = 0x00;
+		time->month ^= RTC_CENTURY;
+	}
+}
+
+//Calculate UNIX Epoch time (seconds elapsed since 1970.01.01.00.00.00) from the passed time structure.
+//This will work for any date time from Jan 1st 2000 until Dec 31st 2100.
+uint32_t calculate_epoch(const rtc_time *time)
+{
+	uint32_t epoch;
+
+	if ((EPOCH_MONTH < 1) || (EPOCH_MONTH > 12))	//An invalid month (e.g. RTC never set) would index outside of days_table.
+	{
+		return(0);
+	}
+
+	epoch =  EPOCH_SECONDS_TO_2000;						//Seconds elapsed from 19700101000000 to 20000101000000.
+	epoch += (EPOCH_YEAR/4) * DAYS_IN_4_YEARS * SECONDS_IN_A_DAY;		//Seconds elapsed in full 4-year blocks since 2000.
+	epoch += pgm_read_word(&days_table[EPOCH_YEAR % 4][EPOCH_MONTH - 1]) * SECONDS_IN_A_DAY;//Seconds elapsed in current 4-year block to start of month.
+	epoch += (EPOCH_DAY -1) * SECONDS_IN_A_DAY;				//Seconds elapsed since start of month to start of day.
+	epoch += EPOCH_HOUR * SECONDS_IN_AN_HOUR;				//Seconds elapsed since start of day to start of hour.
+	epoch += EPOCH_MINUTE * SECONDS_IN_A_MINUTE;				//Seconds elapsed since start of hour to to start of minute.
+	epoch += EPOCH_SECOND;							//Seconds elapsed since start of minute.
+
+	return(epoch);
+}
+
+//Fill the time structure from UNIX Epoch time.  The inverse of calculate_epoch(), so it works for Jan 1st 2000 until Dec 31st 2099.
+//The year within the 4-year block, then the month, are found by searching days_table backwards.
+void epoch_to_time(uint32_t epoch, rtc_time *time)
+{
+	uint32_t seconds = (epoch - EPOCH_SECONDS_TO_2000) % SECONDS_IN_A_DAY;	//Seconds elapsed since start of day.
+	uint16_t days = (epoch - EPOCH_SECONDS_TO_2000) / SECONDS_IN_A_DAY;	//Days elapsed since 2000.
+	uint8_t year = (days / DAYS_IN_4_YEARS) * 4;				//Years since 2000 to the start of the 4-year block.
+	uint16_t block_days = days % DAYS_IN_4_YEARS;				//Days elapsed in the 4-year block.
+	uint8_t block_year = 3;
+	uint8_t month = 11;
+
+	while (block_days < pgm_read_word(&days_table[block_year][0]))
+	{
+		block_year--;
+	}
+	while (block_days < pgm_read_word(&days_table[block_year][month]))
+	{
+		month--;
+	}
+
+	time->seconds = BIN_TO_BCD(seconds % SECONDS_IN_A_MINUTE);
+	time->minutes = BIN_TO_BCD((seconds / SECONDS_IN_A_MINUTE) % 60);
+	time->hours = BIN_TO_BCD(seconds / SECONDS_IN_AN_HOUR);
+	time->day = ISO_WEEKDAY(days + EPOCH_DAYS_TO_2000);
+	time->date = BIN_TO_BCD(block_days - pgm_read_word(&days_table[block_year][month]) + 1);
+	time->month = BIN_TO_BCD(month + 1) | RTC_CENTURY;
+	time->year = BIN_TO_BCD(year + block_year);
+}
+
+//Convert a local time (as kept by the RTC, at the current offset) to UTC seconds since epoch.
+uint32_t local_to_utc(const rtc_time *time)
+{
+	return(calculate_epoch(time) - ((int32_t) offset * OFFSET_SECONDS));
+}
+
+//Fill a time structure with the local time (at the current offset) of UTC seconds since epoch.  The inverse of local_to_utc().
+void utc_to_local(uint32_t utc, rtc_time *time)
+{
+	epoch_to_time(utc + ((int32_t) offset * OFFSET_SECONDS), time);
+}
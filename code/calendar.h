@@ -0,0 +1,42 @@
+//Definitions and declarations for the calendar arithmetic on the (packed BCD) time structure: stepping it by a second and converting it to
+//and from seconds since epoch (UTC, or local time at the RTC's offset).  Nothing here touches the hardware, so it also builds on the host
+//(see test/soak.c).  Dates from Jan 1st 2000 to Dec 31st 2099 are supported (every fourth year is a leap year, as for the DS3234).
+
+#ifndef CALENDAR_H
+#define CALENDAR_H
+
+#include <avr/io.h>
+#include <avr/pgmspace.h>	//days_table is stored in flash.
+#include <ds3234.h>		//For the (packed BCD) rtc_time structure and the BCD conversion macros.
+
+//These definitions are used to make the calculation of epoch UNIX time much more readable.
+//Epoch time (or unix epoch time) is the number of seconds elapsed since 0hrs, January first, 1970.
+#define DAYS_IN_4_YEARS		1461		// = ((365days * 4years) + 1leap-day)
+#define SECONDS_IN_A_DAY	86400		// = 60seconds * 60minutes * 24hours
+#define SECONDS_IN_AN_HOUR	3600		// = 60seconds * 60minutes
+#define SECONDS_IN_A_MINUTE	60
+#define OFFSET_SECONDS		360		// = 60seconds * 6minutes (one unit of "offset", a tenth of an hour)
+#define EPOCH_SECONDS_TO_2000	946684800	// = Seconds elapsed from epoch (midnight, Jan 1st, 1970) until midnight, Jan 1st, 2000.
+#define EPOCH_DAYS_TO_2000	10957		// = Days elapsed from epoch until Jan 1st, 2000.
+#define ISO_WEEKDAY(days)	((((days) + 3) % 7) + 1)	//ISO weekday (1=Monday) of a day counted from epoch (Jan 1st, 1970 was a Thursday).
+//Note, the following are used by calculate_epoch() which is passed a pointer to a time structure ("time").
+#define EPOCH_YEAR		(uint32_t) BCD_TO_BIN(time->year)			// 0-99		= Years since 2000.
+#define EPOCH_MONTH		(uint32_t) BCD_TO_BIN(time->month & RTC_MONTH)		// 1-12		= Months since start of current year.
+#define EPOCH_DAY		(uint32_t) BCD_TO_BIN(time->date)			// 1-31		= Days since start of current month.
+#define EPOCH_HOUR		(uint32_t) BCD_TO_BIN(time->hours)			// 0-23		= Hours since start of current day.
+#define EPOCH_MINUTE		(uint32_t) BCD_TO_BIN(time->minutes)			// 0-59		= Minutes since start of current hour.
+#define EPOCH_SECOND		(uint32_t) BCD_TO_BIN(time->seconds)			// 0-59		= Seconds since start of current minute.
+
+extern const uint16_t days_table[4][12] PROGMEM;	//Days from the start of a 4-year block to the start of each month (see calendar.c).
+
+//"offset" (defined in gps_clock.h) is the RTC's offset from UTC in units of OFFSET_SECONDS.
+extern int8_t offset;
+
+//Function declarations
+void next_second(rtc_time *time);		//Advance a time structure by one second (with carries up to the century).
+uint32_t calculate_epoch(const rtc_time *time);	//Calculate UNIX Epoch time (seconds elapsed since 1970.01.01.00.00.00) from a time structure.
+void epoch_to_time(uint32_t epoch, rtc_time *time);	//Fill a time structure from UNIX Epoch time (the inverse of calculate_epoch()).
+uint32_t local_to_utc(const rtc_time *time);	//UTC seconds since epoch of a local time (at the current offset).
+void utc_to_local(uint32_t utc, rtc_time *time);	//Fill a time structure with the local time of UTC seconds since epoch (the inverse of local_to_utc()).
+
+#endif
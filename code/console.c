@@ -0,0 +1,62 @@
+//Functions for the line-based command console on the USART.
+
+#include <console.h>
+
+static char console_line[CONSOLE_LINE_LENGTH + 1];	//Line being collected (or pending), null terminated once complete.
+static uint8_t console_length = 0;			//Characters collected so far.
+static uint8_t console_discard = 0;			//Set while the rest of a line is being ignored (NMEA sentence, too long, or a line is pending).
+static uint8_t console_pending = 0;			//Set once a complete line is waiting to be run.
+
+//Collect up to CONSOLE_BYTES_PER_POLL received bytes into the line buffer.  Returns the pending command line, or NULL if none is complete.
+//The line remains pending (and is returned again) until console_done() is called.  Lines received meanwhile are discarded, so bytes keep
+//being taken from the receive buffer and it can't overflow with GPS data while a command waits to be run.
+char *console_poll(void)
+{
+	for (uint8_t i = 0; (i < CONSOLE_BYTES_PER_POLL) && usart_byte_waiting(); i++)
+	{
+		char c = usart_receive_byte();
+
+		if ((c == '\r') || (c == '\n'))			//End of line.
+		{
+			if (!console_discard && console_length)
+			{
+				console_line[console_length] = '\0';
+				console_pending = 1;
+			}
+			console_length = 0;
+			console_discard = console_pending;	//Ignore further lines until this one has been run.
+		}
+		else if (!console_discard)
+		{
+			if (((c == '$') && !console_length) || (console_length >= CONSOLE_LINE_LENGTH))
+			{
+				console_discard = 1;		//A GPS sentence or too long for a command.
+			}
+			else
+			{
+				console_line[console_length++] = c;
+			}
+		}
+	}
+
+	return(console_pending ? console_line : NULL);
+}
+
+//Release the pending command line.  Collection restarts at the next line.
+void console_done(void)
+{
+	console_pending = 0;
+}
+
+//Convert a word to a number.  Decimal, or hex with a leading "0x".  Returns 0 if the word isn't entirely a number.
+uint8_t console_number(const char *word, int16_t *value)
+{
+	char *end;
+
+	if (!word || !*word)
+	{
+		return(0);
+	}
+	*value = strtol(word, &end, 0);
+	return(*end == '\0');
+}
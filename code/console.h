@@ -0,0 +1,22 @@
+//Definitions and declarations for the line-based command console on the USART.
+
+//The USART receives the GPS sentences as well as any commands, so lines starting with '$' (NMEA) are ignored.
+//Received bytes are collected into a fixed line buffer a few at a time, so polling never waits for the rest of a line.
+
+#ifndef CONSOLE_H
+#define CONSOLE_H
+
+#include <avr/io.h>
+#include <stdlib.h>		//Required for strtol().
+#include <usart.h>		//Commands are received through the USART receive buffer.
+
+#define CONSOLE_LINE_LENGTH	24	//Longest command line (characters).  Longer lines are discarded.
+#define CONSOLE_BYTES_PER_POLL	8	//Most received bytes handled by each call to console_poll().
+#define CONSOLE_REPLY_LENGTH	96	//Longest reply.  Commands should only be run when the transmit buffer has room for it.
+
+//Function declarations
+char *console_poll(void);					//Collect received bytes.  Returns the pending command line (NULL if none).
+void console_done(void);					//Release the pending command line so that the next can be collected.
+uint8_t console_number(const char *word, int16_t *value);	//Convert a decimal (or 0x hex) word to a number.  Returns 0 if it isn't one.
+
+#endif
@@ -0,0 +1,44 @@
+//Functions for the CPU cycle timebase.
+
+#include <cycles.h>
+
+static volatile uint16_t cycles_overflows = 0;	//Upper 16 bits of the cycle count.
+
+//Timer1 overflowed.
+ISR(TIMER1_OVF_vect)
+{
+	cycles_overflows++;
+}
+
+//Start Timer1 free-running at F_CPU (no prescaling) and enable the overflow interrupt.
+void cycles_init(void)
+{
+	TCCR1A = 0;			//Normal mode (count up to 0xFFFF then overflow to 0).
+	TCCR1B = (1 << CS10);		//No prescaling.
+	TIMSK1 |= (1 << TOIE1);
+}
+
+//Returns the 32-bit cycle count.
+//If Timer1 has overflowed but the ISR hasn't run yet (interrupts disabled, e.g. called from an ISR), the pending overflow is counted here
+//instead.  Only one overflow can be pending, so while interrupts are disabled for longer than 65536 cycles the count falls behind.
+uint32_t cycles_now(void)
+{
+	uint16_t count;
+	uint16_t overflows;
+
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		if (TIFR1 & (1 << TOV1))
+		{
+			TIFR1 = (1 << TOV1);				//Writing 1 clears the flag so the ISR won't count it again.
+			cycles_overflows++;
+		}
+		count = TCNT1;
+		overflows = cycles_overflows;
+		if ((TIFR1 & (1 << TOV1)) && (count < 0x8000))	//Overflowed since the flag was checked (counted by the next call or the ISR).
+		{
+			overflows++;
+		}
+	}
+	return(((uint32_t) overflows << 16) | count);
+}
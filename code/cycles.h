@@ -0,0 +1,18 @@
+//Definitions and declarations for the CPU cycle timebase.
+
+//Timer1 runs free at F_CPU and its overflows (every 65536 cycles, 8.2ms at 8MHz) are counted by an interrupt, extending it to a 32-bit count
+//of CPU cycles.  The count wraps every 537 seconds at 8MHz, which doesn't matter as only differences are used.
+//Used to measure the CPU clock against the RTC second (oscillator calibration) and by the cycle profiler.
+
+#ifndef CYCLES_H
+#define CYCLES_H
+
+#include <avr/io.h>
+#include <avr/interrupt.h>	//Required for the Timer1 overflow interrupt.
+#include <util/atomic.h>	//Required to use ATOMIC_BLOCK() so the count can't overflow while it is read.
+
+//Function declarations
+void cycles_init(void);		//Start Timer1 at F_CPU and enable the overflow count.
+uint32_t cycles_now(void);	//Returns the 32-bit cycle count.  Safe to call from an ISR.
+
+#endif
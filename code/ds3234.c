@@ -1,74 +1,97 @@
 //Functions used for communications and control with DS3234 RTC device
 //Note spi.h is required for functions and definitions.
+//Each access is an spi_transaction queued behind any display transactions.  The functions wait for their transaction to complete,
+//so buffers can live on the stack.  Interrupts are only disabled while a transaction is added to the queue.
 
 #include <ds3234.h>
 
-//Initialise the RTC (actually initialise the AVR to use SPI comms with the RTC).
+//Initialise the RTC: the AVR pins used for SPI comms and the square wave, then start the 1Hz square wave.
+//Note, the SPI bus must already be initialised.
 void rtc_init(void)
 {
-	SPI_DDR |= (1 << RTC_SS);	//Set slave select pin as an output.
-	SPI_PORT |= (1 << RTC_SS);	//Start SS off not selected (i.e. high as SS is inverted)
+	RTC_DDR |= (1 << RTC_SS);	//Set slave select pin as an output.
+	RTC_PORT |= (1 << RTC_SS);	//Start SS off not selected (i.e. high as SS is inverted)
+
+	RTC_SQW_DDR &= ~(1 << RTC_SQW);	//Square wave pin is an input...
+	RTC_SQW_PORT |= (1 << RTC_SQW);	//...with the pull-up enabled (!INT/SQW is open drain, and the pin doesn't float if it isn't wired).
+	rtc_write_byte(RTC_CR_WA, RTC_CR_SQW_1HZ);	//Output the 1Hz square wave that marks the start of each second.
 }
 
-//Reads and returns a byte at the provided address.
-uint8_t rtc_read_byte(uint8_t address)
+//Fill in a transaction that sends the register address followed by "length" data bytes.
+static void rtc_transaction(spi_transaction *transaction, uint8_t address, const uint8_t *tx, uint8_t *rx, uint8_t length)
 {
-	RTC_ENABLE;			//Enable the RTC comms
-	spi_trade_byte(address);	//Send the address to be read from
-	spi_trade_byte(0);		//Send dummy byte to load SPDR with byte at address
-	RTC_DISABLE;			//Disable the RTC comms
-	return(SPDR);			//Return the byte.  SPDR=SPI Data Register
+	transaction->device = SPI_DEVICE_RTC;
+	transaction->command = address;
+	transaction->tx = tx;
+	transaction->rx = rx;
+	transaction->length = length;
+	transaction->complete = NULL;
 }
 
-//Writes a byte to the desired address.
-void rtc_write_byte(uint8_t address, uint8_t data)
+//Send the register address then send and/or receive "length" bytes.  Returns once complete.
+void rtc_transfer(uint8_t address, const uint8_t *tx, uint8_t *rx, uint8_t length)
 {
-	RTC_ENABLE;			//Enable the RTC comms
-	spi_trade_byte(address);	//Send the address to be written to
-	spi_trade_byte(data);		//Send the data to be written to the provided address
-	RTC_DISABLE;			//Disable the RTC comms
+	spi_transaction transaction;
+
+	rtc_transaction(&transaction, address, tx, rx, length);
+	spi_submit(&transaction);
+	spi_wait(&transaction);
 }
 
-//Fill in all array fields from data in the RTC.  All bytes are BCD representations of data.
+//Fill in the time structure from the RTC.  The structure matches the layout of registers 0x00 to 0x06 so they are copied in a single burst.
+//The RTC register address auto-increments during a burst and the time is latched when the RTC is enabled, so all fields are consistent.
 //Note, the century indicator is a flag contained in the byte shared with the BCD encoded month value (RTC_MCR_RA: Month/Century Register Read Address).
 //Refer to the address map in the ds3234 datasheet.
-void rtc_get_time(uint8_t *time)
+void rtc_get_time(rtc_time *time)
 {
-	time[SEC_ONES] = (rtc_read_byte(RTC_SECR_RA) & 0b1111);		//B7=0, B6-B4=(10 seconds), B3-B0=(seconds)
-	time[SEC_TENS] = (rtc_read_byte(RTC_SECR_RA) >> 4);
-	time[MIN_ONES] = (rtc_read_byte(RTC_MINR_RA) & 0b1111);		//B7=0, B6-B4=(10 minutes), B3-B0=(minutes)
-	time[MIN_TENS] = (rtc_read_byte(RTC_MINR_RA) >> 4);
-	time[HOU_ONES] = (rtc_read_byte(RTC_HRR_RA) & 0b1111);		//B7-B6=0, B5=(20 hours), B4=(10 hours), B3-B0=(hours)
-	time[HOU_TENS] = (rtc_read_byte(RTC_HRR_RA) >> 4);
-	time[DAT_ONES] = (rtc_read_byte(RTC_DATER_RA) & 0b1111);	//B7-B6=0, B5-B4=(10 date), B3-B0=(date)
-	time[DAT_TENS] = (rtc_read_byte(RTC_DATER_RA) >> 4);
-	time[MON_ONES] = (rtc_read_byte(RTC_MCR_RA) & 0b1111);		//B7-B5=0, B4=(10 month), B3-B0=(month)
-	time[MON_TENS] = ((rtc_read_byte(RTC_MCR_RA) >> 4) & 0b111);	//	(Note need to ignore century bit).
-	time[YEA_ONES] = (rtc_read_byte(RTC_YRR_RA) & 0b1111);		//B7-B4=(10 year), B3-B0=(year)
-	time[YEA_TENS] = (rtc_read_byte(RTC_YRR_RA) >> 4);
-	if(rtc_read_byte(RTC_MCR_RA) & 0b10000000)			//B7= Century flag. Note, century is either 19 or 20, so if bit is clear, year is 19XX.
-	{
-		time[CEN_ONES] = 0;
-		time[CEN_TENS] = 2;
-	}
-	else
+	PROFILE_BEGIN(PROFILE_RTC_GET_TIME);
+	rtc_transfer(RTC_SECR_RA, NULL, (uint8_t *) time, sizeof(rtc_time));	//Burst from the seconds register.  Address auto-increments.
+	PROFILE_END(PROFILE_RTC_GET_TIME);
+}
+
+//This function will write the time structure to the RTC effectively setting the clock.  Registers are written in a single burst.
+//Note, the day of week register is written unchanged from the structure (not used by this application).
+//Refer to the address map in the ds3234 datasheet.
+void rtc_set_time(rtc_time *time)
+{
+	time->month |= RTC_CENTURY;			//The century flag is always set to indicate year 20xx.
+
+	rtc_transfer(RTC_SECR_WA, (uint8_t *) time, NULL, sizeof(rtc_time));	//Burst to the seconds register.  Address auto-increments.
+	rtc_write_byte(RTC_CsR_WA, rtc_read_byte(RTC_CSR_RA) & ~(1 << RTC_OSF));	//The time is now good, so clear the oscillator stop flag.
+}
+
+//The oscillator stop flag is set at first power-up and whenever the oscillator stops (e.g. both supplies lost).  It is cleared when the
+//clock is set, so while it is clear the date and time held by the RTC can be trusted.
+uint8_t rtc_valid(void)
+{
+	return(!(rtc_read_byte(RTC_CSR_RA) & (1 << RTC_OSF)));
+}
+
+//Set the SRAM address then burst the SRAM data register.  Both transactions are queued together so that nothing else on the bus
+//(e.g. a sync log update from an ISR) can move the SRAM address in between.
+static void rtc_sram_transfer(uint8_t address, uint8_t data_register, const uint8_t *tx, uint8_t *rx, uint8_t length)
+{
+	spi_transaction set_address, burst;
+
+	rtc_transaction(&set_address, RTC_SRAMAR_WA, &address, NULL, 1);
+	rtc_transaction(&burst, data_register, tx, rx, length);	//Register address does not increment while bursting, SRAM address does.
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
 	{
-		time[CEN_ONES] = 9;
-		time[CEN_TENS] = 1;
+		spi_submit(&set_address);
+		spi_submit(&burst);
 	}
-
+	spi_wait(&burst);
 }
 
-//This function will take the current values of the time array, convert to equivalent BCD encoded values and write to the RTC effectively setting the clock.
-//Refer to the address map in the ds3234 datasheet.
-void rtc_set_time(uint8_t *time)
+//The DS3234 has 256 bytes of battery-backed SRAM accessed indirectly via the SRAM address and SRAM data registers.
+//The SRAM address is automatically incremented after each access of the data register, so a block is read in a single burst.
+void rtc_sram_read(uint8_t address, uint8_t *data, uint8_t length)
 {
-	rtc_write_byte(RTC_SECR_WA,	((time[SEC_TENS] << 4) | time[SEC_ONES]));			//Set the RTC seconds (00-59).
-	rtc_write_byte(RTC_MINR_WA,	((time[MIN_TENS] << 4) | time[MIN_ONES]));			//Set the RTC minutes (00-59).
-	rtc_write_byte(RTC_HRR_WA,	((time[HOU_TENS] << 4) | time[HOU_ONES]));			//Set the RTC hours (00-24).
-	rtc_write_byte(RTC_DATER_WA,	((time[DAT_TENS] << 4) | time[DAT_ONES]));			//Set the RTC date (01-31).
-	rtc_write_byte(RTC_MCR_WA,	(((time[MON_TENS] << 4) | time[MON_ONES])) | (0b10000000));	//Set the RTC month and century (01-12 & 19/20).
-	rtc_write_byte(RTC_YRR_WA,	((time[YEA_TENS] << 4) | time[YEA_ONES]));			//Set the RTC year (00-99).
+	rtc_sram_transfer(address, RTC_SRAMDR_RA, NULL, data, length);
+}
 
-	//Note the century flag at address RTC_MCR_WA is always set to indicate year 20xx.
+//Burst write a block of data to the battery-backed SRAM.
+void rtc_sram_write(uint8_t address, uint8_t *data, uint8_t length)
+{
+	rtc_sram_transfer(address, RTC_SRAMDR_WA, data, NULL, length);
 }
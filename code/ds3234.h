@@ -1,16 +1,11 @@
 //Definitions and declarations used for spi communications and control with DS3234 RTC device.
 
-#include <avr/io.h>
-#include <spi.h>
-
-//Definitions for use by SPI.c functions
-#define RTC_SS		PB2	//RTC SPI Slave Select Pin = Port B Pin 2
-#define RTC_POL 	1	//RTC SPI Polarity = 1 (clock idles high) (DS2334 works in mode 1 or 3)
-#define RTC_PHA 	1	//RTC SPI Phase = 1 (DS2334 works in mode 1 or 3)
+#ifndef DS3234_H
+#define DS3234_H
 
-//Macros used to trigger SPI comms (SPI_PORT defined in spi.h)
-#define RTC_ENABLE 	SPI_PORT &= ~(1<<RTC_SS)	//Command to enable the RTC via the slave select pin.
-#define RTC_DISABLE 	SPI_PORT |= (1<<RTC_SS)		//Command to disable the RTC via the slave select pin.
+#include <avr/io.h>
+#include <spi.h>	//Also includes board.h which defines the RTC slave select pin, SPI mode and clock rate.
+#include <profile.h>	//For the cycle profiler probes (empty unless PROFILE is defined).
 
 //Device register addresses - copied from datasheet, not all used in this application.
 #define RTC_CR_RA	0x0E	//RTC Control Register Read Address
@@ -71,6 +66,10 @@
 #define RTC_A2IE	1	//RTC Alarm 2 Interrupt Enable
 #define RTC_A1IE	0	//RTC Alarm 1 Interrupt Enable
 
+//Control Register value that outputs a 1Hz square wave on !INT/SQW (INTCN=0, RS2:RS1=00) with the oscillator running and the alarms disabled.
+//The DS3234 drives the square wave low as the seconds register increments.
+#define RTC_CR_SQW_1HZ	0x00
+
 //Control/Status Register Bits (Initialised to 0b11001000)
 #define RTC_OSF		7	//RTC Oscillator Stop Flag - 1=Oscillator has stopped
 #define RTC_BB32KHZ	6	//RTC Battery-Backed 32kHz Output - 1=Enabled, 0=Low
@@ -81,22 +80,28 @@
 #define RTC_A2F		1	//RTC Alarm 2 Flag
 #define RTC_A1F		0	//RTC Alarm 1 Flag
 
-//Define array elements for easier identification when pulled from time array.
-#define CEN_TENS 0
-#define CEN_ONES 1
-#define YEA_TENS 2
-#define YEA_ONES 3
-#define MON_TENS 4
-#define MON_ONES 5
-#define DAT_TENS 6
-#define DAT_ONES 7
-#define HOU_TENS 8
-#define HOU_ONES 9
-#define MIN_TENS 10
-#define MIN_ONES 11
-#define SEC_TENS 12
-#define SEC_ONES 13
-#define SIZE_OF_TIME_ARRAY 14
+//Month/Century Register Bits
+#define RTC_CENTURY	0b10000000	//RTC Century flag - 1=20xx, 0=19xx
+#define RTC_MONTH	0b00011111	//RTC Month (BCD) mask
+
+//Conversions between packed binary-coded decimal (BCD) and binary values.
+#define BCD_TO_BIN(bcd)	((((bcd) >> 4) * 10) + ((bcd) & 0x0F))
+#define BIN_TO_BCD(bin)	((((bin) / 10) << 4) | ((bin) % 10))
+#define BCD_INCREMENT(bcd)	((((bcd) & 0x0F) == 9) ? ((bcd) + 7) : ((bcd) + 1))	//Add one, carrying 9 into the tens digit.
+
+//Date and time in packed BCD (two decimal digits per byte, tens in the upper nibble).
+//Laid out exactly as the DS3234 time-keeping registers 0x00 to 0x06 so that reading or writing the RTC is a straight burst copy.
+//Digits are only separated into nibbles when they are needed for display.
+typedef struct
+{
+	uint8_t seconds;	//0x00: B7=0, B6-B4=(10 seconds), B3-B0=(seconds)		00-59
+	uint8_t minutes;	//0x01: B7=0, B6-B4=(10 minutes), B3-B0=(minutes)		00-59
+	uint8_t hours;		//0x02: B7-B6=0, B5=(20 hours), B4=(10 hours), B3-B0=(hours)	00-23
+	uint8_t day;		//0x03: B7-B3=0, B2-B0=(day of week)				1-7 (not used by this application)
+	uint8_t date;		//0x04: B7-B6=0, B5-B4=(10 date), B3-B0=(date)			01-31
+	uint8_t month;		//0x05: B7=(century), B6-B5=0, B4=(10 month), B3-B0=(month)	01-12
+	uint8_t year;		//0x06: B7-B4=(10 year), B3-B0=(year)				00-99
+} rtc_time;
 
 //Define numerical values for each month
 #define JAN  1
@@ -113,8 +118,27 @@
 #define DEC 12
 
 //Function declarations
-void rtc_init(void);					//Initialise the RTC (actually initialise the AVR to use SPI comms with the RTC).
-uint8_t rtc_read_byte(uint8_t address);			//Reads and returns a byte at the desired address.
-void rtc_write_byte(uint8_t address, uint8_t data);	//Writes a byte to the desired address.
-void rtc_get_time(uint8_t *time);			//Fill in all array fields from data in the RTC.  All bytes are BCD representations of data..
-void rtc_set_time(uint8_t *time);			//Set the clock to the time as per the current values in the "time" array.
+void rtc_init(void);					//Initialise the AVR pins used by the RTC and start the 1Hz square wave.
+void rtc_transfer(uint8_t address, const uint8_t *tx, uint8_t *rx, uint8_t length);	//Send the address then send and/or receive "length" bytes.
+void rtc_get_time(rtc_time *time);			//Burst read the time-keeping registers into the (packed BCD) time structure.
+void rtc_set_time(rtc_time *time);			//Burst write the (packed BCD) time structure to the time-keeping registers, setting the clock.
+uint8_t rtc_valid(void);				//Returns 0 if the oscillator has stopped (time and date lost) since the clock was last set.
+void rtc_sram_read(uint8_t address, uint8_t *data, uint8_t length);	//Burst read "length" bytes from the battery-backed SRAM starting at "address".
+void rtc_sram_write(uint8_t address, uint8_t *data, uint8_t length);	//Burst write "length" bytes to the battery-backed SRAM starting at "address".
+
+//Reads and returns a byte at the desired address.
+static inline uint8_t rtc_read_byte(uint8_t address)
+{
+	uint8_t data;
+
+	rtc_transfer(address, NULL, &data, 1);	//Send the address then a dummy byte to load SPDR with byte at address.
+	return(data);				//Return the byte.
+}
+
+//Writes a byte to the desired address.
+static inline void rtc_write_byte(uint8_t address, uint8_t data)
+{
+	rtc_transfer(address, &data, NULL, 1);	//Send the address then the data to be written to it.
+}
+
+#endif
@@ -1,50 +1,60 @@
 #include "gps_clock.h"
 
+//The RTC square wave falls as the RTC seconds register increments.  Commit the frame that poll() pre-rendered for this second.
+ISR(RTC_SQW_VECTOR)
+{
+	uint32_t now = cycles_now();	//Start of the second, measured in CPU cycles (for the oscillator calibration and the fraction of a second).
+
+	PROFILE_BEGIN(PROFILE_TICK_COMMIT);
+	tick_period = now - tick_cycles;
+	tick_cycles = now;
+	sev_seg_commit();	//Queue the staged LOAD cycles (bus is idle while a frame is staged, so the first starts immediately).
+	PROFILE_END(PROFILE_TICK_COMMIT);
+	nmea_commit();		//Queue the staged time sentence (if any).
+	display_tick++;		//Tell poll() the staged frame has been committed.
+}
+
 //The following interrupt sub-routine will be triggered every time there is a change in state of either button.
 ISR(BUTTON_PCI_VECTOR)
 {
-	cli();	//Disable interrupts until this ISR is complete.
-
+	//Note, interrupts are disabled by hardware on entry and re-enabled by reti on exit, so no cli()/sei() here.
+	//A sei() at the end of the ISR would re-enable interrupts before reti and allow this ISR to nest on a pending button interrupt.
 	_delay_ms(BUTTON_DEBOUNCE_DURATION);	//wait for DEBOUNCE_DURATION milliseconds to mitigate effect of switch bounce.
+	PROFILE_BEGIN(PROFILE_BUTTON_ISR);	//Measured after the debounce delay (see profile.h).
+	calibration_restart = TRUE;		//A tick may have been held off by this ISR.
 	//If statement captures press of the "Mode" button.  Cycles through the various display modes.
+	//The new mode is displayed by poll() (running in main) once this ISR returns.
 	if(!(BUTTON_PINS & (1 << BUTTON_MODE)))
 	{
-		sev_seg_power(OFF);			//Blank the display while settings are changed.
-		sev_seg_decode_mode(DECODE_CODE_B);	//Whenever the mode is changed, return all digits to default Code B decode mode.
-		sev_seg_all_clear();			//Clear all digits to avoid artifacts between display modes.
-		sev_seg_power(ON);			//Reactivate display now that settings are changed.
-
-		mode++;					//Increment the mode.
-		if(mode > MODE_5_INTENSITY)		//If largest mode value reached.
-		{
-			mode = MODE_1A_ISO;		//Cycle back to first mode.
-		}
-
-		while(BUTTON_PINS & (1 << BUTTON_MODE))	//Keep refreshing the display until the button is released.
+		do
 		{
-			rtc_get_time(time);		//Update the current time from the rtc.
-			poll();				//Display the current time/mode.
-		}
+			mode++;				//Increment the mode.
+			if(mode >= MODE_COUNT)		//If largest mode value reached.
+			{
+				mode = MODE_1A_ISO;	//Cycle back to first mode.
+			}
+		} while (!mode_available(mode));	//Skip modes this board can't show.
 	}
 
-	//If statement captures press of the "Sync" button.  Initiates at attempt at syncing RTC clock to GPS data.
+	//If statement captures press of the "Sync" button.  Requests an attempt at syncing RTC clock to GPS data.
 	if(!(BUTTON_PINS & (1 << BUTTON_SYNC)))
 	{
-		if (mode == MODE_4_OFFSET)		//If mode 4 is running, the Sync button cycles the UTC offset.
-		{
-			cycle_offset();			//Cycle the UTC offset value (-11.5hrs to +12.0hrs).
-		}
-		else if (mode == MODE_5_INTENSITY)	//If mode 5 is running, the sync button cycles the intensity value (brightness).
-		{
-			cycle_intensity();		//Cycle the intensity value that corresponds to display brightness.
-		}
-		else					//All other modes, the Sync button attempts to sync the clock.
+		switch (pgm_read_byte(&mode_table[mode].value))	//The Sync button adjusts the value displayed by the current mode.
 		{
-			attempt_sync();			//Attempt to sync the RTC time with GPS data.
+			case (VALUE_ZONE) :		//Cycle the time zone (fixed offsets then zones with daylight saving).
+				cycle_zone();
+			break;
+
+			case (VALUE_INTENSITY) :	//Cycle the intensity value that corresponds to display brightness.
+				cycle_intensity();
+			break;
+
+			default :			//All other modes, the Sync button syncs the clock.
+				sync_requested = TRUE;	//Run by poll(), as a sync waits for the GPS for seconds and must not hold interrupts off.
+			break;
 		}
 	}
-
-	sei();	//Re-enable interrupts.
+	PROFILE_END(PROFILE_BUTTON_ISR);
 }
 
 //Initialise the peripherals.
@@ -54,11 +64,20 @@ void hardware_init(void)
 	power_adc_disable();			//Since it's not needed, disable the ADC and save a bit of power.
 
 	usart_init();				//Initialise the USART to enable serial communications.
-	spi_init(SEV_SEG_POL, SEV_SEG_PHA);	//Initialise the SPI to enable comms with SPI devices.
-						//Note, both spi devices (RTC and max7219) operate in spi mode 3, so spi_init only needs to be called once.
+	spi_init();				//Initialise the SPI to enable comms with SPI devices.
+						//Note, the clock rate and mode are switched per device (RTC and max7219) by the spi transaction queue.
+
+	sev_seg_init();				//Initialise the cascaded max7219 chips that will drive the 7-segment digits (spi comms).
+	rtc_init();				//Initialise the hardware for spi comms with the DS3234 RTC and start its 1Hz square wave.
 
-	sev_seg_init();				//Initialise the two cascaded max7219 chips that will drive the 16 7-segment digits (spi comms).
-	rtc_init();				//Initialise the hardware for spi comms with the DS3234 RTC.
+#if RTC_SQW_WIRED
+	EICRA |= RTC_SQW_EDGE;			//Interrupt at the start of each second (falling edge of the RTC square wave).
+	EIMSK |= (1 << RTC_SQW_INT);		//Enable the square wave (tick) interrupt.
+#endif
+
+	cycles_init();				//Timer1 free-running at F_CPU (no prescaling).  Used to count the cycles taken to render a frame.
+	PROFILE_INIT();				//Count Timer1 overflows for the cycle profiler (if compiled in).
+	watchdog_init();			//Reset the AVR if the main loop or the display stops checking in (see watchdog.h).
 
 	//Disabled the following setting of PCICR until macro "BUTTONS_ENABLED" is called thus disabling buttons during start-up until after first sync attempt.
 	//PCICR |= (1 << BUTTON_PCIE);		//Enable Pin-Change Interrupt for pin-change int pins PCINT[8-14].  This includes both buttons.
@@ -72,239 +91,789 @@ void hardware_init(void)
 	sei();					//Global enable interrups (requires avr/interrupt.h).
 }
 
-//Initialise (validate and set) settings that are stored in eeprom.
+//Load the settings stored in eeprom, validate and apply them.
+//All slots are read with a single eeprom_read_block() and the valid slot with the newest sequence number is kept in RAM.
 void settings_init(void)
 {
-	validate_eeprom_offset();					//Confirm the UTC time offset value stored in eeprom is valid.
-	offset = (int8_t) eeprom_read_byte(OFFSET_EEPROM_ADDRESS);	//set the "offset" variable to what is stored in eeprom.
+	settings_block slots[SETTINGS_SLOTS];	//Temporary copy of all slots.
+	uint8_t found = FALSE;			//Set once a valid slot has been found.
+
+	eeprom_read_block(slots, SETTINGS_EEPROM_ADDRESS, sizeof(slots));
+
+	for (uint8_t i = 0; i < SETTINGS_SLOTS; i++)
+	{
+		if ((slots[i].crc == settings_crc(&slots[i], offsetof(settings_block, crc))) && (slots[i].version == SETTINGS_VERSION))	//If the slot is valid...
+		{
+			//Keep the slot if it's the first valid one found or if its sequence is newer (signed difference allows for the sequence rolling over).
+			if (!found || ((int8_t) (slots[i].sequence - settings.sequence) > 0))
+			{
+				settings = slots[i];
+				settings_slot = i;
+				found = TRUE;
+			}
+		}
+	}
+
+	if (!found)			//On a new chip (eeprom defaulted to 0xFF) or after a layout change, no slot will be valid.
+	{
+		settings_default();
+	}
+	settings_validate();
+
+	offset = settings.offset;	//Initialise the global "offset" variable.
+	zone = settings.zone;		//Initialise the global "zone" variable.
+	intensity = settings.intensity;	//Initialise the global "intensity" variable.
+	mode = settings.mode;		//Initialise the global "mode" variable.
+
+	if (!found)			//Save the defaults so they will be found next time.
+	{
+		settings_save();
+	}
 
-	validate_eeprom_intensity();					//Confirm the intensity (brightness) value stored in eeprom is valid.
-	intensity = eeprom_read_byte(INTENSITY_EEPROM_ADDRESS);		//Initialise the global "intensity" variable to value in eeprom.
 	sev_seg_set_intensity(intensity);				//Set the display intensity accordingly.
+
+	if (settings.calibration != SETTINGS_UNCALIBRATED)		//If the internal RC oscillator has been calibrated...
+	{
+		OSCCAL = settings.calibration;				//Apply the calibration.
+	}
+
+	if (settings.baud != (BAUD / 100))				//If the baud rate differs from the compiled default...
+	{
+		usart_set_baud(settings.baud * 100UL);			//Apply the stored baud rate.
+	}
 }
 
-//This function validates the GMT time offset value saved in eeprom.
-//The offset is stored in eeprom so it is retained when power is lost (also when AVR is reprogrammed provided the save_eeprom fuse is set).
-//This if statement will ensure it is a valid value (multiple of 5 from -120 to 120).
-//If the value is invalid, set it to 0.  On a new chip eeprom memory would be defaulted to 0xFF.
-//Have to typecast byte as a signed int as only unsigned integers are stored in eeprom.
-void validate_eeprom_offset(void)
+//Set the default settings.  If settings were stored by earlier firmware (a version 1 settings block, or before that one byte each at fixed
+//addresses), import them.  Note, the legacy values are validated by settings_validate() as they will be 0xFF on a new chip.
+void settings_default(void)
 {
-	if
-	(
-		((int8_t)eeprom_read_byte(OFFSET_EEPROM_ADDRESS) % 5) ||		//Returns true if there is a remainder after dividing by 5, OR
-		((int8_t)eeprom_read_byte(OFFSET_EEPROM_ADDRESS) > 120) ||		//Returns true if the value is larger than 120, OR
-		((int8_t)eeprom_read_byte(OFFSET_EEPROM_ADDRESS) < -120)		//Returns true if the value is less than -120.
-	)
+	if (!settings_import())
 	{
-		eeprom_update_byte((uint8_t *) OFFSET_EEPROM_ADDRESS, 0);	//set the offset value stored in eeprom to 0.
+		settings.offset = (int8_t) eeprom_read_byte(LEGACY_OFFSET_EEPROM_ADDRESS);
+		settings.intensity = eeprom_read_byte(LEGACY_INTENSITY_EEPROM_ADDRESS);
+		settings.mode = DEFAULT_MODE;
+		settings.baud = BAUD / 100;
+		settings.calibration = SETTINGS_UNCALIBRATED;
 	}
+	settings.sequence = 0;
+	settings.version = SETTINGS_VERSION;
+	settings.zone = ZONE_COUNT;		//Not valid, so settings_validate() selects the fixed offset zone for the offset.
+	settings_slot = SETTINGS_SLOTS - 1;	//So that the first save is to slot 0.
 }
 
-//This function validates the intensity (brightness) value saved in eeprom.
-//The intensity is stored in eeprom so it is retained when power is lost (also when AVR is reprogrammed provided the save_eeprom fuse is set).
-//This if statement will ensure it is a valid value (integer range 0 to 15 inclusive).
-//If the value is invalid, set it to 8.  On a new chip eeprom memory would be defaulted to 0xFF.
-void validate_eeprom_intensity(void)
+//Import the newest valid version 1 settings block.  The slots are a different size to the current block, so each is read on its own.
+uint8_t settings_import(void)
 {
-	if (eeprom_read_byte(INTENSITY_EEPROM_ADDRESS) > 15)		//Returns true if the value is greaterss than 15.
+	settings_block_v1 slot;
+	uint8_t found = FALSE;
+
+	for (uint8_t i = 0; i < SETTINGS_SLOTS; i++)
 	{
-		eeprom_update_byte((uint8_t *) INTENSITY_EEPROM_ADDRESS, 8);	//set the offset value stored in eeprom to 8.
+		eeprom_read_block(&slot, (settings_block_v1 *) SETTINGS_EEPROM_ADDRESS + i, sizeof(slot));
+		if ((slot.crc == settings_crc(&slot, offsetof(settings_block_v1, crc))) && (slot.version == SETTINGS_VERSION_1) &&
+			(!found || ((int8_t) (slot.sequence - settings.sequence) > 0)))
+		{
+			settings.sequence = slot.sequence;
+			settings.offset = slot.offset;
+			settings.intensity = slot.intensity;
+			settings.mode = slot.mode;
+			settings.baud = slot.baud;
+			settings.calibration = slot.calibration;
+			found = TRUE;
+		}
 	}
+	return(found);
 }
 
-//This function will call other functions depending on the currently selected display mode.
-void poll(void)
+//Confirm each setting is valid.  The CRC protects against corruption, but not against a valid block saved with bad values.
+void settings_validate(void)
 {
-	switch (mode)	//Thhis switch is used to setup the display depending on which mode is selected.
+	//The offset must be a multiple of 5 from -120 to 120.  If not, set it to the default (0).
+	if ((settings.offset % 5) || (settings.offset > 120) || (settings.offset < -120))
 	{
-		//Modes 1A, 1B, 2A and 2B are all variations on the ISO-8601 date/time display.
-		case (MODE_1A_ISO) :		//	|Y Y Y Y M M D D     H H M M S S |
-		case (MODE_1B_ISO) :		//	|Y Y Y Y.M M.D D.    H H.M M.S S.|
-		case (MODE_2A_ISO) :		//	|  Y Y Y Y M M D D H H M M S S   |
-		case (MODE_2B_ISO) :		//	|  Y Y Y Y.M M.D D.H H.M M.S S.  |
-			display_iso_time();
-		break;
+		settings.offset = DEFAULT_OFFSET;
+	}
 
-		//Mode 3 displays Epoch time (unix time) which is the number of seconds since midnight, January first, 1970 (i.e. 19700101000000).
-		case (MODE_3_EPOCH) :		//	|E P O C H - S S S S S S S S S S |
-			display_epoch_time();
-		break;
+	//The zone must be one of the compiled zones.  If not (e.g. imported settings), select the fixed offset zone matching the offset.
+	if (settings.zone >= ZONE_COUNT)
+	{
+		settings.zone = ZONE_FROM_OFFSET(settings.offset);
+	}
 
-		//Mode 4 allows setting the UTC time offset (-11.5hrs to +12.0hrs).
-		case (MODE_4_OFFSET) :		//	|O F F S E t             ± # #.# |
-			get_offset();
-		break;
+	//The intensity must be an integer from 0 to 15 inclusive.  If not, set it to the default (8).
+	if (settings.intensity > 15)
+	{
+		settings.intensity = DEFAULT_INTENSITY;
+	}
 
-		//Mode 5 allows setting the LED brightness level for all digits (level 0 to 10).
-		case (MODE_5_INTENSITY) :	//	|I n t E n S I t y           # # |
-			get_intensity();
-		break;
+	//Only the time display modes can be selected at boot.
+	if (!mode_available(settings.mode) || !(pgm_read_byte(&mode_table[settings.mode].flags) & MODE_RESTORE))
+	{
+		settings.mode = DEFAULT_MODE;
+	}
+
+	//The baud rate must be non-zero (used as a divisor).
+	if (!settings.baud)
+	{
+		settings.baud = BAUD / 100;
 	}
 }
 
-//Display the time in a standard ISO-8601 format.
-void display_iso_time(void)
+//Save the current settings to eeprom.  Each save goes to the next slot (wear-levelling) with an incremented sequence number.
+//eeprom_update_block() only writes bytes that differ, further reducing wear.
+void settings_save(void)
 {
-	uint8_t date_offset = 0;	//This offset will determine which digit the date will start at.
-	uint8_t time_offset = 0;	//This offset will determine how many digits after the date that the time will start.
-	uint8_t delimiters = 0;		//This flag will be used to activate the decimal point if the current mode requires it.
-	uint8_t current_mode = mode;	//This variable will be used to check for mode change that will exit the while loop.
-	uint8_t i;			//General use integer for running for loops.
-
-	//Initialise array "buffer" which will consist of 16 data void settings_init(void)bytes that will be sent to the seven-segment display drivers.
-	//I.e. each element is the data to be used for each of the 16 7-seg digits.
-	uint8_t buffer[16];		//buffer[0] = digit 0	<--Least-Significant Digit (Right)
-					//buffer[1] = digit 1
-					//buffer[2] = digit 2
-					//	...	 =  ...
-					//buffer[14] = digit 14
-					//buffer[15] = digit 15	<--Least-Significant Digit (Right)
+	settings.offset = offset;
+	settings.zone = zone;
+	settings.intensity = intensity;
+	if (pgm_read_byte(&mode_table[mode].flags) & MODE_RESTORE)	//Only the time display modes are saved.
+	{
+		settings.mode = mode;
+	}
+	settings.sequence++;
+	settings.crc = settings_crc(&settings, offsetof(settings_block, crc));
 
-	//This switch used to set the positions of the date and time within the 16-digit display.
-	switch (mode)
+	settings_slot++;
+	if (settings_slot >= SETTINGS_SLOTS)
 	{
-		case (MODE_1A_ISO) :
-		case (MODE_1B_ISO) :
-			date_offset = 0;	//Start date display at the first digit (digit 0).
-			time_offset = 2;	//Leave two digits blank after the date and before the time.
-		break;
+		settings_slot = 0;
+	}
 
-		case (MODE_2A_ISO) :
-		case (MODE_2B_ISO) :
-			date_offset = 1;	//Start date display at the second digit (digit 1).
-			time_offset = 0;	//Start time display immediately after date display.
-		break;
+	eeprom_update_block(&settings, SETTINGS_EEPROM_ADDRESS + settings_slot, sizeof(settings));
+}
+
+//Calculate the CRC-8 (CCITT) of a settings block (the "length" bytes preceding the crc, which differs between versions).
+uint8_t settings_crc(const void *block, uint8_t length)
+{
+	const uint8_t *bytes = block;
+	uint8_t crc = 0;
+
+	for (uint8_t i = 0; i < length; i++)
+	{
+		crc = _crc8_ccitt_update(crc, bytes[i]);
 	}
+	return(crc);
+}
+
+//Restore the state saved by warm_save() if the AVR was reset by the watchdog and the state is intact.
+//After any other reset (power-on, brown-out or the reset pin) the state is started afresh.  Returns TRUE if the state was restored.
+uint8_t warm_restore(void)
+{
+	uint8_t restored = FALSE;
 
-	//This switch used to determine whether or not delimiters are to be used (decimal point between time/date components).
-	switch (mode)
+	if (!(watchdog_reset_cause & WATCHDOG_RESET))
 	{
-		case (MODE_1A_ISO) :
-		case (MODE_2A_ISO) :
-			delimiters = 0;		//Do NOT show decimal points between years, months, DATs, hours, mionutes, seconds.
-		break;
+		warm.resets = 0;
+	}
+	else if ((warm.magic != WARM_MAGIC) || (warm.crc != settings_crc(&warm, offsetof(warm_state, crc))))
+	{
+		warm.resets = 1;			//Watchdog reset before the state was first saved (e.g. during start-up).
+	}
+	else
+	{
+		if (warm.resets < 0xFF)
+		{
+			warm.resets++;
+		}
+		if (mode_available(warm.mode))
+		{
+			mode = warm.mode;
+		}
+		nmea_output = warm.nmea_output;
+		sync_outcome = warm.sync_outcome;
+		//The scheduler and wake-up values are clamped to their limits, as a CRC-8 can't rule out every corrupted value.
+		resync_interval = clamp_uint16(warm.resync_interval, RESYNC_INTERVAL_MIN, RESYNC_INTERVAL_MAX);
+		resync_minutes = clamp_uint16(warm.resync_minutes, 0, resync_interval);
+		resync_error = warm.resync_error;
+		drift = warm.drift;
+		resync_set = warm.resync_set;
+		resync_aligned = warm.resync_aligned;
+		gps_latency = warm.gps_latency;
+		telemetry_sequence = warm.telemetry_sequence;
+		telemetry_dropped = warm.telemetry_dropped;
+		gps_wake_lead = clamp_uint16(warm.gps_wake_lead, GPS_WAKE_LEAD_MIN, GPS_WAKE_LEAD_MAX);
+		gps_ttff = clamp_uint16(warm.gps_ttff, 0, GPS_WAKE_LEAD_MAX);
+		restored = TRUE;
+	}
 
-		case (MODE_1B_ISO) :
-		case (MODE_2B_ISO) :
-			delimiters = SEV_SEG_DP;//DO show decimal points between years, months, DATs, hours, mionutes, seconds.
-		break;
+	warm_save();
+	return(restored);
+}
+
+//Save the state needed for a warm restart.  Cheap enough (a few copies and a CRC-8 of 30 bytes) to run once a second.
+void warm_save(void)
+{
+	warm.magic = WARM_MAGIC;
+	warm.mode = mode;
+	warm.nmea_output = nmea_output;
+	warm.sync_outcome = sync_outcome;
+	warm.resync_interval = resync_interval;
+	warm.resync_minutes = resync_minutes;
+	warm.resync_error = resync_error;
+	warm.drift = drift;
+	warm.resync_set = resync_set;
+	warm.resync_aligned = resync_aligned;
+	warm.gps_latency = gps_latency;
+	warm.telemetry_sequence = telemetry_sequence;
+	warm.telemetry_dropped = telemetry_dropped;
+	warm.gps_wake_lead = gps_wake_lead;
+	warm.gps_ttff = gps_ttff;
+	warm.crc = settings_crc(&warm, offsetof(warm_state, crc));
+}
+
+//Transmit the cause of the last reset (MCUSR bits, see watchdog.h) and the number of watchdog resets since any other kind of reset.
+void warm_print(void)
+{
+	usart_print_string("reset=0x");
+	usart_print_hex(watchdog_reset_cause);
+	usart_print_string(" watchdog_resets=");
+	usart_print_uint(warm.resets);
+}
+
+//Run the currently selected display mode (as described by its row of mode_table) until the mode changes.
+//The decode mode and the static digits (text and blanks) are sent once on entry, or again if something else has used the display.
+//Time modes pre-render the next second's frame during the current second and stage the LOAD cycles for the digit rows that will change.
+//The RTC square wave interrupt commits them at the start of the second, so the display changes a fixed time after the RTC rather than
+//whenever this loop next happens to read it.  The bus is left idle while waiting so nothing can be queued ahead of the commit.
+//If no tick arrives (or RTC_SQW_WIRED is 0) the time is read and rendered as soon as the RTC seconds change instead.
+void poll(void)
+{
+	mode_layout layout;			//RAM copy of the current mode's row of mode_table.
+	uint8_t image[SEV_SEG_DIGITS];		//Static digits of the mode: pseudo-text (manual decode) then blanks (code B).
+	uint8_t shown[SEV_SEG_DIGITS];		//Digits currently on the display.
+	uint8_t buffer[SEV_SEG_DIGITS];		//Static digits plus the rendered date/time/value.  buffer[0] is the left-most digit.
+	rtc_time next;				//Time of the next second (that the staged frame is rendered for).
+	uint8_t current_mode = mode;		//This variable will be used to check for mode change that will exit the while loop.
+	uint8_t last_second = 0xFF;		//RTC seconds (BCD) currently displayed.  0xFF is never valid, so forces a render.
+	uint8_t ticks = RTC_SQW_WIRED;		//Cleared if the RTC square wave interrupt isn't seen.
+	uint8_t staged = FALSE;			//Set while a pre-rendered frame is waiting for the tick.
+	uint8_t tick = 0;			//Value of display_tick before the staged frame was rendered.
+	uint16_t wait = 0;			//Time spent waiting for the tick (units of TICK_WAIT_US).
+
+	memcpy_P(&layout, &mode_table[current_mode], sizeof(layout));
+
+	if ((layout.flags & MODE_RESTORE) && (current_mode != settings.mode))	//If a different time display mode has been selected...
+	{
+		settings_save();						//Save it so that it is restored at boot.
 	}
+	warm_save();								//A warm restart returns to this mode.
 
-	//This loop will initialise all 16 elements in the buffer array to represent a blank digit.
-	for (i = 0; i < 16; i++)
+	for (uint8_t i = 0; i < SEV_SEG_DIGITS; i++)
 	{
-		buffer[i] = SEV_SEG_CODEB_BLANK;
+		image[i] = (i < layout.text_length) ? pgm_read_byte(&layout.text[i]) : SEV_SEG_CODEB_BLANK;
 	}
 
-	//All static date required to display in accordance with the selected mode is set,
-	//so enter a loop that will continuously update the dynamic data and refresh the display.
+	display_refresh = TRUE;
 	while (mode == current_mode)	//This loop will exit when the mode changes.
 	{
-		rtc_get_time(time);		//Update the current time from the rtc.
+		watchdog_checkin(WATCHDOG_LOOP);
+		if (display_refresh)
+		{
+			display_refresh = FALSE;
+			sev_seg_unstage();					//Anything staged was a change from what was previously shown.
+			nmea_unstage();
+			staged = FALSE;
+			sev_seg_write_row(SEV_SEG_DECODE_MODE, layout.decode);	//Set the decode mode of every chip in one LOAD cycle.
+			sev_seg_flush(image);
+			memcpy(shown, image, sizeof(shown));
+			last_second = 0xFF;
+		}
+
+		console_service(!staged || (wait < TICK_GUARD));	//Commands are kept clear of the tick so they can't delay the commit.
+		if (sync_requested)
+		{
+			sync_requested = FALSE;
+			attempt_sync();			//Attempt to sync the RTC time with GPS data (shows the outcome and refreshes the display).
+		}
+
+		if (layout.update == UPDATE_ALWAYS)	//The value is adjusted with the buttons so render on every pass.
+		{
+			rtc_get_time(&time);		//The zone's offset is looked up at the time rendered, so it must be current.
+			memcpy(buffer, image, sizeof(buffer));
+			display_render(&layout, &time, buffer);
+			sev_seg_flush(buffer);		//Send the buffer to the seven segment display drivers (one LOAD cycle per digit row).
+			watchdog_checkin(WATCHDOG_DISPLAY);
+			continue;
+		}
 
-		//This loop will apply the decimal point flag to the last digit of each date/time component IF "delimiters" is set my the operating mode.
-		for (i = 3; i < 14; i += 2)
+		if (staged)				//Waiting for the tick to commit the next second's frame.
 		{
-			time[i] |= delimiters;	//"delimiters" is either 0 (no effect) or SEV_SEG_DP which will set the decimal point flag for the sev-seg drivers.
+			if (tick != display_tick)	//Committed by the tick interrupt.
+			{
+				staged = FALSE;
+				time = next;
+				last_second = time.seconds;
+				memcpy(shown, buffer, sizeof(shown));
+				tick_idle = wait;
+				watchdog_checkin(WATCHDOG_DISPLAY);
+				telemetry_emit();
+				calibration_service();
+				power_service();
+				resync_service();	//Check the RTC against the GPS if the re-sync interval has expired.
+				warm_save();
+			}
+			else if (++wait > TICK_TIMEOUT)	//No tick, so stop pre-rendering.
+			{
+				sev_seg_unstage();
+				nmea_unstage();
+				staged = FALSE;
+				ticks = FALSE;
+			}
+			else
+			{
+				if (layout.fraction_position != FIELD_UNUSED)
+				{
+					display_fraction(&layout, shown, tick);	//Count the fraction of the current second up to the tick.
+				}
+				_delay_us(TICK_WAIT_US);
+			}
+			continue;
 		}
 
-		//This loop will set the display buffer digits for the date components (CEN, YEA, MON, DAT).
-		for (i = 0; i < 8; i++)
+		tick = display_tick;			//A tick from here on means the time read below may already be out of date.
+		rtc_get_time(&time);			//Update the current time from the rtc.
+		watchdog_checkin(WATCHDOG_DISPLAY);	//The RTC has been read, even if it has stopped (so no new second is shown).
+		if (time.seconds != last_second)	//Display is behind the RTC (mode entry, no tick, or after a long re-sync check).
 		{
-			buffer[i + date_offset] = time[i];			//"date_offset" determined by current mode.
+			last_second = time.seconds;
+			memcpy(buffer, image, sizeof(buffer));
+			display_render(&layout, &time, buffer);
+			sev_seg_flush(buffer);
+			memcpy(shown, buffer, sizeof(shown));
+			telemetry_emit();
+			power_service();
+			resync_service();		//Check the RTC against the GPS if the re-sync interval has expired.
+			warm_save();
 		}
 
-		//This loop will set the display buffer digits for the time components (HOU, MIN, SEC).
-		for (i = 8; i < 14; i++)
+		if (ticks)				//Pre-render the next second and stage the rows that will change.
 		{
-			buffer[i + date_offset + time_offset] = time[i];	//"time_offset" determined by current mode.
+			uint16_t start = TCNT1;
+
+			next = time;
+			next_second(&next);
+			memcpy(buffer, image, sizeof(buffer));
+			display_render(&layout, &next, buffer);
+			render_cycles = TCNT1 - start;
+			if (layout.fraction_position != FIELD_UNUSED)	//The fraction rows are re-written during the second, so always stage them.
+			{
+				memset(&shown[layout.fraction_position], DIGIT_STALE, layout.fraction_digits);
+			}
+			sev_seg_stage(buffer, shown);
+			if (nmea_output)
+			{
+				nmea_prepare(&next);
+			}
+			ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+			{
+				if (tick == display_tick)
+				{
+					staged = TRUE;		//Commit at the next tick.
+					wait = 0;
+				}
+				else
+				{
+					sev_seg_unstage();	//Ticked while rendering.  Read the RTC again.
+					nmea_unstage();		//The sentence for this second is skipped rather than sent late.
+				}
+			}
 		}
+	}
 
-		//Take the contents of the buffer array and send it to the seven segment display drivers
-		for (uint8_t i = 0; i < 8; i++)	//Each iteration will send a digit to driver A and a digit to driver B so 8 iterations sends all 16 digits.
+	//Save a setting if it was changed while its mode was displayed.
+	if ((layout.value == VALUE_ZONE) && (zone != settings.zone))
+	{
+		zone_apply();			//Re-set the RTC to the new zone's offset and record the new value to eeprom.
+		attempt_sync();			//Attempt a re-sync with the new offset.
+	}
+	else if ((layout.value == VALUE_INTENSITY) && (intensity != settings.intensity))
+	{
+		settings_save();		//Record the new value to eeprom.
+	}
+}
+
+//TRUE if "candidate" is a row of mode_table that can be shown (modes needing the tick are skipped unless the square wave is wired).
+uint8_t mode_available(uint8_t candidate)
+{
+	return((candidate < MODE_COUNT) && (RTC_SQW_WIRED || !(pgm_read_byte(&mode_table[candidate].flags) & MODE_TICK)));
+}
+
+//Render the date, time and value of a mode for "time" into "buffer" (already holding the mode's static digits).
+//Each packed BCD byte is split into its tens (upper nibble) and ones (lower nibble) digits only here, at display time.
+//The decimal point flag is applied to the last digit of each date/time component if the mode uses delimiters.
+void display_render(mode_layout *layout, rtc_time *time, uint8_t *buffer)
+{
+	PROFILE_BEGIN(PROFILE_DISPLAY_RENDER);
+	uint8_t delimiters = layout->delimiters;
+
+	if (layout->date_position != FIELD_UNUSED)
+	{
+		uint8_t *date = &buffer[layout->date_position];
+
+		switch (layout->date_format)
 		{
-			sev_seg_write_byte(SEV_SEG_DIGIT_0 + i, buffer[i]);	//Send the digit for driver A (digits 0 to 7).
-			sev_seg_write_byte(SEV_SEG_DIGIT_8 + i, buffer[i+8]);	//Send the digit for driver B (digits 8 to 15).
+			case (DATE_CALENDAR) :		//Date components (CEN, YEA, MON, DAT).
+				if (time->month & RTC_CENTURY)	//Century flag set, year is 20xx.
+				{
+					date[0] = 2;
+					date[1] = 0;
+				}
+				else				//Century flag clear, year is 19xx.
+				{
+					date[0] = 1;
+					date[1] = 9;
+				}
+				date[2] = time->year >> 4;
+				date[3] = (time->year & 0x0F) | delimiters;
+				date[4] = (time->month & RTC_MONTH) >> 4;
+				date[5] = (time->month & 0x0F) | delimiters;
+				date[6] = time->date >> 4;
+				date[7] = (time->date & 0x0F) | delimiters;
+			break;
+
+			case (DATE_ORDINAL) :		//	Y Y Y Y - D D D
+				derived_update(time);
+				display_render_fixed(&date[0], 4, derived.year_full);
+				date[4] = SEV_SEG_CODEB_DASH;
+				display_render_fixed(&date[5], 3, derived.ordinal);
+			break;
+
+			case (DATE_WEEK) :		//	Y Y Y Y - W W - D
+				derived_update(time);
+				display_render_fixed(&date[0], 4, derived.week_year);
+				date[4] = SEV_SEG_CODEB_DASH;
+				display_render_fixed(&date[5], 2, derived.week);
+				date[7] = SEV_SEG_CODEB_DASH;
+				date[8] = derived.weekday;
+			break;
 		}
 	}
+
+	if (layout->time_position != FIELD_UNUSED)	//Time components (HOU, MIN, SEC).
+	{
+		uint8_t *clock = &buffer[layout->time_position];
+
+		clock[0] = time->hours >> 4;
+		clock[1] = (time->hours & 0x0F) | delimiters;
+		clock[2] = time->minutes >> 4;
+		clock[3] = (time->minutes & 0x0F) | delimiters;
+		clock[4] = time->seconds >> 4;
+		clock[5] = (time->seconds & 0x0F) | delimiters;
+	}
+
+	if (layout->fraction_position != FIELD_UNUSED)	//Frames are rendered for the start of the second.  See display_fraction().
+	{
+		memset(&buffer[layout->fraction_position], 0, layout->fraction_digits);
+	}
+
+	switch (layout->value)				//Value displayed right-aligned.
+	{
+		case (VALUE_EPOCH) :			//Seconds since midnight, January first, 1970.
+			derived_update(time);		//Whole days from the derived fields, only the time of day is added per frame.
+			display_render_int(buffer, SEV_SEG_DIGITS - 1, ((uint32_t) derived.days * SECONDS_IN_A_DAY) + (EPOCH_HOUR * SECONDS_IN_AN_HOUR) + (EPOCH_MINUTE * SECONDS_IN_A_MINUTE) + EPOCH_SECOND);
+		break;
+
+		case (VALUE_EPOCH_MS) :			//Epoch seconds, a decimal point, then the fraction digits.
+			derived_update(time);
+			display_render_int(buffer, layout->fraction_position - 1, ((uint32_t) derived.days * SECONDS_IN_A_DAY) + (EPOCH_HOUR * SECONDS_IN_AN_HOUR) + (EPOCH_MINUTE * SECONDS_IN_A_MINUTE) + EPOCH_SECOND);
+			buffer[layout->fraction_position - 1] |= SEV_SEG_DP;
+		break;
+
+		case (VALUE_ZONE) :			//	# #   ± # #.#
+			if (zone != zone_shown)		//The zone's transitions are only searched when another zone is selected (not every frame).
+			{
+				zone_shown = zone;	//Copied as the button ISR may change the zone while rendering.
+				zone_shown_offset = zone_offset(zone_shown, local_to_utc(time), NULL);
+			}
+			buffer[SEV_SEG_DIGITS - 7] = zone_shown / 10;									//Tens of the zone.
+			buffer[SEV_SEG_DIGITS - 6] = zone_shown % 10;									//Ones of the zone.
+			buffer[SEV_SEG_DIGITS - 4] = (zone_shown_offset < 0) ? SEV_SEG_CODEB_DASH : SEV_SEG_CODEB_BLANK;	//Minus sign (dash) for negative offsets.
+			buffer[SEV_SEG_DIGITS - 3] = abs(zone_shown_offset) / 100;						//Tens of the offset value.
+			buffer[SEV_SEG_DIGITS - 2] = ((abs(zone_shown_offset) / 10) % 10) | SEV_SEG_DP;				//Ones of the offset value.
+			buffer[SEV_SEG_DIGITS - 1] = (abs(zone_shown_offset) % 10);						//The .0 or .5 of the offset value.
+		break;
+
+		case (VALUE_INTENSITY) :		//Display intensity (0 to 15).
+			display_render_int(buffer, SEV_SEG_DIGITS - 1, intensity);
+		break;
+	}
+	PROFILE_END(PROFILE_DISPLAY_RENDER);
+}
+
+//Render an integer as decimal into "buffer".  Least-significant digit in digit "last" (SEV_SEG_DIGITS - 1 for right-aligned).
+void display_render_int(uint8_t *buffer, uint8_t last, uint32_t num)
+{
+	uint8_t i = last;
+
+	do
+	{
+		buffer[i] = (num % 10);		//'Ones' of the remaining value.
+		num /= 10;			//Remove the least-significant digit.
+		i--;				//Next digit to the left.
+	} while((num > 0) && (i < SEV_SEG_DIGITS));
 }
 
-void display_epoch_time(void)
+//Show the fraction of the current second (since the tick that committed "shown"), interpolated from the cycles since the tick and the
+//measured length of the last second.  Only does anything once every 1/FRACTION_RATE of a second, just after the displayed value changes, and
+//then only re-writes the digit rows holding the fraction.  Updates are kept well clear of the next tick so the bus is idle for its commit.
+//"tick" is display_tick before the next second's frame was staged.  Nothing is sent once the tick has been seen (the frame is committed).
+void display_fraction(mode_layout *layout, uint8_t *shown, uint8_t tick)
 {
-	//Initialisation of the epoch variable (number of seconds elapsed since 1970.01.01.00.00.00.
-	uint64_t epoch = 0;
+	uint8_t buffer[SEV_SEG_DIGITS];
+	uint32_t elapsed;
+	uint32_t period;
+	uint16_t fraction;
+	uint16_t scale = 100;
+
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		elapsed = cycles_now() - tick_cycles;
+		period = tick_period;
+	}
+
+	if (fraction_tick != tick)		//First call this second.
+	{
+		fraction_tick = tick;
+		fraction_due = 0;
+	}
+	if (elapsed < fraction_due)
+	{
+		return;
+	}
+
+	PROFILE_BEGIN(PROFILE_FRACTION);
+	if (labs((int32_t) (period - F_CPU)) > (CALIBRATION_LIMIT_PPM * (F_CPU / 1000000UL)))
+	{
+		period = F_CPU;			//Last second wasn't measured (e.g. first tick or a missed tick).
+	}
+	fraction = elapsed / (period / 1000);	//Thousandths of a second.
+	if (fraction > 999)
+	{
+		fraction = 999;			//Tick is late.  Hold at the end of the second rather than wrap.
+	}
+	fraction_due = ((fraction / (1000 / FRACTION_RATE)) + 1) * (period / FRACTION_RATE);	//Start of the next step.
 
-	//Enter a loop that will continuously update the dynamic data and refresh the display.
-	while (mode == MODE_3_EPOCH)	//This loop will exit when the mode changes.
+	memcpy(buffer, shown, sizeof(buffer));
+	for (uint8_t i = 0; i < layout->fraction_digits; i++)
 	{
-		sev_seg_write_byte(SEV_SEG_DECODE_MODE_A, 0b11000000);		//Set the first 5 digits (0-4) to manual decode to display text.
-		for (uint8_t i = 0; i < 6; i++)					//For loop runs through the first 6 digits (0-5).
+		buffer[layout->fraction_position + i] = (fraction / scale) % 10;
+		scale /= 10;
+	}
+
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		if (tick == display_tick)	//Still the same second, so the staged frame hasn't been committed.
 		{
-			sev_seg_write_byte(SEV_SEG_DIGIT_0 + i, epoch_text[i]);	//Write the pseudo-text "EPOCH-"
+			sev_seg_update(buffer, shown);
+			memcpy(shown, buffer, SEV_SEG_DIGITS);
 		}
+	}
+	PROFILE_END(PROFILE_FRACTION);
+}
 
-		rtc_get_time(time);	//Update the current time from the rtc.
+//Render an integer into "width" digits (most-significant first) with leading zeros.
+void display_render_fixed(uint8_t *digits, uint8_t width, uint16_t num)
+{
+	while (width--)
+	{
+		digits[width] = (num % 10);
+		num /= 10;
+	}
+}
+
+//Recompute the calendar fields derived from the date in "time" if it differs from the date they were last derived from.
+//Only changes at local midnight or when the RTC is re-written (sync or offset change), so the work is done at most once a day in normal running.
+void derived_update(rtc_time *time)
+{
+	uint16_t jan1;		//Days elapsed from 1970.01.01 to Jan 1st of the current year.
+	uint8_t leap;		//Set if the current year is a leap year.
+	uint8_t week;		//ISO week before correcting for weeks that belong to the previous or next year.
+
+	if ((time->date == derived.date) && (time->month == derived.month) && (time->year == derived.year))
+	{
+		return;		//Same date, nothing to do.
+	}
+
+	derived.date = time->date;
+	derived.month = time->month;
+	derived.year = time->year;
+
+	if ((EPOCH_MONTH < JAN) || (EPOCH_MONTH > DEC))	//An invalid month (e.g. RTC never set) would index outside of days_table.
+	{
+		return;
+	}
+
+	jan1 = EPOCH_DAYS_TO_2000 + ((EPOCH_YEAR / 4) * DAYS_IN_4_YEARS) + pgm_read_word(&days_table[EPOCH_YEAR % 4][0]);
+	leap = !(EPOCH_YEAR % 4);
 
-		//Time to calculate the epoch time.  This will work for any date time from Jan 1st 2000 until Dec 31st 2100.
-		epoch =  EPOCH_SECONDS_TO_2000;						//Seconds elapsed from 19700101000000 to 20000101000000.
-		epoch += (EPOCH_YEAR/4) * DAYS_IN_4_YEARS * SECONDS_IN_A_DAY;		//Seconds elapsed in full 4-year blocks since 2000.
-		epoch += days_table[EPOCH_YEAR % 4][EPOCH_MONTH - 1] * SECONDS_IN_A_DAY;//Seconds elapsed in current 4-year block to start of month.
-		epoch += (EPOCH_DAY -1) * SECONDS_IN_A_DAY;				//Seconds elapsed since start of month to start of day.
-		epoch += EPOCH_HOUR * SECONDS_IN_AN_HOUR;				//Seconds elapsed since start of day to start of hour.
-		epoch += EPOCH_MINUTE * SECONDS_IN_A_MINUTE;				//Seconds elapsed since start of hour to to start of minute.
-		epoch += EPOCH_SECOND;							//Seconds elapsed since start of minute.
+	derived.year_full = ((time->month & RTC_CENTURY) ? 2000 : 1900) + EPOCH_YEAR;
+	derived.ordinal = pgm_read_word(&days_table[EPOCH_YEAR % 4][EPOCH_MONTH - 1]) - pgm_read_word(&days_table[EPOCH_YEAR % 4][0]) + EPOCH_DAY;
+	derived.days = jan1 + derived.ordinal - 1;
+	derived.weekday = ISO_WEEKDAY(derived.days);
 
-		sev_seg_display_int(epoch);	//We have the epoch value so display it (next to "EPOCH-" text).
+	//ISO week 1 is the week (Monday to Sunday) containing the year's first Thursday.
+	derived.week_year = derived.year_full;
+	week = (derived.ordinal - derived.weekday + 10) / 7;
+	if (week < 1)					//Last week of the previous year.
+	{
+		derived.week_year--;
+		leap = !((EPOCH_YEAR + 3) % 4);		//Previous year is a leap year.
+		week = iso_weeks(jan1 - (leap ? 366 : 365), leap);
+	}
+	else if (week > iso_weeks(jan1, leap))		//First week of the next year.
+	{
+		derived.week_year++;
+		week = 1;
 	}
+	derived.week = week;
+}
+
+//Number of ISO weeks in a year that starts on day "jan1" (days since 1970).  53 if the year starts on a Thursday, or a Wednesday in a leap year.
+uint8_t iso_weeks(uint16_t jan1, uint8_t leap)
+{
+	uint8_t weekday = ISO_WEEKDAY(jan1);
+
+	return(((weekday == 4) || (leap && (weekday == 3))) ? 53 : 52);
 }
 
-//Allow the UTC offset to be adjusted by pressing the "Sync" button.  Valid UTC offsets are in half-hour increments from -11.5 to 12.0.
-//(Note, to avoid using floats, the actual offset value is an integer from -120 to 120)
-void get_offset(void)
+//Measure the CPU clock against the RTC second using the cycle counts captured by the tick interrupt.
+//Seconds are only counted if the tick interrupt has counted exactly one tick since the last call, so a window spans consecutive ticks.
+void calibration_service(void)
 {
-	sev_seg_all_clear();						//Clear all digits to prevent artifacts from previous mode.
+	uint32_t captured;
+	uint8_t tick;
 
-	//Enter a loop that will continuously refresh the display and allow adjustment of the offset.
-	while (mode == MODE_4_OFFSET)						//Run the following loop until the mode is changed.
+	if (!RTC_SQW_WIRED)
 	{
-		sev_seg_set_word(offset_text, sizeof(offset_text));		//Display "OFFSEt" on the left-most digits.
-		display_offset();						//Display the current offset value using the last 4 digits (12-15).
+		return;				//Nothing marks the second, so OSCCAL keeps the value loaded at boot (see gps_clock.h).
 	}
 
-	sev_seg_decode_mode(DECODE_CODE_B);					//Return all digits to Code B decode mode.
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		captured = tick_cycles;
+		tick = display_tick;
+	}
 
-	if (offset != (int8_t) eeprom_read_byte(OFFSET_EEPROM_ADDRESS))		//If the mode has changed and the offset is different to what's in eeprom...
+	if (calibration_restart || ((uint8_t) (tick - calibration_tick) != 1) ||
+		(labs((int32_t) (captured - calibration_last - F_CPU)) > (CALIBRATION_LIMIT_PPM * (F_CPU / 1000000UL))))
+	{
+		calibration_restart = FALSE;		//Start a new window at this tick.
+		calibration_seconds = 0;
+		calibration_start = captured;
+	}
+	else if (++calibration_seconds >= CALIBRATION_SECONDS)
 	{
-		eeprom_update_byte((uint8_t *) OFFSET_EEPROM_ADDRESS, offset);	//Record the new value to eeprom.
-		attempt_sync();							//Attempt a re-sync with the new offset.
+		calibration_seconds = 0;
+		calibration_adjust((int32_t) (captured - calibration_start - (F_CPU * CALIBRATION_SECONDS)) / (int32_t) CALIBRATION_CYCLES_PER_PPM);
+		calibration_start = captured;
 	}
+
+	calibration_tick = tick;
+	calibration_last = captured;
 }
 
-//Display the current offset value using the last 4 digits (12-15).
-void display_offset(void)
+//Step the search for the OSCCAL value that gives the smallest error.  A higher OSCCAL gives a faster clock.
+//The search only moves within the current OSCCAL range (bit 7), as the two ranges overlap and stepping between them jumps the frequency.
+void calibration_adjust(int32_t error)
 {
-	if (offset < 0)								//If the current offset is less than zero...
+	uint8_t next;
+
+	calibration_error = error;
+
+	if (calibration_state == CALIBRATION_MONITOR)
 	{
-		sev_seg_write_byte(SEV_SEG_DIGIT_12, SEV_SEG_CODEB_DASH);	//Print a minus sign (dash) before the offset value.
+		if (labs(error) <= (labs(calibration_after) + CALIBRATION_RECHECK_PPM))
+		{
+			return;				//Still as good as the last search left it.
+		}
+		calibration_state = CALIBRATION_START;
+	}
+
+	if (calibration_state == CALIBRATION_START)		//Error before the search.
+	{
+		calibration_before = error;
+		calibration_best = OSCCAL;
+		calibration_best_error = error;
+		calibration_direction = (error > 0) ? -1 : 1;	//Slow down a fast clock, speed up a slow one.
+		calibration_state = CALIBRATION_SEARCH;
+	}
+	else if (labs(error) < labs(calibration_best_error))	//The trial value is better, so keep going.
+	{
+		calibration_best = OSCCAL;
+		calibration_best_error = error;
+	}
+
+	next = OSCCAL + calibration_direction;
+	if ((calibration_best != OSCCAL) || ((next ^ OSCCAL) & 0x80) || (next == SETTINGS_UNCALIBRATED))
+	{
+		//The trial value was no better (so the best has been passed) or the end of the range has been reached.
+		OSCCAL = calibration_best;
+		calibration_after = calibration_best_error;
+		calibration_state = CALIBRATION_MONITOR;
+		if (settings.calibration != OSCCAL)
+		{
+			settings.calibration = OSCCAL;
+			settings_save();
+		}
+
+		usart_print_string("\r\nOSCCAL 0x");
+		usart_print_hex(OSCCAL);
+		usart_print_string(" error (ppm) ");
+		usart_print_int(calibration_before);
+		usart_print_string(" -> ");
+		usart_print_int(calibration_after);
 	}
 	else
 	{
-		sev_seg_write_byte(SEV_SEG_DIGIT_12, SEV_SEG_CODEB_BLANK);	//Otherwise keep digit 12 blank for positive offsets.
+		OSCCAL = next;					//Try the next value.
 	}
-	sev_seg_write_byte(SEV_SEG_DIGIT_13, abs(offset) / 100);			//Display the tens of the offset value.
-	sev_seg_write_byte(SEV_SEG_DIGIT_14, ((abs(offset) / 10) % 10) | SEV_SEG_DP);	//Display the ones of the offset value.
-	sev_seg_write_byte(SEV_SEG_DIGIT_15, (abs(offset) % 10));			//Display the .0 or .5 of the offset value.
+	calibration_restart = TRUE;				//The next window must be measured entirely at the new value.
 }
 
-//Increment the offset value and rollover when maximum value is exceeded.
-//This function is called when the "Sync" button is pressed only when running Mode 4.
-void cycle_offset(void)
+//Stage the ZDA sentence for the next second.  The RTC keeps local time so the UTC offset is removed first.
+//Holdover (the RTC free-running since the last sync attempt failed) is flagged by the sentence's talker.
+void nmea_prepare(rtc_time *next)
+{
+	rtc_time utc;
+
+	epoch_to_time(local_to_utc(next), &utc);
+	nmea_stage(&utc, (sync_outcome == SYNC_LOG_NO_GPS));
+}
+
+//Select the next time zone and rollover after the last.  The RTC is only re-set (by zone_apply()) once the zone mode is left.
+//This function is called when the "Sync" button is pressed only when running the zone mode.
+void cycle_zone(void)
+{
+	zone++;				//Next zone.
+	if (zone >= ZONE_COUNT)		//If the last zone is exceeded...
+	{
+		zone = 0;		//Rollover to the first (UTC-12.0).
+	}
+}
+
+//Re-set the RTC if the selected zone's offset at the current time differs from the offset the RTC is set to (daylight saving has started or
+//ended, or another zone has been selected), and note when the offset next changes.  The zone's transitions are only searched here and by
+//sync_time(), so this is called at boot, when the zone is changed and once zone_next has passed (i.e. once or twice a year).
+//The time display modes call it just after a tick, so re-setting the RTC (which restarts its second) only shifts the second by a few ms.
+void zone_apply(void)
 {
-	offset += 5;			//Increment offset by 5.
-	if (offset > 120)		//If maximum valid value (120) is exceeded...
+	rtc_time rtc_now;
+
+	rtc_get_time(&rtc_now);
+	if (rtc_valid() && calculate_epoch(&rtc_now))	//Otherwise the RTC hasn't been set, and the next sync will apply the zone.
+	{
+		if (zone_correct(zone, &rtc_now, &zone_next))
+		{
+			rtc_set_time(&rtc_now);
+			calibration_restart = TRUE;		//Setting the RTC restarts its second.
+			zone_shown = 0xFF;			//The zone mode must look up the new offset.
+			time = rtc_now;
+		}
+	}
+
+	if ((offset != settings.offset) || (zone != settings.zone))
 	{
-		offset = -120;		//Rollover to minimum valid value (-120).
+		settings_save();		//The offset the RTC is set to must be known at boot.
 	}
 }
 
@@ -312,365 +881,779 @@ void cycle_offset(void)
 void attempt_sync(void)
 {
 	BUTTONS_DISABLE;	//Disable pin-change interrupts effectively disabling the buttons so that the sync function is less likely to produce an error.
+	gps_wake();		//Wake the receiver if it is in backup mode (it has the time shown by "SynCIng" to get a fix).
 
 	//Attempt to sync rtc time with gps time.
 	sev_seg_flash_word(syncing, sizeof(syncing), 2000);		//Display "SynCIng" for 2 seconds.
-	if (!sync_time(time))						//If the sync is unsuccessful...
+	if (!sync_time(&time))						//If the sync is unsuccessful...
 	{
+		log_sync(SYNC_LOG_NO_GPS, SYNC_LOG_ERROR_UNKNOWN);	//Record the failed attempt.
 		sev_seg_flash_word(no_sync, sizeof(no_sync), 1000);	//Display "nO SynC" for 1 seconds.
 	}
 	else								//If the sync was successful...
 	{
+		resync_minutes = 0;					//Restart the count towards the next background check.
+		gps_sleep();						//Power the receiver down until the next check.
+		log_sync(SYNC_LOG_MANUAL, SYNC_LOG_ERROR_UNKNOWN);	//Record the sync.
 		sev_seg_flash_word(success, sizeof(success), 1000);	//Display "SUCCESS" for 1 seconds.
 	}
 
 	BUTTONS_ENABLE;		//Re-enable the buttons just prior to exiting the function.
 }
 
-//This function will update the time array by parsing the date and time from the GPS module.
-uint8_t sync_time (uint8_t *time)
+//This function will update the time structure from the GPS module, apply the UTC offset and set the RTC.
+uint8_t sync_time (rtc_time *time)
 {
+	PROFILE_BEGIN(PROFILE_SYNC_TIME);
+	if (!gps_get_time(time))		//If no valid time could be parsed from the GPS...
+	{
+		PROFILE_END(PROFILE_SYNC_TIME);
+		return(FALSE);			//Exit the function and return FALSE.
+	}
 
-	usart_print_string("\r\nSyncing...");	//For debugging; indicates entering sync loop
-
-	uint8_t i;	//Initialise an integer to use in for loops
+	gps_align(time);			//Write the RTC as the GPS second starts.
+	resync_written(calculate_epoch(time), gps_phase);	//The error measured by the next background check has built up from here.
+	offset = zone_offset(zone, resync_set, &zone_next);	//Offset of the selected zone at the GPS (UTC) time.
+	apply_offset();				//Since the time appears valid, apply the UTC offset.
+	rtc_set_time(time);			//Valid time from GPS so update the real-time clock module.
+	calibration_restart = TRUE;		//Setting the RTC restarts its second.
+	zone_shown = 0xFF;			//The zone mode must look up the offset again.
+	if ((offset != settings.offset) || (zone != settings.zone))
+	{
+		settings_save();		//The offset the RTC is set to must be known at boot.
+	}
+	PROFILE_END(PROFILE_SYNC_TIME);
+	return(TRUE);				//This will only be reached if the function received valid time data from the GPS module, so return TRUE.
+}
 
-	//RMC sentence format (sections of data separated by commas):
-	//Example: $GPRMC,161229.487,A,3723.2475,N,12158.3416,W,0.13,309.62,120598, ,*10
-	//$GPRMC,utc time,data valid/invalid,latitude,N/S,longitude,E/W,ground speed(knots),course(deg),date,magnetic variation(deg),checksum
-	//Nested if statements to check characters 'R', 'M' & 'C' are received in order - this confirms beginning of RMC sentence.
-	while(usart_receive_byte() != 'R'){};		//Ignore all received bytes until the 'R' character is received.
-	if(usart_receive_byte() == 'M')			//If the next character is 'M'...
+//This function will update the time structure by parsing the UTC date and time from the GPS module.
+//Each sentence is collected into a line buffer and the first valid time sentence is used (RMC or ZDA, or GGA with the date from the RTC),
+//whatever order the receiver sends them in.  See nmea.h for the validity checks.
+//Gives up if the GPS is silent for GPS_TIMEOUT_MS, or has sent GPS_BYTE_LIMIT bytes without a valid time.
+//The receiver sends each epoch's sentences back to back, shortly after the second they give, so a byte after at least GPS_GAP_MS of silence
+//starts an epoch.  Its time is recorded in gps_epoch_cycles (gps_phase is cleared if the time was found before any gap was seen).
+uint8_t gps_get_time (rtc_time *time)
+{
+	nmea_receiver receiver;				//Line buffer and fix status of the sentences received by this call.
+	uint8_t found;					//Contents of the last sentence parsed.
+	rtc_time utc;					//Parsed time.  Only copied to "time" if valid.
+	uint16_t timeout = GPS_TIMEOUT_MS * 10;		//Number of 100us waits allowed before giving up on the GPS.
+	uint16_t bytes = GPS_BYTE_LIMIT;		//Number of bytes allowed before giving up on the GPS.
+	uint32_t last;					//cycles_now() when the last byte was read.
+	uint32_t now;
+
+	nmea_receive_init(&receiver);
+	usart_rx_flush();				//Only parse data received from now on (also discards any partial console line).
+	gps_phase = FALSE;
+	last = cycles_now();
+
+	while (1)
 	{
-		if(usart_receive_byte() == 'C')		//And the third character is 'C'...  Verified that we have reached the RMC NMEA string.
+		watchdog_wait();			//Bounded by the timeout and the byte limit (about 4 seconds between them).
+		if (!usart_byte_waiting())		//If nothing has been received yet...
 		{
-			usart_receive_byte();		//Ignore the next received byte (delimiter ",")
-
-			//The next 6 bytes received represent the time in BCD -> H,H,M,M,S,S
-			for (i = HOU_TENS; i <= SEC_ONES; i++)
+			if (!timeout--)			//So count down the timeout.
 			{
-				time[i] = (usart_receive_byte() - '0');		//Copy the BCD value to the relevant element of the time array.
+				gps_latency = GPS_TIMEOUT_MS;
+				return(FALSE);		//GPS not responding, so exit the function and return FALSE.
 			}
+			_delay_us(100);
+			continue;
+		}
 
-			//The next 8 elements of the NMEA data aren't needed and so are ignored.
-			for(i = 0; i < 8; i++)			//Loop 8 times
-			{
-				while (usart_receive_byte() != ','){};	//Skip through 8 delimiters (",") from the RMC sentence to get to the date data.
-			}
-
-			//The next 6 bytes received represent the date but are received in an inconvenient (not ISO-8601) order -> D,D,M,M,Y,Y
-			time[DAY_TENS] = (usart_receive_byte() - '0');	//Date tens
-			time[DAY_ONES] = (usart_receive_byte() - '0');	//Date ones
-			time[MON_TENS] = (usart_receive_byte() - '0');	//Month tens
-			time[MON_ONES] = (usart_receive_byte() - '0');	//Month ones
-			time[YEA_TENS] = (usart_receive_byte() - '0');	//Year tens
-			time[YEA_ONES] = (usart_receive_byte() - '0');	//Year ones
-
-			//The final two bytes needed for the time array represent the century.  Safe to set this to "20".
-			time[CEN_TENS] = 2;				//Century (Year thousands)
-			time[CEN_ONES] = 0;				//Century (Year hundreds)
-			//Note, this will cease working as of midnight, January 1st, 2100.
-
-			//We now have the UTC date/time array in BCD format [Y,Y,Y,Y,M,M,D,D,H,H,M,M,S,S]
+		if (!bytes--)				//Receiving, but nothing valid.
+		{
+			gps_latency = GPS_TIMEOUT_MS;
+			return(FALSE);
 		}
-	}
 
-	//Basic error checking.  All digits in the date/time array "time[]" should be 0-9.  If anything else is found, exit the function and return FALSE.
-	for(i = YEA_TENS; i <= SEC_ONES; i++)	//Loop through all elements of the "time" array (excluding manually set century).
-	{
-		if(time[i] > 9)			//If any element is an integer larger than 9, then the data is no good.
+		now = cycles_now();
+		if ((now - last) >= (GPS_GAP_MS * (F_CPU / 1000)))	//The receiver has started sending an epoch.
 		{
-			return(FALSE);		//If the time data is no good, exit the function and return FALSE.
+			gps_epoch_cycles = now;
+			gps_phase = TRUE;
 		}
-		else
+		last = now;
+
+		found = nmea_receive(&receiver, usart_receive_byte(), &utc);
+		if ((found == NMEA_DATE_TIME) || ((found == NMEA_TIME) && gps_merge_date(&utc)))
 		{
-			apply_offset();		//Since the time appears valid, apply the UTC offset.
-			rtc_set_time(time);	//Valid time from GPS so update the real-time clock module.
-			return(TRUE);		//This will only be reached if the function received valid time data from the GPS module, so return TRUE.
+			gps_latency = (GPS_TIMEOUT_MS - (timeout / 10));	//Record the (approximate) time spent waiting.
+			*time = utc;
+			return(TRUE);
 		}
 	}
+}
+
+//Complete a time-only UTC time (GGA) with the UTC date from the RTC.  The RTC keeps local time, so the offset is removed first.
+//The date is chosen to put the result within 12 hours of the RTC, so a GPS time just either side of midnight takes the right date.
+//Returns FALSE if the RTC's date can't be trusted (oscillator stopped since it was last set, or never set).
+uint8_t gps_merge_date (rtc_time *time)
+{
+	rtc_time rtc_now;
+	uint32_t rtc_epoch;			//RTC time (UTC) as seconds since epoch.
+	int32_t difference;			//GPS time minus RTC time (seconds).
+
+	rtc_get_time(&rtc_now);
+	if (!rtc_valid() || !calculate_epoch(&rtc_now))
+	{
+		return(FALSE);
+	}
+	rtc_epoch = local_to_utc(&rtc_now);
+
+	epoch_to_time(rtc_epoch, &rtc_now);	//RTC date (UTC) with the GPS time.
+	rtc_now.hours = time->hours;
+	rtc_now.minutes = time->minutes;
+	rtc_now.seconds = time->seconds;
 
-	return(FALSE);		//Should not reach this.
+	difference = calculate_epoch(&rtc_now) - rtc_epoch;
+	if (difference > (SECONDS_IN_A_DAY / 2))
+	{
+		difference -= SECONDS_IN_A_DAY;	//e.g. GPS 23:59:59, RTC 00:00:01 (the RTC is ahead and has already reached the next day).
+	}
+	else if (difference < -(SECONDS_IN_A_DAY / 2))
+	{
+		difference += SECONDS_IN_A_DAY;	//e.g. GPS 00:00:01, RTC 23:59:59.
+	}
+	epoch_to_time(rtc_epoch + difference, time);
+	return(TRUE);
 }
 
-//Offset range is -120 to +120 whereby actual offset in half-hour increments correspond to values of 5 (e.g. -120:-12.0hrs, +65:+6.5hrs)
-void apply_offset(void)
+//Called from the time display loops every time the RTC is read.  Counts the minutes elapsed and runs a background check once the interval expires.
+void resync_service(void)
 {
-	if (offset < 0)
+	if (time.minutes != resync_last_minute)		//If a new minute has started since the last call (compared in BCD, no conversion needed)...
 	{
-		//If statement returns true if (absolute value of offset)/10 is non-zero.  Only possible for offset values ending in 5.
-		//Therefore ~if(half-hour increment/decrement is required).
-		if (abs(offset) % 10)				//Need to decrement minutes by 30.
+		resync_last_minute = time.minutes;	//Record the new minute.
+
+		if (local_to_utc(&time) >= zone_next)	//If daylight saving has started or ended...
 		{
-			time[MIN_TENS] -= 3;			//Decrement minute tens by 3.
-			if (time[MIN_TENS] > 5)			//If minute tens has rolled under zero (unsigned integer means it actually rolls to 255)
-			{
-				time[MIN_TENS] += 6;		//Correct by adding 6...
-				time[HOU_ONES] --;		//And decrementing hour ones.
-			}
+			zone_apply();			//Re-set the RTC to the zone's new offset.
+			resync_last_minute = time.minutes;	//A half hour shift changes the minutes.
 		}
 
-		time[HOU_ONES] -= (abs(offset) / 10) % 10;	//Decrement hour ones by the ones value represented by "offset".
-		if (time[HOU_ONES] > 9)				//If the hour ones has rolled under zero (unsigned integer means it actually rolls to 255)
+		if (resync_minute())			//Count the minute.  If the re-sync interval has expired...
 		{
-			time[HOU_ONES] += 10;			//Correct by adding 10...
-			time[HOU_TENS] --;			//And decrementing hour tens.
+			resync_check();			//Check the RTC against the GPS.
 		}
+	}
+}
 
-		time[HOU_TENS] -= abs(offset) / 100;		//Decrement hour tens by the tens value represented by "offset".
+//Compare the RTC to the GPS and re-write the RTC only if the error has reached the threshold.  Nothing is shown on the display.
+//The interval to the next check is then worked out from the drift (see resync_schedule()), or halved or doubled until it has been measured.
+void resync_check(void)
+{
+	rtc_time rtc_now;			//A second time structure used to hold the RTC time for comparison.
+	uint32_t gps_epoch;			//GPS time (UTC) as seconds since epoch.
+	int32_t error;				//RTC minus GPS (ms).
+	uint8_t valid;				//Set if a valid time was received from the GPS.
+	uint8_t rewrite;			//Set if the RTC is re-written.
 
-		if (HOU > 23)					//Finally, assess the offset corrected hours value.  If it has rolled under zero...
-		{
-			rollunder_hours();			//Correct by running the rollunder hours function (offset indicates local time is previous day).
-		}
+	BUTTONS_DISABLE;			//Disable the buttons so that the GPS data is less likely to be corrupted.
+	gps_wake();				//Only needed if the check is earlier than the receiver was due to wake by itself.
+
+	valid = gps_get_time(&time);
+	if (!valid)				//If no valid time could be parsed from the GPS...
+	{
+		resync_missed();					//Try again after the minimum interval.
+		gps_adapt(FALSE, 0);					//Wake the receiver earlier next time (it stays awake until a good check).
+		log_sync(SYNC_LOG_NO_GPS, SYNC_LOG_ERROR_UNKNOWN);	//Record the failed attempt.
 	}
-	else if (offset > 0)
+	else
 	{
-		//If statement returns true if (absolute value of offset)/10 is non-zero.  Only possible for offset values ending in 5.
-		//Therefore ~if(half-hour increment/decrement is required).
-		if (offset % 10)				//Need to increment minutes by 30.
+		gps_epoch = calculate_epoch(&time);
+		gps_adapt(TRUE, gps_epoch);
+		if (gps_phase)			//Measured to the millisecond.
 		{
-			time[MIN_TENS] += 3;			//Increment minute tens by 3.
-			if (time[MIN_TENS] > 5)			//If minute tens has rolled over max valid value.
-			{
-				time[MIN_TENS] -= 6;		//Correct by minusing 6...
-				time[HOU_ONES] ++;		//And incrementing hour ones.
-			}
+			error = resync_measure(gps_epoch);
 		}
-
-		time[HOU_ONES] += (offset / 10) % 10;		//Increment hour ones by the ones value represented by "offset".
-		if (time[HOU_ONES] > 9)				//If the hour ones has rolled over max valid value.
+		else				//Whole seconds only, from an RTC read after the (already late) sentence.
 		{
-			time[HOU_ONES] -= 10;			//Correct by minusing 10...
-			time[HOU_TENS] ++;			//And incrementing hour tens.
+			rtc_get_time(&rtc_now);
+			error = (int32_t) (local_to_utc(&rtc_now) - gps_epoch) * 1000;
 		}
+		rewrite = resync_assess(error, gps_phase, gps_epoch);	//Updates the drift and resync_error.
 
-		time[HOU_TENS] += offset / 100;			//Increment hour tens by the tens value represented by "offset".
-
-		if (HOU > 23)					//Finally, assess the offset corrected hours value.  If it has rolled over max valid value...
+		if (rewrite)			//If the RTC has drifted too far...
 		{
-			rollover_hours();			//Correct by running the rollunder hours function (offset indicates local time is previous day).
+			gps_align(&time);			//Write the RTC as the GPS second starts.
+			resync_written(calculate_epoch(&time), gps_phase);
+			apply_offset();				//Apply the UTC offset to the GPS time.
+			rtc_set_time(&time);			//Re-write the RTC.
+			calibration_restart = TRUE;		//Setting the RTC restarts its second.
 		}
+
+		resync_reschedule(rewrite, gps_epoch);		//Work out the interval to the next check (and restart the count).
+		log_sync(rewrite ? SYNC_LOG_RTC_SET : SYNC_LOG_IN_SYNC, resync_error);	//Record the measured error (and any re-write).
 	}
+
+	rtc_get_time(&time);			//Restore the time structure from the RTC for the display loops.
+	resync_last_minute = time.minutes;
+	if (valid)
+	{
+		gps_sleep();			//Power the receiver down until shortly before the next check.
+	}
+	BUTTONS_ENABLE;				//Re-enable the buttons.
 }
 
-//This function is called when offset corrected time requires the local day to be the day prior to UTC day.
-//For correct date/time, Need to add 24 hours and minus one day.
-void rollunder_hours(void)
+//Measure the RTC's error (ms, RTC minus GPS) against the GPS time "gps_epoch" just received, with gps_phase set.  The RTC is read until its
+//next second starts, when its time is exact, and compared with the GPS time at that moment (counted on from gps_epoch_cycles).  Takes up to
+//a second.  The CPU clock's error (see calibration_service()) adds at most a few ms.
+int32_t resync_measure(uint32_t gps_epoch)
 {
-	uint8_t hours = HOU + 24;		//"hours" is the desired hours (need to add 24 to the decremented total hours).
-	time[HOU_ONES] = hours % 10;		//Set the required value for hour ones.
-	time[HOU_TENS] = hours / 10;		//Set the required value for hour tens.
-	time[DAY_ONES] --;			//Decrement the day ones.
+	rtc_time rtc_now;
+	uint8_t second;
+	uint32_t elapsed;			//Cycles since the start of the receiver's output.
 
-	if (time[DAY_ONES] > 9)			//Adjust day tens if ones have dropped below zero (e.g. day: 10->09)
+	rtc_get_time(&rtc_now);
+	second = rtc_now.seconds;
+	do
 	{
-		time[DAY_ONES] = 9;		//Set the day ones to 9.
-		time[DAY_TENS] --;		//Decrement the day tens.
+		watchdog_wait();		//Bounded below, even if the RTC has stopped.
+		rtc_get_time(&rtc_now);
+		elapsed = cycles_now() - gps_epoch_cycles;
+	} while ((rtc_now.seconds == second) && (elapsed < (2 * F_CPU)));
+
+	return(((int32_t) (local_to_utc(&rtc_now) - gps_epoch) * 1000) - (int32_t) (elapsed / (F_CPU / 1000)) - GPS_OUTPUT_DELAY_MS);
+}
+
+//Wait for the start of the GPS second after the time just received (from gps_epoch_cycles) and advance "time" (UTC) to it, so that the RTC
+//written straight after starts its second in phase with the GPS.  Does nothing if gps_phase isn't set, so the RTC is written late by the
+//sentence's latency (up to a second).
+void gps_align(rtc_time *time)
+{
+	uint32_t seconds;
+
+	if (!gps_phase)
+	{
+		return;
+	}
+	seconds = ((cycles_now() - gps_epoch_cycles) / (F_CPU / 1000) + GPS_OUTPUT_DELAY_MS) / 1000 + 1;	//GPS seconds to advance.
+	while ((((cycles_now() - gps_epoch_cycles) / (F_CPU / 1000)) + GPS_OUTPUT_DELAY_MS) < (seconds * 1000))
+	{
+		watchdog_wait();		//At most a second.
+	}
+	epoch_to_time(calculate_epoch(time) + seconds, time);
+}
+
+//Wake the GPS receiver if it is in backup mode (or modelled as being in it).  The wake time is recorded to measure the time to fix.
+void gps_wake(void)
+{
+	rtc_time rtc_now;
+
+	if (gps_awake)
+	{
+		return;
 	}
+	if (GPS_POWER_SAVE)
+	{
+		usart_tx_hold(FALSE);	//Output was held so as not to wake the receiver early (see gps_sleep()).
+		ubx_wake();
+	}
+	rtc_get_time(&rtc_now);
+	gps_awake = TRUE;
+	gps_wake_at = local_to_utc(&rtc_now);
+}
+
+//Put the GPS receiver into backup mode after a good sync.  It wakes by itself gps_wake_lead seconds before the next scheduled check.
+//"time" must hold the current (local) time and resync_minutes the minutes counted towards the check.  Nothing is sent if the sleep would be
+//shorter than GPS_SLEEP_MIN or the request can't be queued, and the receiver is left awake.
+//Any activity on the receiver's RXD wakes it, so all serial output (telemetry, NMEA and console replies) is discarded until it wakes.
+void gps_sleep(void)
+{
+	int32_t seconds = ((int32_t) (resync_interval - resync_minutes) * SECONDS_IN_A_MINUTE) - BCD_TO_BIN(time.seconds) - gps_wake_lead;
 
-	if (DAY < 1)				//Asses the offset corrected day.  If it has rolled below minimum valid value of 1...
+	if (GPS_POWER_SAVE && (seconds >= GPS_SLEEP_MIN) && ubx_backup(seconds * 1000UL))
 	{
-		rollunder_days();		//Correct by running the rollunder days function (offset indicates local time is previous month).
+		usart_tx_hold(TRUE);	//The request is already queued, so it is still sent.
+		gps_awake = FALSE;
+		gps_cycled = TRUE;
+		gps_wake_at = local_to_utc(&time) + seconds;
 	}
 }
 
-//This function is called when offset corrected time requires the local day to be the day after the UTC day.
-//For correct date/time, Need to minus 24 hours and add one day.
-void rollover_hours(void)
+//Adapt the wake-up lead to the outcome of a scheduled check ("utc" is the GPS time received if "valid").
+//Only checks that the receiver was woken for are used, as otherwise it has been awake (with a fix) all along.
+void gps_adapt(uint8_t valid, uint32_t utc)
 {
-	uint8_t hours = HOU - 24;		//"hours" is the desired hours (need to minus 24 from the incremented total hours).
-	time[HOU_ONES] = hours % 10;		//Set the required value for hour ones.
-	time[HOU_TENS] = hours / 10;		//Set the required value for hour tens.
-	time[DAY_ONES] ++;			//Increment the day ones.
+	int32_t ttff = (int32_t) (utc - gps_wake_at);		//Upper bound on the time to fix (woken to a valid time received).
+
+	if (!gps_cycled)
+	{
+		return;
+	}
+	gps_cycled = FALSE;
 
-	if (time[DAY_ONES] > 9)			//Adjust day tens if ones have incremented above 9 (e.g. day: 09->10)
+	if (!valid)						//No fix yet, so the lead was too short.
+	{
+		gps_wake_lead *= 2;
+	}
+	else if (gps_latency < GPS_FIX_PRESENT_MS)		//The fix was already there, so the lead may be longer than needed.
+	{
+		gps_wake_lead -= (gps_wake_lead / 4);
+	}
+	else if (ttff >= 0)					//The check waited for the fix, so this is the time to fix.
 	{
-		time[DAY_ONES] = 0;		//Set the day ones to zero.
-		time[DAY_TENS] ++;		//Increment the day tens.
+		gps_ttff = (ttff < GPS_WAKE_LEAD_MAX) ? ttff : GPS_WAKE_LEAD_MAX;
+		gps_wake_lead = gps_ttff + GPS_WAKE_MARGIN;
 	}
 
-	if (DAY > 27)				//Asses the offset corrected day.  If it is possible that the month has rolled over...
+	if (gps_wake_lead < GPS_WAKE_LEAD_MIN)
+	{
+		gps_wake_lead = GPS_WAKE_LEAD_MIN;
+	}
+	else if (gps_wake_lead > GPS_WAKE_LEAD_MAX)
 	{
-		rollover_days();		//Check and correct (if required) by running the rollover days.
+		gps_wake_lead = GPS_WAKE_LEAD_MAX;
 	}
 }
 
-//This function is called when offset corrected time requires the local month to be the month prior to UTC month.
-void rollunder_days(void)
+//Count the seconds elapsed (from the RTC, so seconds missed by a long sync are counted) and the seconds the receiver was awake.
+//The modelled average current is latched every POWER_HOUR seconds.
+void power_service(void)
 {
-	//Corrected day value depends on the month being rolled down to.
-	switch (MON)
+	uint32_t utc = local_to_utc(&time);
+	int32_t elapsed = (int32_t) (utc - power_last);
+
+	if ((elapsed < 0) || (elapsed > POWER_STEP_MAX))	//First call, or the RTC has been re-set.
 	{
-		//In cases where the previous month has 31 days.
-		case FEB:
-		case APR:
-		case JUN:
-		case AUG:
-		case SEP:
-		case NOV:
-			time[DAY_TENS] = 3;
-			time[DAY_ONES] = 1;
-		break;
-		//In cases where the previous month has 30 days.
-		case MAY:
-		case JUL:
-		case OCT:
-		case DEC:
-			time[DAY_TENS] = 3;
-			time[DAY_ONES] = 0;
-		break;
-		//In case of March where the previous month has 28 or 29 days.
-		case MAR:
-			time[DAY_TENS] = 2;
-			time[DAY_ONES] = 9;		//Assume leap year.
-			if (YEA % 4)			//If it's not a leap year...
-			{
-				time[DAY_ONES] --;	//Correct for no leap day.
-			}
-		break;
-		//In case of January where the previous month requires a year rollunder.
-		case JAN:
-			time[DAY_TENS] = 3;
-			time[DAY_ONES] = 1;
-			time[YEA_ONES] --;		//Decrement year ones.
-			if (time[YEA_ONES] > 9)		//If the year ones has rolled under zero (unsigned integer actually rolls over to 255)...
-			{
-				time[YEA_ONES] = 9;	//Set the year ones to 9.
-				time[YEA_TENS] --;	//Decrement the year tens.
-			}
-		break;
+		elapsed = 1;
+	}
+	power_last = utc;
+
+	if (!gps_awake && ((int32_t) (utc - gps_wake_at) >= 0))	//The receiver's backup duration has expired, so it has woken by itself.
+	{
+		gps_awake = TRUE;
+		usart_tx_hold(FALSE);				//Output no longer wakes it early.
+	}
+
+	power_seconds += elapsed;
+	if (gps_awake)
+	{
+		power_gps_seconds += elapsed;
+	}
+	if (power_seconds >= POWER_HOUR)
+	{
+		power_last_hour = power_model(power_gps_seconds, power_seconds);
+		power_seconds = 0;
+		power_gps_seconds = 0;
 	}
 }
 
-//This function is called when offset corrected time may possibly require the local month to be the month after the UTC month.
-void rollover_days(void)
+//Modelled average board current (uA) over "seconds", of which the receiver was awake for "gps_seconds".  Over an hour this is the charge in uAh.
+uint32_t power_model(uint16_t gps_seconds, uint16_t seconds)
 {
-	//Corrected day value depends on the month being rolled down to.
-	switch (MON)
+	uint32_t current = POWER_BOARD_UA + ((POWER_DISPLAY_UA * ((2 * intensity) + 1)) / 32);	//MAX7219 duty cycle is (2 * intensity + 1) / 32.
+
+	if (seconds)
 	{
-		//In cases where the month has 31 days.
-		case JAN:
-		case MAR:
-		case MAY:
-		case JUL:
-		case AUG:
-		case OCT:
-			if (DAY == 32)
-			{
-				time[DAY_TENS] = 0;
-				time[DAY_ONES] = 1;
-				time[MON_ONES] ++;
-			}
-		break;
-		//In cases where the month has 30 days.
-		case APR:
-		case JUN:
-		case NOV:
-			if (DAY == 31)
+		current += (((uint32_t) gps_seconds * POWER_GPS_ON_UA) + ((uint32_t) (seconds - gps_seconds) * POWER_GPS_BACKUP_UA)) / seconds;
+	}
+	return(current);
+}
+
+//Record the outcome of a sync attempt in the sync log kept in the ds3234 battery-backed SRAM.
+//The record is timestamped (UTC) from the RTC, so this should be called after the RTC has been re-written.
+void log_sync(uint8_t outcome, int32_t error)
+{
+	sync_log_record record;
+	rtc_time rtc_now;
+
+	rtc_get_time(&rtc_now);
+	record.timestamp = local_to_utc(&rtc_now);
+
+	record.error = clamp_int16(error);	//Clamp the error to fit the record.
+	record.latency = (gps_latency < 2550) ? (gps_latency / 10) : 255;	//Latency is recorded in units of 10ms.
+	record.outcome = outcome;
+	sync_outcome = outcome;
+
+	sync_log_add(&record, drift, resync_interval);
+}
+
+//Collect received command characters, then if "run" is set, run a pending command or transmit the next record requested by "log".
+//Nothing is run unless the transmit buffer has room for the longest reply, so the handlers never wait for the serial port.
+//Each handler does a fixed, small amount of work (at most one eeprom settings save or one RTC/SRAM burst).
+void console_service(uint8_t run)
+{
+	char *line = console_poll();
+	sync_log_record record;
+
+	if (!run || (usart_tx_space() < CONSOLE_REPLY_LENGTH))
+	{
+		return;
+	}
+
+	if (line)
+	{
+		if (!gps_awake)
+		{
+			gps_wake();		//The reply would be discarded while the receiver is in backup mode (see gps_sleep()).
+			gps_cycled = FALSE;	//Woken early, so the next check can't measure the time to fix.
+		}
+		console_command(line);
+		console_done();
+	}
+#ifdef PROFILE
+	else if (console_profile_next < (PROFILE_PROBES * 2))
+	{
+		if (console_profile_next & 1)
+		{
+			profile_print_histogram(console_profile_next / 2);
+		}
+		else
+		{
+			profile_print_stats(console_profile_next / 2);
+		}
+		console_profile_next++;
+	}
+#endif
+	else if (console_log_next < console_log_end)
+	{
+		sync_log_read(console_log_next++, &record);
+		sync_log_print_record(&record);
+		if (console_log_next == console_log_end)
+		{
+			usart_print_string("\r\n");
+		}
+	}
+}
+
+//Run a console command line: a command word followed by up to two numbers (decimal, or hex with a leading 0x), separated by spaces.
+//	offset [n]		Get the UTC offset, or select the fixed offset zone (tenths of an hour, multiple of 5 from -120 to 120).
+//	zone [n]		Get/set the time zone (0 to ZONE_COUNT - 1), its name, UTC offset and next transition (UTC).
+//				Selecting a zone re-sets the RTC to its offset and re-syncs the clock.
+//	intensity [n]		Get/set the display intensity (0 to 15).
+//	mode [n]		Get/set the display mode (0 to MODE_COUNT - 1, except modes needing the tick if RTC_SQW_WIRED is 0).
+//	zda [n]			Get/set (1 or 0) the ZDA sentence transmitted at the start of each second (only 0 if RTC_SQW_WIRED is 0).
+//	sync			Sync the RTC to the GPS now.
+//	counters		Sync outcome, error (s), drift (ppm, -2147483648 until measured), interval (min), minutes since check, GPS latency (ms),
+//				rx frame errors, rx overruns, rx buffer full, telemetry dropped, render cycles, tick idle (100us),
+//				ZDA backlog (bytes), ZDA dropped.
+//	osccal			OSCCAL value and the CPU clock error (ppm) before and after the last calibration search, and the latest.
+//				The errors stay at 0 if RTC_SQW_WIRED is 0, as nothing is measured.
+//	ram			SRAM used by static variables and SRAM never reached by the stack since reset (bytes).
+//	power			GPS awake, wake-up lead (s), last time to fix (s), seconds awake of seconds counted this hour, modelled current
+//				(uA) this hour so far and over the last full hour (i.e. uAh per hour, 0 until an hour has been counted).
+//	reset			Cause of the last reset (MCUSR bits: 1 power-on, 2 reset pin, 4 brown-out, 8 watchdog) and watchdog resets.
+//	log			Transmit the sync log.
+//	profile [0]		Transmit the cycle profiler results (if compiled in), or clear them.
+//	rtc a [n]		Read n (default 1) RTC registers from address a (hex).
+void console_command(char *line)
+{
+	char *name = strtok(line, " ");
+	char *argument = strtok(NULL, " ");
+	char *extra = strtok(NULL, " ");
+	int16_t value = 0;
+	int16_t count = 1;
+	uint8_t valid = ((!argument || console_number(argument, &value)) && (!extra || console_number(extra, &count)));
+
+	usart_print_string("\r\n");
+	if (!name || !valid)
+	{
+		usart_print_string("?");
+	}
+	else if (!strcmp_P(name, PSTR("offset")))
+	{
+		if (argument && ((value % 5) || (value > 120) || (value < -120)))
+		{
+			usart_print_string("?");
+		}
+		else
+		{
+			if (argument && (ZONE_FROM_OFFSET(value) != zone))
 			{
-				time[DAY_TENS] = 0;
-				time[DAY_ONES] = 1;
-				time[MON_ONES] ++;
+				zone = ZONE_FROM_OFFSET(value);
+				zone_apply();			//Re-set the RTC and save the new zone.
+				sync_requested = TRUE;		//Re-sync with the new offset (as when the zone mode is left).
 			}
-		break;
-		//In case of September with 30 days and the following month requires incrementing month tens (SEP->OCT:09->10)
-		case SEP:
-			if (DAY == 31)
+			usart_print_string("offset=");
+			usart_print_int(offset);
+		}
+	}
+	else if (!strcmp_P(name, PSTR("zone")))
+	{
+		if (argument && ((value < 0) || (value >= ZONE_COUNT)))
+		{
+			usart_print_string("?");
+		}
+		else
+		{
+			if (argument && (value != zone))
 			{
-				time[DAY_TENS] = 0;
-				time[DAY_ONES] = 1;
-				time[MON_TENS] = 1;
-				time[MON_ONES] = 0;
+				zone = value;
+				zone_apply();			//Re-set the RTC and save the new zone.
+				sync_requested = TRUE;		//Re-sync with the new offset (as when the zone mode is left).
 			}
-		break;
-		//In case of February where the month has 28 or 29 days.
-		case FEB:
-			if ( (DAY > 28) && (YEA % 4) )	//If days > 28 and it's not a leap year.
+			usart_print_string("zone=");
+			usart_print_uint(zone);
+			usart_print_string(" ");
+			zone_print_name(zone);
+			usart_print_string(" offset=");
+			usart_print_int(offset);
+			usart_print_string(" next=");
+			usart_print_uint(zone_next);
+		}
+	}
+	else if (!strcmp_P(name, PSTR("intensity")))
+	{
+		if (argument && ((value < 0) || (value > 15)))
+		{
+			usart_print_string("?");
+		}
+		else
+		{
+			if (argument && (value != intensity))
 			{
-				time[DAY_TENS] = 0;
-				time[DAY_ONES] = 1;
-				time[MON_ONES] ++;
+				intensity = value;
+				sev_seg_set_intensity(intensity);
+				settings_save();
 			}
-			else if (DAY > 29)		//It must be a leap year.
+			usart_print_string("intensity=");
+			usart_print_uint(intensity);
+		}
+	}
+	else if (!strcmp_P(name, PSTR("mode")))
+	{
+		if (argument && ((value < 0) || (value >= (int16_t) MODE_COUNT) || !mode_available(value)))
+		{
+			usart_print_string("?");
+		}
+		else
+		{
+			if (argument)
 			{
-				time[DAY_TENS] = 0;
-				time[DAY_ONES] = 1;
-				time[MON_ONES] ++;
+				mode = value;			//poll() switches to the new mode (and saves it if it is restorable).
 			}
-		break;
-		//In case of December where the next  month requires a year rollover.
-		case DEC:
-			time[DAY_TENS] = 0;
-			time[DAY_ONES] = 1;
-			time[YEA_ONES] ++;		//Increment year ones.
-			if (time[YEA_ONES] > 9)		//If the year ones has rolled over max valid value...
+			usart_print_string("mode=");
+			usart_print_uint(mode);
+		}
+	}
+	else if (!strcmp_P(name, PSTR("zda")))
+	{
+		if (argument && ((value < 0) || (value > RTC_SQW_WIRED)))	//The sentence is sent by the tick.
+		{
+			usart_print_string("?");
+		}
+		else
+		{
+			if (argument)
 			{
-				time[YEA_ONES] = 0;	//Set the year ones to 0.
-				time[YEA_TENS] ++;	//Increment the year tens.
+				nmea_output = value;		//Takes effect from the next pre-rendered second.
 			}
-		break;
+			usart_print_string("zda=");
+			usart_print_uint(nmea_output);
+		}
+	}
+	else if (!strcmp_P(name, PSTR("sync")))
+	{
+		sync_requested = TRUE;
+		usart_print_string("sync");
+	}
+	else if (!strcmp_P(name, PSTR("counters")))
+	{
+		usart_errors errors;
+
+		usart_get_errors(&errors);
+		usart_print_uint(sync_outcome);
+		usart_print_string(",");
+		usart_print_int(resync_error);
+		usart_print_string(",");
+		usart_print_int(drift);
+		usart_print_string(",");
+		usart_print_uint(resync_interval);
+		usart_print_string(",");
+		usart_print_uint(resync_minutes);
+		usart_print_string(",");
+		usart_print_uint(gps_latency);
+		usart_print_string(",");
+		usart_print_uint(errors.frame);
+		usart_print_string(",");
+		usart_print_uint(errors.overrun);
+		usart_print_string(",");
+		usart_print_uint(errors.full);
+		usart_print_string(",");
+		usart_print_uint(telemetry_dropped);
+		usart_print_string(",");
+		usart_print_uint(render_cycles);
+		usart_print_string(",");
+		usart_print_uint(tick_idle);
+		usart_print_string(",");
+		usart_print_uint(nmea_backlog());
+		usart_print_string(",");
+		usart_print_uint(nmea_dropped());
+	}
+	else if (!strcmp_P(name, PSTR("osccal")))
+	{
+		usart_print_string("osccal=0x");
+		usart_print_hex(OSCCAL);
+		usart_print_string(" before=");
+		usart_print_int(calibration_before);
+		usart_print_string(" after=");
+		usart_print_int(calibration_after);
+		usart_print_string(" error=");
+		usart_print_int(calibration_error);
+	}
+	else if (!strcmp_P(name, PSTR("ram")))
+	{
+		usart_print_string("static=");
+		usart_print_uint(ram_static());
+		usart_print_string(" stack_unused=");
+		usart_print_uint(ram_stack_unused());
+	}
+	else if (!strcmp_P(name, PSTR("power")))
+	{
+		usart_print_string("gps=");
+		usart_print_uint(gps_awake);
+		usart_print_string(" lead=");
+		usart_print_uint(gps_wake_lead);
+		usart_print_string(" ttff=");
+		usart_print_uint(gps_ttff);
+		usart_print_string(" awake=");
+		usart_print_uint(power_gps_seconds);
+		usart_print_string("/");
+		usart_print_uint(power_seconds);
+		usart_print_string(" current=");
+		usart_print_uint(power_model(power_gps_seconds, power_seconds));
+		usart_print_string(" last_hour=");
+		usart_print_uint(power_last_hour);
+	}
+	else if (!strcmp_P(name, PSTR("reset")))
+	{
+		warm_print();
+	}
+#ifdef PROFILE
+	else if (!strcmp_P(name, PSTR("profile")) && (!argument || !value))
+	{
+		if (argument)
+		{
+			profile_clear();
+			usart_print_string("cleared");
+		}
+		else
+		{
+			usart_print_string("Profile (id,count,min,mean,max cycles then histogram by power of two)");
+			console_profile_next = 0;	//The lines are transmitted one per call to console_service().
+		}
+	}
+#endif
+	else if (!strcmp_P(name, PSTR("log")))
+	{
+		sync_log_print_header();
+		console_log_next = 0;			//The records are transmitted one per call to console_service().
+		console_log_end = sync_log_count();
+	}
+	else if (!strcmp_P(name, PSTR("rtc")) && argument &&
+		 (value >= 0) && (count > 0) && (count <= 8) && ((value + count) <= RTC_REGISTERS))
+	{
+		uint8_t registers[8];
+
+		rtc_transfer(value, NULL, registers, count);	//Burst read (register address auto-increments).
+		for (uint8_t i = 0; i < count; i++)
+		{
+			usart_print_hex(value + i);
+			usart_print_string("=");
+			usart_print_hex(registers[i]);
+			usart_print_string(" ");
+		}
+	}
+	else
+	{
+		usart_print_string("?");
 	}
 }
 
-//Allow the UTC offset to be adjusted by pressing the "Sync" button.  Valid UTC offsets are in half-hour increments from -11.5 to 12.0.
-//(Note, to avoid using floats, the actual offset value is an integer from -120 to 120)
-void get_intensity(void)
+//Clamp a value to the int16_t range.
+int16_t clamp_int16(int32_t value)
 {
-	sev_seg_all_clear();			//Clear all digits to prevent artifacts from previous mode.
-
-	//Enter a loop that will continuously refresh the display and allow adjustment of the offset.
-	while (mode == MODE_5_INTENSITY)					//Run the following loop until the mode is changed.
+	if (value > INT16_MAX)
 	{
-		sev_seg_set_word(intensity_text, sizeof(intensity_text));	//Display the psuedo-test "IntEnSIty" on the left.
-		sev_seg_display_int(intensity);					//Display the current intensity integer value om the right.
-		//PLACEHOLDER - Call function to set the brightness level.
+		return(INT16_MAX);
 	}
+	else if (value < INT16_MIN)
+	{
+		return(INT16_MIN);
+	}
+	return(value);
+}
 
-	sev_seg_decode_mode(DECODE_CODE_B);	//Return all digits to Code B decode mode.
-
-	if (intensity != eeprom_read_byte(INTENSITY_EEPROM_ADDRESS))		//If the mode has changed and the intensity is different to what's in eeprom...
+//Send a telemetry status record.  Called once a second by the time display modes.
+//The frame is only queued if the USART transmit buffer has room for all of it, so this never waits for the serial port.
+void telemetry_emit(void)
+{
+	telemetry_status status;
+	usart_errors errors;
+
+	usart_get_errors(&errors);
+
+	status.sequence = telemetry_sequence++;
+	status.seconds = time.seconds;
+	status.outcome = sync_outcome;
+	status.error = clamp_int16(resync_error);
+	status.drift = clamp_int16(drift);
+	status.interval = resync_interval;
+	status.rx_frame = errors.frame;
+	status.rx_overrun = errors.overrun;
+	status.rx_full = errors.full;
+	status.dropped = telemetry_dropped;
+	status.render_cycles = render_cycles;
+	status.idle = tick_idle;
+	status.nmea_backlog = nmea_backlog();
+	status.stack_unused = ram_stack_unused();
+	status.clock_error = clamp_int16(calibration_error);
+
+	if (!telemetry_send(TELEMETRY_STATUS, &status, sizeof(status)))
 	{
-		eeprom_update_byte((uint8_t *) INTENSITY_EEPROM_ADDRESS, intensity);	//Record the new value to eeprom.
+		telemetry_dropped++;
 	}
 }
 
+//Apply the UTC offset to the time received from the GPS (the global "time").
+//Offset range is -120 to +120 whereby actual offset in half-hour increments correspond to values of 5 (e.g. -120:-12.0hrs, +65:+6.5hrs)
+//The time is converted through seconds since epoch, so every carry (hours, date, month, year and leap day) and the day of the week come from
+//the same table as calculate_epoch().  This only runs when the RTC is set, not per frame.
+void apply_offset(void)
+{
+	utc_to_local(calculate_epoch(&time), &time);
+}
+
 //Increment the offset value and rollover when maximum value is exceeded.
 //This function is called when the "Sync" button is pressed only when running Mode 4.
 void cycle_intensity(void)
 {
 	intensity ++;								//Increment intensity.
-	if (intensity > 15)							//If maximum valid value (9) is exceeded...
+	if (intensity > 15)							//If maximum valid value (15) is exceeded...
 	{
-		intensity = 0;							//Rollover to minimum valid value (1).
-		sev_seg_write_byte(SEV_SEG_DIGIT_14, SEV_SEG_CODEB_BLANK);	//Changing the intensity from 15 to zero requires the tens digit to be cleared.
+		intensity = 0;							//Rollover to minimum valid value (0).
 	}
 
 	sev_seg_set_intensity(intensity);					//Every time the intensity value changes, actually re-set the intensity.
 }
 
 
-//This function will be passed a word (encoded as required by the MAX7219 drivers) and the number of characters in that word.
+//This function will be passed a word (encoded as required by the MAX7219 drivers and stored in flash) and the number of characters in that word.
 //Starting from the left most digit (0) all digits required to display the word will be set to manual decode mode.
 //All other digits remain in code B decode mode (assume all digits in code B mode when function is called).
 //Note, if required, code B mode must be restored manually after this function is complete ("sev_seg_decode_mode(DECODE_CODE_B)").
-void sev_seg_set_word(uint8_t *word, uint8_t word_length)
+void sev_seg_set_word(const uint8_t *word, uint8_t word_length)
 {
+	uint8_t decode[SEV_SEG_CHIPS];	//Decode mode bits for each chip.
+
 	//Set the required number of digits to manual decode mode (0) leaving unrequired digits in code B mode (1).
-	sev_seg_write_byte(SEV_SEG_DECODE_MODE_A, 0xFF << (word_length));	//Set the decode mode bits corresponding to digits 0-7 (driver A).
-	sev_seg_write_byte(SEV_SEG_DECODE_MODE_B, 0xFF << (word_length - 8));	//Set the decode mode bits corresponding to digits 8-15 (driver B).
+	for (uint8_t c = 0; c < SEV_SEG_CHIPS; c++)
+	{
+		decode[c] = SEV_SEG_DECODE_CHIP(word_length, c);
+	}
+	sev_seg_write_row(SEV_SEG_DECODE_MODE, decode);		//Set the decode mode of every chip in one LOAD cycle.
 
-	//Note, to increment through all digits, going from DIGIT_7 (0x08) to DIGIT_8 (0x81) requires an addition of 0x78.
-	//Therefore, adding (0x78 multiplied by i/8) only applies the addition of 0x78 for i greater than 8 (i is an integer so remainders are ignored).
 	for (uint8_t i = 0; i < word_length; i++)
 	{
-		sev_seg_write_byte(SEV_SEG_DIGIT_0 + i + (0x78 * (i/8)), word[i]);	//Display the character.
+		sev_seg_write_digit(i, pgm_read_byte(&word[i]));	//Display the character (read from flash).
 	}
 }
 
 //Display "pseudo-text" on the seven-segment display.
 //Assume all digits currently operating in Code B decode mode when this function is entered.
-void sev_seg_flash_word(uint8_t *word, uint8_t word_length, uint16_t duration_ms)
+void sev_seg_flash_word(const uint8_t *word, uint8_t word_length, uint16_t duration_ms)
 {
 	sev_seg_all_clear();			//Clear all digits (only works while in code b decode mode).
 	sev_seg_power(OFF);			//Turn off both display drivers (prevents artifacts when changing to manual decode).
@@ -679,6 +1662,7 @@ void sev_seg_flash_word(uint8_t *word, uint8_t word_length, uint16_t duration_ms
 
 	while(duration_ms--)			//Keep the "text" displayed for "duration_ms" milliseconds (can't pass variables directly to _delay_ms()).
 	{
+		watchdog_wait();
 		_delay_ms(1);
 	}
 
@@ -686,6 +1670,10 @@ void sev_seg_flash_word(uint8_t *word, uint8_t word_length, uint16_t duration_ms
 	sev_seg_decode_mode(DECODE_CODE_B);	//Switch back into Code B decode mode for all digits.
 	sev_seg_all_clear();			//Clear all digits (note this function only works in Code B mode).
 	sev_seg_power(ON);			//Switch the display back on (will be blank).
+
+	sev_seg_unstage();			//A frame staged by poll() no longer describes a change from what is shown.
+	nmea_unstage();				//Nor does its time sentence describe the next second if the RTC has been re-written.
+	display_refresh = TRUE;			//poll() must re-send the current mode's decode mode and static digits.
 }
 
 //Simple startup animation that displays "ISO-8601" then scans the decimal point (DP) right to left then back a few times.
@@ -698,18 +1686,18 @@ void sev_seg_startup_ani(void)
 	//The following nested loops scans the decimal point (DP) right to left then back a few times.
 	for (j = 0; j < 5; j++)		//Repeat main animation sequence 5 times.
 	{
-		//Note, to increment through all digits, going from DIGIT_7 (0x08) to DIGIT_8 (0x81) requires an addition of 0x78.
-		//Therefore, adding (0x78 multiplied by i/8) only applies the addition of 0x78 for i greater than 8 (i is an integer so remainders are ignored).
-		for (i = 0; i < 16; i++)	//Increment the following through all 16 digits 0 to 15 (left to right).
+		for (i = 0; i < SEV_SEG_DIGITS; i++)	//Increment the following through all digits (left to right).
 		{
 			//Turn on the decimal point for the current digit.
-			sev_seg_write_byte(SEV_SEG_DIGIT_0 + i + (0x78 * (i/8)), SEV_SEG_CODEB_BLANK | SEV_SEG_DP);
+			sev_seg_write_digit(i, SEV_SEG_CODEB_BLANK | SEV_SEG_DP);
+			watchdog_wait();
 			_delay_ms(20);			//Pause for milliseconds.
 			sev_seg_all_clear();		//Clear the DP (and all digits).
 		}
-		for (i = 15; i < 255; i--)	//Decrement the following through all 16 digits 15 to 0 (right to left).
+		for (i = (SEV_SEG_DIGITS - 1); i < SEV_SEG_DIGITS; i--)	//Decrement the following through all digits (right to left).
 		{
-			sev_seg_write_byte(SEV_SEG_DIGIT_0 + i + (0x78 * (i/8)), SEV_SEG_CODEB_BLANK | SEV_SEG_DP);
+			sev_seg_write_digit(i, SEV_SEG_CODEB_BLANK | SEV_SEG_DP);
+			watchdog_wait();
 			_delay_ms(20);			//Pause for milliseconds.
 			sev_seg_all_clear();		//Clear the DP (and all digits).
 		}
@@ -721,10 +1709,26 @@ int main(void)
 	hardware_init();	//initialise the hardware peripherals.
 
 	settings_init();	//Initialise (validate and set) system settings stored in eeprom.
+	zone_apply();		//Correct the RTC if daylight saving started or ended while the clock was off.
+
+	sync_log_init(&drift, &resync_interval, RESYNC_INTERVAL_MIN, RESYNC_INTERVAL_MAX);	//Load the sync log and warm-start the re-sync scheduler from the last drift measurements.
 
-	sev_seg_startup_ani();	//Run through the start-up animation.
+	usart_print_string("\r\n");
+	warm_print();		//Record the reset cause over serial.
+	gps_wake();		//The receiver may have been left in backup mode before the reset.
 
-	attempt_sync();		//Attempt to sync the RTC time with GPS data.
+	if (warm_restore())	//Reset by the watchdog: the RTC still has the time, so show it straight away (within a few milliseconds).
+	{
+		BUTTONS_ENABLE;	//Otherwise enabled at the end of the first sync attempt.
+	}
+	else
+	{
+		sync_log_dump();	//Transmit the sync log over serial.
+
+		sev_seg_startup_ani();	//Run through the start-up animation.
+
+		attempt_sync();		//Attempt to sync the RTC time with GPS data.
+	}
 
 	while (1)		//Main infinite loop.
 	{
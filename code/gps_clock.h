@@ -3,78 +3,248 @@
 #include <avr/interrupt.h>	//Requires to use interrupt macros such ase sei();
 #include <util/delay.h>		//From the standard AVR libraries - used to call delay_ms() and delay_us() functions.
 #include <avr/eeprom.h>		//Required to easil utilise eeprom for variable storage that survives a power-cycle,
+#include <avr/pgmspace.h>	//Required to store constant tables in flash (PROGMEM) rather than copying them to SRAM at startup.
+#include <util/crc16.h>		//Provides the CRC-8 function used to protect the settings stored in eeprom.
 #include <stdlib.h>		//Included to utilise abs() function for easily converting a negative value to a positive (absolute value).
+#include <stddef.h>		//Included to utilise offsetof() for finding the position of a member within a structure.
+#include <string.h>		//Included to utilise memcpy() for copying the static digit image of a display mode.
 #include "usart.h"		//For USART serial communications.
+#include "board.h"		//Pin assignments and device configuration.
 #include "spi.h"		//For SPI communications.
 #include "max7219.h"		//For max7219 (sev-seg driver) functions.
 #include "ds3234.h"		//For ds3234 (real-time clock) functions.
+#include "sync_log.h"		//For the sync log kept in the ds3234 battery-backed SRAM.
+#include "telemetry.h"		//For the binary telemetry stream.
+#include "console.h"		//For the serial command console.
+#include "nmea.h"		//For the NMEA time sentence re-transmitted for downstream devices.
+#include "ram.h"		//For the stack high-water mark.
+#include "cycles.h"		//For the 32-bit CPU cycle count.
+#include "profile.h"		//For the cycle profiler (compiled in with "make PROFILE=1").
+#include "zone.h"		//For the time zone rules (fixed offsets and daylight saving).
+#include "watchdog.h"		//For the watchdog supervisor and the reset cause.
+#include "ubx.h"		//For the UBX power management messages sent to the GPS receiver.
+#include "calendar.h"		//For the epoch and local time conversions.
+#include "resync.h"		//For the background re-sync scheduler.
 
 //True/false used to determine succeful sync of time from GPS.
 #define TRUE	1
 #define FALSE	0
 
-//Following definitions will be used to initialise and read the buttons.
-#define BUTTON_DDR			DDRC		//DDRC: Data Direction Register C - For setting IO to input or output at port C.
-#define BUTTON_PORT			PORTC		//PORTC: Port C - For writing to IO.
-#define BUTTON_PINS			PINC		//PINC: Pin C - For reading from IO.
-#define BUTTON_PCIE			PCIE1		//PCIE1: Pin Change Interrupt Enable 1 - For enabling interrupts on IO level change.
-#define BUTTON_PCMSK			PCMSK1		//PCMSK1: Pin Change Mask Register 1 - For masking which IO lines to trigger interrupt.
-#define BUTTON_MODE			PC0		//PC0: PCINT8
-#define BUTTON_SYNC			PC1		//PC1: PCINT9
-#define BUTTON_PCI_VECTOR		PCINT1_vect	//PCINT1: Pin-Change Interrupt 1 - Define the interrupt sub-routine vector function name.
+//Following definitions will be used to initialise and read the buttons (pins are defined in board.h).
 #define BUTTON_DEBOUNCE_DURATION	100		//Define the duration in ms to wait to avoide button "bounce".
 #define BUTTONS_ENABLE			PCICR |= (1 << BUTTON_PCIE);	//Enable Pin-Change Interrupt for pin-change int pins PCINT[8-14].
 #define BUTTONS_DISABLE			PCICR &= !(1 << BUTTON_PCIE);	//Disable Pin-Change Interrupt for pin-change int pins PCINT[8-14].
 
-//Allocate an address within the AVR's eeprom to store the GMT time offset value so that the offset is retained after a power-cycle.
-//Valid value for the offset is a multiple of 5 from -120 to +120 which represents an offset range of -12.0 hrs to +12.0 hours in 0.5 hour increments.
-//Note, "(uint8_t *)" is required to typecast an integer pointer as that is what's expected by the function eeprom_read_byte() expects.
-//Without this typecast, a warning will be generated for any non-zero address.
-#define OFFSET_EEPROM_ADDRESS (uint8_t *) 5	//Arbitrary value, just keep it different to INTENSITY_EEPROM_ADDRESS.
+//Settings that are retained after a power-cycle are stored in the AVR's eeprom as a single block (settings_block) protected by a CRC-8.
+//The block is loaded once at boot (a single eeprom_read_block() of all slots) and cached in RAM.
+//To spread wear, each save is written to the next of SETTINGS_SLOTS slots with an incremented sequence number.
+//At boot, the valid slot (correct CRC and version) with the newest sequence number is loaded.
+#define SETTINGS_EEPROM_ADDRESS	(settings_block *) 16	//Address of the first slot.  Clear of the legacy addresses below.
+#define SETTINGS_SLOTS		8			//Number of slots the saves are rotated across.
+#define SETTINGS_VERSION	2			//Increment if the layout of settings_block changes (old blocks will then be ignored).
+#define SETTINGS_VERSION_1	1			//Version 1 blocks (no zone) are imported once if no valid block exists.
+#define SETTINGS_UNCALIBRATED	0xFF			//Calibration value indicating the factory OSCCAL value should be left alone.
 
-//Allocate an address within the AVR's eeprom to store the intensity (brightness) value so that the selected intensity is retained after a power-cycle.
-//Valid value for the intensity is 0 to 15 as per the datasheet.
-//Note, "(uint8_t *)" is required to typecast an integer pointer as that is what's expected by the function eeprom_read_byte() expects.
-//Without this typecast, a warning will be generated for any non-zero address.
-#define INTENSITY_EEPROM_ADDRESS (uint8_t *) 6	//Arbitrary value, just keep it different to OFFSET_EEPROM_ADDRESS.
+//Earlier firmware stored the offset and intensity as individual bytes at these addresses.  They are imported once if no valid settings block
+//(of either version) exists.
+#define LEGACY_OFFSET_EEPROM_ADDRESS	(uint8_t *) 5
+#define LEGACY_INTENSITY_EEPROM_ADDRESS	(uint8_t *) 6
+
+//Default values used when no valid settings are found.
+#define DEFAULT_OFFSET		0
+#define DEFAULT_ZONE		ZONE_UTC
+#define DEFAULT_INTENSITY	8
+#define DEFAULT_MODE		MODE_1B_ISO
+
+//Settings block stored in eeprom.  The CRC must be the last byte as it is calculated over all preceding bytes.
+typedef struct
+{
+	uint8_t sequence;	//Incremented with every save.  Used to find the newest slot.
+	uint8_t version;	//SETTINGS_VERSION.
+	int8_t offset;		//UTC time offset the RTC was last set with (multiple of 5 from -120 to 120, i.e. -12.0 to +12.0 hours).
+	uint8_t intensity;	//Display intensity (brightness) 0 to 15.
+	uint8_t mode;		//Display mode selected at boot.
+	uint16_t baud;		//USART baud rate (hundreds of bits/second) used for the GPS.
+	uint8_t calibration;	//OSCCAL value for the internal RC oscillator, or SETTINGS_UNCALIBRATED.
+	uint8_t zone;		//Time zone (see zone.h) that sets the offset.
+	uint8_t crc;		//CRC-8 of all preceding bytes.
+} settings_block;
+
+//Version 1 of the settings block (before the time zone was added).  Only read, to import the settings of earlier firmware.
+typedef struct
+{
+	uint8_t sequence;
+	uint8_t version;
+	int8_t offset;
+	uint8_t intensity;
+	uint8_t mode;
+	uint16_t baud;
+	uint8_t calibration;
+	uint8_t crc;
+} settings_block_v1;
+
+//State that lets the clock carry on after a watchdog reset without the start-up animation and sync (a warm restart).
+//It is kept in .noinit SRAM, which the C runtime doesn't clear, and survives a reset (but not a power-cycle or brown-out).  It is refreshed
+//once a second by poll() and only used after a watchdog reset if its magic number and CRC are intact.
+#define WARM_MAGIC		0x5A	//Arbitrary value used to identify valid warm restart state (SRAM contents are random after power-on).
+
+typedef struct
+{
+	uint8_t magic;			//WARM_MAGIC if valid.
+	uint8_t mode;			//Display mode shown (including modes that aren't restored from eeprom).
+	uint8_t nmea_output;		//ZDA sentence output switched on.
+	uint8_t sync_outcome;		//Outcome of the last sync attempt.
+	uint16_t resync_interval;	//Re-sync scheduler state.
+	uint16_t resync_minutes;
+	int32_t resync_error;
+	int32_t drift;
+	uint32_t resync_set;
+	uint8_t resync_aligned;
+	uint16_t gps_latency;
+	uint8_t telemetry_sequence;	//Telemetry carries on from the last sequence number.
+	uint8_t telemetry_dropped;
+	uint16_t gps_wake_lead;		//GPS wake-up schedule (see below).
+	uint16_t gps_ttff;
+	uint8_t resets;			//Watchdog resets since any other kind of reset (power-on, brown-out or reset pin).
+	uint8_t crc;			//CRC-8 of all preceding bytes.
+} warm_state;
+
+//Following definitions are used to read the time from the GPS and to time the start of its second (for the re-sync scheduler, see resync.h).
+#define GPS_GAP_MS		20		//Silence before a byte that marks the start of the receiver's output for a navigation epoch.
+#define GPS_OUTPUT_DELAY_MS	0		//Delay from the start of the UTC second to the receiver's first byte.  Not characterised for the NEO-7
+						//(measure it against the receiver's time pulse), so any delay shows as a constant RTC lag.
+#define GPS_TIMEOUT_MS		2000		//Give up if the GPS is silent for (approximately) this many milliseconds.
+#define GPS_BYTE_LIMIT		2048		//Give up after this many bytes without a valid time (about 2 seconds at 9600 baud), so that a
+						//continuous stream (line noise, wrong baud rate or UBX binary only) can't hold the sync up forever.
+
+//Following definitions are used to power the GPS receiver down between syncs (only if GPS_POWER_SAVE, see board.h for the output it discards).
+//The RTC holds the time between syncs, so after a good sync the receiver is put into backup mode (UBX-RXM-PMREQ) until gps_wake_lead
+//seconds before the next scheduled background check, when it wakes by itself.  A manual sync wakes it straight away.
+//The lead is adapted to the time to fix after waking (a hot start): a check that finds the fix already there shortens it by a quarter, a check
+//that has to wait for the fix measures the time to fix and sets the lead to that plus GPS_WAKE_MARGIN, and a check that fails doubles it.
+#define GPS_WAKE_LEAD_INIT	60		//Seconds the receiver is woken before a scheduled check, at boot.
+#define GPS_WAKE_LEAD_MIN	10		//Shortest lead (seconds).
+#define GPS_WAKE_LEAD_MAX	900		//Longest lead (seconds).
+#define GPS_WAKE_MARGIN		10		//Seconds added to a measured time to fix.
+#define GPS_SLEEP_MIN		120		//The receiver isn't put into backup mode for less than this (seconds).
+#define GPS_FIX_PRESENT_MS	1500		//A check that receives a valid time within this (ms) found the fix already there (NMEA is sent each second).
+
+//Following definitions are used to model the board current, reported by the "power" console command.
+//The figures are typical values from the datasheets (the display depends on the digits lit), so the model shows the effect of the GPS power
+//cycling rather than an exact figure.  Measure the board and adjust them if an absolute figure is needed.
+#define POWER_BOARD_UA		8000		//AVR at 8MHz, RTC and the MAX7219s' own supply current (uA).
+#define POWER_DISPLAY_UA	120000		//Both MAX7219s' segment current at full intensity (uA), scaled by the duty cycle (2 * intensity + 1) / 32.
+#define POWER_GPS_ON_UA		30000		//NEO-7 acquiring or tracking (uA).
+#define POWER_GPS_BACKUP_UA	100		//NEO-7 in backup mode (uA).
+#define POWER_HOUR		3600		//Seconds in each reported period.
+#define POWER_STEP_MAX		10		//Longer gaps between counted seconds (e.g. the RTC re-set) are counted as one second.
+
+//Following definitions are used by the oscillator calibration.
+//The CPU runs from the internal RC oscillator, which is only accurate to a few percent (skewing the baud rate and every delay).
+//The CPU clock is measured against the RTC square wave (the RTC is a TCXO disciplined by the GPS) over windows of CALIBRATION_SECONDS.
+//After boot, OSCCAL is stepped one value at a time towards F_CPU until the error stops improving, then the best value is kept and saved.
+//The error is still measured every window, and a new search starts if it grows by more than CALIBRATION_RECHECK_PPM (e.g. temperature change).
+//Only if RTC_SQW_WIRED (see board.h).  Otherwise OSCCAL keeps a value saved by earlier firmware or the factory value (+/-10% per the datasheet).
+#define CALIBRATION_SECONDS	8		//Length of a measurement window (seconds).
+#define CALIBRATION_LIMIT_PPM	50000		//Windows with a second further than this from F_CPU (5%) are discarded (e.g. a tick delayed by an ISR).
+#define CALIBRATION_RECHECK_PPM	2000		//Search again if the error grows this much beyond the error after the last search.
+#define CALIBRATION_CYCLES_PER_PPM	((F_CPU / 1000000UL) * CALIBRATION_SECONDS)	//Cycles per window for an error of 1ppm.
+
+//Calibration states.
+#define CALIBRATION_START	0		//Next window measures the error before the search.
+#define CALIBRATION_SEARCH	1		//Each window measures a trial OSCCAL value.
+#define CALIBRATION_MONITOR	2		//Search complete.  Each window checks the error.
+
+//A pre-rendered frame is committed by the RTC square wave interrupt at the start of each second.
+#define TICK_WAIT_US		100		//Poll interval (us) while waiting for the tick.
+#define TICK_TIMEOUT		11000		//Stop pre-rendering if no tick arrives within this many poll intervals (1.1s).
+#define TICK_GUARD		9000		//Console commands only run while waiting for a tick if it is at least 100ms away (poll intervals).
+#define RTC_REGISTERS		0x14		//Number of RTC registers that can be read by the console (0x00 to 0x13).
+#define FRACTION_RATE		100		//Digits showing a fraction of a second are re-written this many times a second (at most).
+#define DIGIT_STALE		0xFF		//Value of a digit in "shown" that isn't known (never equal to a rendered digit).
+#define NMEA_OUTPUT_DEFAULT	FALSE		//Transmit a ZDA sentence at the start of each second (switched at runtime by the "zda" command).
 
 
 //Define the display modes
 //Mode 1 shows the date on the left and the time on the right with two blank segments between them.
 //Mode 2 shows the date and time together with no gap but a blank digit either side of the full date/time.
 //Sub-modes A/B determine if the decimal points will be shown between individual components of the date/time.
+//New modes are added at the end, so the numbers saved in the settings and used by the console "mode" command keep their meaning.
 #define MODE_1A_ISO		0b000	//	|Y Y Y Y M M D D     H H M M S S |	ISO-8601 with date/time separation, no delimiters.
 #define MODE_1B_ISO		0b001	//	|Y Y Y Y.M M.D D.    H H.M M.S S.|	ISO-8601 with date/time separation with delimiters (decimal points).
 #define MODE_2A_ISO		0b010	//	|  Y Y Y Y M M D D H H M M S S   |	ISO-8601 centered, no delimiters.
 #define MODE_2B_ISO		0b011	//	|  Y Y Y Y.M M.D D.H H.M M.S S.  |	ISO-8601 centered with delimiters (decimal points).
 #define MODE_3_EPOCH		0b100	//	|E P O C H   S S S S S S S S S S |	UNIX Epoch time (seconds elapsed since midnight, Jan 1st, 1970).
-#define MODE_4_OFFSET		0b101	//	|O F F S E t             ± # #.# |	Enable setting of the time offset from UTC.
-#define MODE_5_INTENSITY	0b110	//	|I n t E n S I t y           # # |	Enable setting of the time offset from UTC.
-
-//Define array elements for easier identification when pulled from time array.
-#define CEN_TENS  0
-#define CEN_ONES  1
-#define YEA_TENS  2
-#define YEA_ONES  3
-#define MON_TENS  4
-#define MON_ONES  5
-#define DAY_TENS  6
-#define DAY_ONES  7
-#define HOU_TENS  8
-#define HOU_ONES  9
-#define MIN_TENS 10
-#define MIN_ONES 11
-#define SEC_TENS 12
-#define SEC_ONES 13
-#define SIZE_OF_TIME_ARRAY 14
-
-//For readability define integer values determined from BCD values of time elements.
-#define SEC (10*time[SEC_TENS] + time[SEC_ONES])
-#define MIN (10*time[MIN_TENS] + time[MIN_ONES])
-#define HOU (10*time[HOU_TENS] + time[HOU_ONES])
-#define DAY (10*time[DAY_TENS] + time[DAY_ONES])
-#define MON (10*time[MON_TENS] + time[MON_ONES])
-#define YEA (10*time[YEA_TENS] + time[YEA_ONES])
+#define MODE_4_ZONE		0b101	//	|Z O n E           # #   ± # #.# |	Enable selection of the time zone (number and its current offset from UTC).
+#define MODE_5_INTENSITY	0b110	//	|I n t E n S I t y           # # |	Enable setting of the display intensity (brightness).
+#define MODE_6_ORDINAL		0b111	//	|Y Y Y Y - D D D     H H M M S S |	ISO-8601 ordinal date (day of year).
+#define MODE_7_WEEK		0b1000	//	|Y Y Y Y - W W - D   H H M M S S |	ISO-8601 week date (week-numbering year, week, weekday).
+#define MODE_8_HUNDREDTHS	0b1001	//	|Y Y Y Y.M M.D D.H H.M M.S S.s s |	ISO-8601 with hundredths of a second.
+#define MODE_9_EPOCH_MS		0b1010	//	|      E E E E E E E E E E.m m m |	UNIX Epoch time in milliseconds (seconds then thousandths).
+#define MODE_COUNT		(sizeof(mode_table) / sizeof(mode_table[0]))	//Number of modes (rows in mode_table).
+
+//Each mode is described by a row of mode_table (below).  poll() runs every mode with the same loop, so adding a mode means adding a row.
+//The RTC only counts whole seconds, so a fraction of a second is interpolated with the CPU cycle count since the last tick (the start of the
+//second), scaled by the measured length of the last second.  The rest of the frame is pre-rendered and committed by the tick as usual, with
+//the fraction digits at zero.  Between ticks only the digit rows holding the fraction are re-written, each time the displayed value changes.
+//SPI budget (worked out from the code, not yet measured on hardware): a row is one LOAD cycle of 2 bytes per chip (4 bytes, 8us at 4MHz plus
+//about 20us to fill and queue it).  A refresh writes at most 3 rows, so at FRACTION_RATE refreshes a second the bus should be busy for under
+//1% of the time, with interrupts only held off while each frame is claimed.  This matters most in the hundredths mode, so check it there with
+//"make PROFILE=1" and the "profile" command: PROFILE_FRACTION (each refresh), PROFILE_SEV_SEG_CLAIM (interrupts off) and PROFILE_TICK_COMMIT
+//(the tick's commit).
+#define FIELD_UNUSED		0xFF	//Position of a field that isn't displayed by a mode.
+
+//Format of the date displayed by a mode.
+#define DATE_CALENDAR		0	//C C Y Y M M D D (with delimiters if set).
+#define DATE_ORDINAL		1	//Y Y Y Y - D D D
+#define DATE_WEEK		2	//Y Y Y Y - W W - D
+
+//Value displayed (right-aligned) by a mode.  The sync button adjusts the zone and intensity values while they are displayed.
+#define VALUE_NONE		0	//No value.
+#define VALUE_EPOCH		1	//UNIX Epoch time.
+#define VALUE_ZONE		2	//Time zone and its UTC offset (# #   ± # #.#).
+#define VALUE_INTENSITY		3	//Display intensity.
+#define VALUE_EPOCH_MS		4	//UNIX Epoch time, seconds ending just before the fraction digits.
+
+//How often a mode is rendered.
+#define UPDATE_SECOND		0	//Each time the RTC seconds change.
+#define UPDATE_ALWAYS		1	//Continuously (the value is adjusted with the buttons rather than by the RTC).
+
+//Mode flags.
+#define MODE_RESTORE		0b00000001	//Mode is saved and restored at boot (the time display modes).
+#define MODE_TICK		0b00000010	//Mode needs the RTC square wave (the fraction of a second).  Skipped if RTC_SQW_WIRED is 0.
+
+//Layout descriptor for a display mode.
+typedef struct
+{
+	const uint8_t *text;		//Pseudo-text (flash) displayed from digit 0 in manual decode mode.  NULL for none.
+	uint8_t text_length;		//Number of text digits.
+	uint8_t decode[SEV_SEG_CHIPS];	//Precomputed decode mode register value for each chip (manual for the text digits, code B for the rest).
+	uint8_t date_position;		//First digit of the date or FIELD_UNUSED.
+	uint8_t date_format;		//DATE_x.
+	uint8_t time_position;		//First digit of the time (H H M M S S) or FIELD_UNUSED.
+	uint8_t fraction_position;	//First digit of the fraction of a second or FIELD_UNUSED.
+	uint8_t fraction_digits;	//Number of fraction digits (1 to 3, i.e. tenths to thousandths).
+	uint8_t delimiters;		//SEV_SEG_DP to show decimal points between date/time components, otherwise 0.
+	uint8_t value;			//VALUE_x displayed right-aligned.
+	uint8_t update;			//UPDATE_x.
+	uint8_t flags;			//MODE_x flags.
+} mode_layout;
+
+//Calendar fields derived from the local date.  Kept in RAM and only recomputed when the date changes (i.e. at local midnight, or when the
+//RTC is re-written after a sync or an offset change), so the renderers don't repeat the calendar arithmetic every frame.
+typedef struct
+{
+	uint8_t date;			//Local date (BCD, as the RTC) that the fields below were derived from.
+	uint8_t month;			//Includes the century flag.
+	uint8_t year;
+	uint16_t days;			//Days elapsed since 1970.01.01.
+	uint16_t year_full;		//Calendar year (e.g. 2024).
+	uint16_t ordinal;		//Day of the year (1-366).
+	uint16_t week_year;		//ISO week-numbering year.  Differs from the calendar year for a few days around Jan 1st.
+	uint8_t week;			//ISO week (1-53).
+	uint8_t weekday;		//ISO weekday (1=Monday to 7=Sunday).
+} derived_date;
 
 //For readability, define month names in accordance with corrsponding numerical values
 #define JAN  1
@@ -90,108 +260,189 @@
 #define NOV 11
 #define DEC 12
 
-//These definitions are used to make the calculation of epoch UNIX time much more readable.
-//Epoch time (or unix epoch time) is the number of seconds elapsed since 0hrs, January first, 1970.
-#define DAYS_IN_4_YEARS		1461		// = ((365days * 4years) + 1leap-day)
-#define SECONDS_IN_A_DAY	86400		// = 60seconds * 60minutes * 24hours
-#define SECONDS_IN_AN_HOUR	3600		// = 60seconds * 60minutes
-#define SECONDS_IN_A_MINUTE	60
-#define EPOCH_SECONDS_TO_2000	946684800	// = Seconds elapsed from epoch (midnight, Jan 1st, 1970) until midnight, Jan 1st, 2000.
-#define EPOCH_YEAR		(uint32_t) ((10*time[YEA_TENS]) + time[YEA_ONES])	// 0-99		= Years since 2000.
-#define EPOCH_MONTH		(uint32_t) ((10*time[MON_TENS]) + time[MON_ONES])	// 1-12		= Months since start of current year.
-#define EPOCH_DAY		(uint32_t) ((10*time[DAY_TENS]) + time[DAY_ONES])	// 1-31		= Days since start of current month.
-#define EPOCH_HOUR		(uint32_t) ((10*time[HOU_TENS]) + time[HOU_ONES])	// 0-23		= Hours since start of current day.
-#define EPOCH_MINUTE		(uint32_t) ((10*time[MIN_TENS]) + time[MIN_ONES])	// 0-59		= Minutes since start of current hour.
-#define EPOCH_SECOND		(uint32_t) ((10*time[SEC_TENS]) + time[SEC_ONES])	// 0-59		= Seconds since start of current minute.
-
-//The following 2-dimensional array serves as a look-up table to determine the number of days elapsed within the current 4-year block.
-//This is required so that leap-days are included when calculating epoch time.
-//Each element represents the number of days elapsed from the start of the 4-year block to the start of the selected month.
-static uint16_t days_table[4][12] =
-{	//Jan  Feb  Mar  Apr  May  Jun  Jul  Aug  Sep  Oct  Nov  Dec
-	{   0,  31,  60,  91, 121, 152, 182, 213, 244, 274, 305, 335},	//First year (leap year).
-	{ 366, 397, 425, 456, 486, 517, 547, 578, 609, 639, 670, 700},	//Second year.
-	{ 731, 762, 790, 821, 851, 882, 912, 943, 974,1004,1035,1065},	//Third year.
-	{1096,1127,1155,1186,1216,1247,1277,1308,1339,1369,1400,1430},	//Fourth year.
-};
-
 
 ////////////////////////////////////
 //Global Variable Initialisations://
 ////////////////////////////////////
 
-//"mode" is altered via interrupt (pin-change triggered by button press).  Initialisation here sets the display mode at boot.
-uint8_t mode = MODE_1B_ISO;
+//"mode" is altered via interrupt (pin-change triggered by button press).  Initialised from the settings at boot.
+uint8_t mode = DEFAULT_MODE;
 
-//"offset" represents the time offset from UTC.  The GPS data always returns UTC so an offset is required to get local time and allow for DST.
-//Valid offsets are half-hour increments from -120 hours to +12.0 hours.
-//To avoid using floats, offset actually ranges from -120 to 120 and is adjusted in increments of 5 (representing half an hour).
+//"offset" represents the time offset from UTC that the RTC is set to.  The GPS data always returns UTC so an offset is required to get local time.
+//Valid offsets are half-hour increments from -12.0 hours to +12.0 hours.
+//To avoid using floats, offset actually ranges from -120 to 120 in increments of 5 (representing half an hour).
+//Each unit is a tenth of an hour (OFFSET_SECONDS).  Convert with local_to_utc() and utc_to_local() rather than applying it directly.
+//The offset is set by the selected time zone, so it changes by itself when daylight saving starts or ends.
 int8_t offset;	//Value is initialised in the main function by reading the value stored in eeprom.
 
+//"zone" is the selected time zone (see zone.h), either a fixed offset or a zone with daylight saving.
+uint8_t zone;				//Initialised from the settings at boot.
+uint32_t zone_next = ZONE_NEVER;	//Instant (UTC, seconds since epoch) the zone's offset next changes.
+uint8_t zone_shown = 0xFF;		//Zone whose offset is held in zone_shown_offset (for the zone mode).  0xFF is never valid.
+int8_t zone_shown_offset;		//Current offset of zone_shown.
+
 //"intensity" represents the brightness level of the seven-segment displays (valid range integer from 0 to 15).
 //Needs to be global as the function for setting intensity is called from an interrupt sub-routine.
 uint8_t intensity;
 
-//Initialise global array "time" which shall include all the time and date data pulled from the RTC or GPS.  Bytes will be binary-coded deciaml (BCD):
-uint8_t time[SIZE_OF_TIME_ARRAY];	//time[0]  = time[CEN_TENS] : Century tens,	1 or 2
-					//time[1]  = time[CEN_ONES] : Century ones,	9 or 0
-					//time[2]  = time[YEA_TENS] : Year tens,	0 to 9
-					//time[3]  = time[YEA_ONES] : Year ones,	0 to 9
-					//time[4]  = time[MON_TENS] : Month tens,	1 to 2
-					//time[6]  = time[MON_ONES] : Month ones,	0 to 9
-					//time[5]  = time[DAY_TENS] : DAT tens,		0 to 3
-					//time[7]  = time[DAY_ONES] : DAT ones,		1 to 9
-					//time[8]  = time[HOU_TENS] : Hour tens,	0 to 2
-					//time[9]  = time[HOU_ONES] : Hour ones,	0 to 9
-					//time[10] = time[MIN_TENS] : Minute tens,	0 to 5
-					//time[11] = time[MIN_ONES] : Minute ones,	0 to 9
-					//time[12] = time[SEC_TENS] : Second tens,	0 to 5
-					//time[13] = time[SEC_ONES] : Second ones,	0 to 9
+//RAM copy of the settings last saved to eeprom, and the slot they were saved to.
+settings_block settings;
+uint8_t settings_slot;
+
+//Following variables are used by the background re-sync scheduler.
+uint16_t resync_interval = RESYNC_INTERVAL_INIT;	//Current interval (minutes) between background checks of RTC time against GPS time.
+uint16_t resync_minutes = 0;				//Minutes elapsed since the last check (or sync).
+uint8_t resync_last_minute;				//The last minute value (BCD) read from the RTC, used to detect each new minute.
+int32_t resync_error = 0;				//Error (seconds, RTC minus GPS) measured at the last background check.
+int32_t drift = RESYNC_DRIFT_UNKNOWN;			//Drift estimate (parts per million, RTC relative to GPS) measured at the last background check.
+uint32_t resync_set = 0;				//GPS time (UTC) the RTC was last set to, so the drift is the error over the time since.  0 if unknown.
+uint8_t resync_aligned = FALSE;				//Set if the RTC was last set in phase with the GPS second.
+uint32_t gps_epoch_cycles;				//cycles_now() at the start of the receiver's output for the last time received.
+uint8_t gps_phase = FALSE;				//Set if gps_epoch_cycles is known for the last time received.
+uint16_t gps_latency = 0;				//Time (ms, approximate) spent waiting for the GPS sentence during the last sync attempt.
+uint8_t sync_outcome = SYNC_LOG_NO_GPS;			//Outcome of the last sync attempt (as recorded in the sync log).
+
+//Following variables are used by the GPS power cycling and the current model.
+uint8_t gps_awake = FALSE;				//Set while the receiver is (modelled as) awake.  Unknown at reset, so it is woken at boot.
+uint8_t gps_cycled = FALSE;				//Set while the receiver is asleep (or waking) for a scheduled check.
+uint32_t gps_wake_at = 0;				//UTC (seconds since epoch) the receiver wakes (or woke).
+uint16_t gps_wake_lead = GPS_WAKE_LEAD_INIT;		//Seconds the receiver is woken before a scheduled check.
+uint16_t gps_ttff = 0;					//Last measured time (seconds) from waking to a valid time.  0 if not measured.
+uint32_t power_last = 0;				//UTC of the last second counted by power_service().
+uint16_t power_seconds = 0;				//Seconds counted in the current period.
+uint16_t power_gps_seconds = 0;				//Seconds the receiver was awake in the current period.
+uint32_t power_last_hour = 0;				//Modelled average current (uA, i.e. uAh per hour) over the last full period.  0 if none yet.
+
+//Following variables are reported by the telemetry stream.
+uint8_t telemetry_sequence = 0;				//Sequence number of the next status record.
+uint8_t telemetry_dropped = 0;				//Status records dropped because the transmit buffer was full.
+uint16_t render_cycles = 0;				//CPU cycles (Timer1 counts) taken to render the last pre-rendered frame.
+uint16_t tick_idle = 0;					//Time spent idle waiting for the last tick (units of TICK_WAIT_US).
+
+//Following variables are used by the serial command console.
+volatile uint8_t sync_requested = FALSE;		//Set by the "sync" command or the Sync button.  The sync is run by poll().
+uint8_t console_log_next = 0;				//Index of the next sync log record to transmit for the "log" command.
+uint8_t console_log_end = 0;				//Number of sync log records to transmit for the "log" command.
+uint8_t console_profile_next = PROFILE_PROBES * 2;	//Next line (stats then histogram of each probe) to transmit for the "profile" command.
+
+//Following variables are used by the oscillator calibration and the fraction of a second display modes.
+volatile uint32_t tick_cycles = 0;			//Cycle count captured by the RTC square wave interrupt at the start of the second.
+volatile uint32_t tick_period = F_CPU;			//Cycles between the last two ticks (the length of the last second).
+uint8_t fraction_tick;					//display_tick when fraction_due was set.
+uint32_t fraction_due;					//Cycles after the tick at which the displayed fraction next changes.
+volatile uint8_t calibration_restart = TRUE;		//Set to discard the current window (e.g. RTC re-written or tick delayed by an ISR).
+uint8_t calibration_state = CALIBRATION_START;
+uint8_t calibration_seconds = 0;			//Seconds measured in the current window.
+uint8_t calibration_tick;				//display_tick at the last second measured.
+uint32_t calibration_start;				//Cycle count at the start of the current window.
+uint32_t calibration_last;				//Cycle count at the last second measured.
+uint8_t calibration_best;				//Best OSCCAL value found by the current search.
+int32_t calibration_best_error;				//Error (ppm) measured with calibration_best.
+int8_t calibration_direction;				//Step applied to OSCCAL by the current search.
+int32_t calibration_error = 0;				//Error (ppm, positive means the CPU clock is fast) measured by the last window.
+int32_t calibration_before = 0;				//Error (ppm) before the last search.
+int32_t calibration_after = 0;				//Error (ppm) after the last search.
+
+//Set to transmit a ZDA sentence at the start of each second while a time display mode is shown.
+uint8_t nmea_output = NMEA_OUTPUT_DEFAULT;
+
+//Initialise global structure "time" which shall include all the time and date data pulled from the RTC or GPS.
+//Fields are packed binary-coded decimal (BCD) laid out to match the DS3234 time-keeping registers (see ds3234.h):
+rtc_time time;				//time.seconds	: 00 to 59
+					//time.minutes	: 00 to 59
+					//time.hours	: 00 to 23
+					//time.day	: Day of week (not used)
+					//time.date	: 01 to 31
+					//time.month	: 01 to 12 (B7 = century flag)
+					//time.year	: 00 to 99
 
 //Global static array declarations for using manual decode mode to print pseudo "text" to the seven-seg displays (i.e. using sev_seg_flash_word()).
-static uint8_t splash[16] = {
-	SEV_SEG_MANUAL_C, SEV_SEG_MANUAL_L, SEV_SEG_MANUAL_O, SEV_SEG_MANUAL_C, SEV_SEG_MANUAL_Y, SEV_SEG_MANUAL_DASH,
-	SEV_SEG_MANUAL_D, SEV_SEG_MANUAL_O, SEV_SEG_MANUAL_O, SEV_SEG_MANUAL_D, SEV_SEG_MANUAL_L, SEV_SEG_MANUAL_E, SEV_SEG_MANUAL_DASH,
-	SEV_SEG_MANUAL_D, SEV_SEG_MANUAL_O, SEV_SEG_MANUAL_O};	//"CLOCy-dOOdLE-dOO"
-static uint8_t syncing[16] = {
-	SEV_SEG_MANUAL_S, SEV_SEG_MANUAL_Y, SEV_SEG_MANUAL_N, SEV_SEG_MANUAL_C, SEV_SEG_MANUAL_I, SEV_SEG_MANUAL_N, SEV_SEG_MANUAL_G,
-	0, 0, 0, 0, 0, 0, 0, 0, 0};	//"SynCIng"
-static uint8_t no_sync[16] = {
-	SEV_SEG_MANUAL_N, SEV_SEG_MANUAL_O, 0, SEV_SEG_MANUAL_S, SEV_SEG_MANUAL_Y, SEV_SEG_MANUAL_N, SEV_SEG_MANUAL_C,
-	0, 0, 0, 0, 0, 0, 0, 0, 0};	//"nO SynC"
-static uint8_t success[16] = {
-	SEV_SEG_MANUAL_S, SEV_SEG_MANUAL_U, SEV_SEG_MANUAL_C, SEV_SEG_MANUAL_C, SEV_SEG_MANUAL_E, SEV_SEG_MANUAL_S, SEV_SEG_MANUAL_S,
-	0, 0, 0, 0, 0, 0, 0, 0, 0};	//"SUCCESS"
-static uint8_t intensity_text[9] = {
-	SEV_SEG_MANUAL_I, SEV_SEG_MANUAL_N, SEV_SEG_MANUAL_T, SEV_SEG_MANUAL_E, SEV_SEG_MANUAL_N, SEV_SEG_MANUAL_S, SEV_SEG_MANUAL_I,
-	SEV_SEG_MANUAL_T, SEV_SEG_MANUAL_Y};	//"IntEnSIty"
-static uint8_t epoch_text[6] = {
-	SEV_SEG_MANUAL_E, SEV_SEG_MANUAL_P, SEV_SEG_MANUAL_O, SEV_SEG_MANUAL_C, SEV_SEG_MANUAL_H, SEV_SEG_MANUAL_DASH};	//"EPOCH-"
-static uint8_t offset_text[6] = {
-	SEV_SEG_MANUAL_O, SEV_SEG_MANUAL_F, SEV_SEG_MANUAL_F, SEV_SEG_MANUAL_S, SEV_SEG_MANUAL_E, SEV_SEG_MANUAL_T};//"OFFSEt  "
+//The text is encoded into segment codes by the compiler (SEV_SEG_TEXT_N macros in max7219.h) and stored in flash (PROGMEM) rather than SRAM.
+static const uint8_t splash[16]		PROGMEM = {SEV_SEG_TEXT_16("CLOCy-dOOdLE-dOO")};
+static const uint8_t syncing[7]		PROGMEM = {SEV_SEG_TEXT_7("SynCIng")};
+static const uint8_t no_sync[7]		PROGMEM = {SEV_SEG_TEXT_7("nO SynC")};
+static const uint8_t success[7]		PROGMEM = {SEV_SEG_TEXT_7("SUCCESS")};
+static const uint8_t intensity_text[9]	PROGMEM = {SEV_SEG_TEXT_9("IntEnSIty")};
+static const uint8_t epoch_text[6]	PROGMEM = {SEV_SEG_TEXT_6("EPOCH-")};
+static const uint8_t zone_text[4]	PROGMEM = {SEV_SEG_TEXT_4("ZOnE")};
+
+//Display mode table, stored in flash.  Row order must match the MODE_x definitions.  Read a row with memcpy_P().
+#define MODE_TEXT(text)	text, sizeof(text), {SEV_SEG_DECODE_IMAGE(sizeof(text))}	//Text pointer, length and decode mode image.
+#define MODE_NO_TEXT	NULL, 0, {SEV_SEG_DECODE_IMAGE(0)}				//No text, all digits code B.
+static const mode_layout mode_table[] PROGMEM =
+{
+	//Text				Date		Format		Time		Fraction	Digits	Delimiters	Value			Update		Flags
+	{MODE_NO_TEXT,			0,		DATE_CALENDAR,	10,		FIELD_UNUSED,	0,	0,		VALUE_NONE,		UPDATE_SECOND,	MODE_RESTORE},	//MODE_1A_ISO
+	{MODE_NO_TEXT,			0,		DATE_CALENDAR,	10,		FIELD_UNUSED,	0,	SEV_SEG_DP,	VALUE_NONE,		UPDATE_SECOND,	MODE_RESTORE},	//MODE_1B_ISO
+	{MODE_NO_TEXT,			1,		DATE_CALENDAR,	9,		FIELD_UNUSED,	0,	0,		VALUE_NONE,		UPDATE_SECOND,	MODE_RESTORE},	//MODE_2A_ISO
+	{MODE_NO_TEXT,			1,		DATE_CALENDAR,	9,		FIELD_UNUSED,	0,	SEV_SEG_DP,	VALUE_NONE,		UPDATE_SECOND,	MODE_RESTORE},	//MODE_2B_ISO
+	{MODE_TEXT(epoch_text),		FIELD_UNUSED,	0,		FIELD_UNUSED,	FIELD_UNUSED,	0,	0,		VALUE_EPOCH,		UPDATE_SECOND,	MODE_RESTORE},	//MODE_3_EPOCH
+	{MODE_TEXT(zone_text),		FIELD_UNUSED,	0,		FIELD_UNUSED,	FIELD_UNUSED,	0,	0,		VALUE_ZONE,		UPDATE_ALWAYS,	0},		//MODE_4_ZONE
+	{MODE_TEXT(intensity_text),	FIELD_UNUSED,	0,		FIELD_UNUSED,	FIELD_UNUSED,	0,	0,		VALUE_INTENSITY,	UPDATE_ALWAYS,	0},		//MODE_5_INTENSITY
+	{MODE_NO_TEXT,			0,		DATE_ORDINAL,	10,		FIELD_UNUSED,	0,	0,		VALUE_NONE,		UPDATE_SECOND,	MODE_RESTORE},	//MODE_6_ORDINAL
+	{MODE_NO_TEXT,			0,		DATE_WEEK,	10,		FIELD_UNUSED,	0,	0,		VALUE_NONE,		UPDATE_SECOND,	MODE_RESTORE},	//MODE_7_WEEK
+	{MODE_NO_TEXT,			0,		DATE_CALENDAR,	8,		14,		2,	SEV_SEG_DP,	VALUE_NONE,		UPDATE_SECOND,	MODE_RESTORE | MODE_TICK},	//MODE_8_HUNDREDTHS
+	{MODE_NO_TEXT,			FIELD_UNUSED,	0,		FIELD_UNUSED,	13,		3,	0,		VALUE_EPOCH_MS,		UPDATE_SECOND,	MODE_RESTORE | MODE_TICK},	//MODE_9_EPOCH_MS
+};
+
+//Set whenever something other than poll() has written to the display (e.g. sync status text) so that the mode's static image is re-sent.
+volatile uint8_t display_refresh = TRUE;
+
+//Incremented by the RTC square wave interrupt each time it commits a staged frame (i.e. at the start of each second).
+volatile uint8_t display_tick = 0;
+
+//Warm restart state (see warm_state).  Not cleared at reset.
+warm_state warm __attribute__((section(".noinit")));
+
+//Calendar fields derived from the local date (see derived_update()).  date = 0 is never valid, so the first use always computes them.
+derived_date derived = {0};
 
 /////////////////////////
 //Function Declarations//
 /////////////////////////
 void hardware_init(void);			//Initialise the peripherals.
-void settings_init(void);			//Initialise (validate and set) settings that are stored in eeprom (UTC time offset and intensity (brightness).
-void validate_eeprom_offset(void);		//Read the UTC time offset value from eeprom and confirm that it is valid.
-void validate_eeprom_intensity(void);		//Read the UTC intensity (brightness) value from eeprom and confirm that it is valid.
-void poll(void);				//Poll the current selected mode and run the according function.
-void display_iso_time(void);			//Display the time in a standard ISO-8601 format.
-void display_epoch_time(void);			//Display UNIX Epoch time (seconds elapsed since 1970.01.01.00.00.00).
-void get_offset(void);				//Enables alteration of the time offset from UTC (time data from the GPS module is always UTC).
-void display_offset(void);			//Display the current offset value using the last 3 digits (-11.5 to 12.0).
-void cycle_offset(void);			//Increment the offset value by half an hour and rollover when maximum valid value is exceeded.
+void settings_init(void);			//Load the newest valid settings block from eeprom, validate and apply the settings.
+void settings_default(void);			//Set default settings (importing any settings stored by earlier firmware).
+uint8_t settings_import(void);			//Import the newest valid version 1 settings block.  Returns FALSE if there isn't one.
+void settings_validate(void);			//Confirm each setting is valid, replacing any that are not with the default.
+void settings_save(void);			//Save the current settings to the next eeprom slot.
+uint8_t settings_crc(const void *block, uint8_t length);	//Calculate the CRC-8 of the first "length" bytes of a settings block.
+uint8_t warm_restore(void);			//Restore the state saved before a watchdog reset.  Returns FALSE after any other reset.
+void warm_save(void);				//Save the state needed for a warm restart to .noinit SRAM.
+void warm_print(void);				//Transmit the reset cause and the number of watchdog resets.
+void poll(void);				//Run the currently selected display mode (as described by mode_table) until the mode changes.
+uint8_t mode_available(uint8_t candidate);	//TRUE if a mode is in mode_table and can be shown by this board.
+void display_render(mode_layout *layout, rtc_time *time, uint8_t *buffer);	//Render the dynamic fields of a mode for a time into a digit buffer.
+void display_render_int(uint8_t *buffer, uint8_t last, uint32_t num);	//Render an integer into a digit buffer, ending at digit "last".
+void display_fraction(mode_layout *layout, uint8_t *shown, uint8_t tick);	//Re-write the fraction of a second digits if they have changed.
+void display_render_fixed(uint8_t *digits, uint8_t width, uint16_t num);	//Render an integer into "width" digits with leading zeros.
+void derived_update(rtc_time *time);		//Recompute the derived calendar fields if the date has changed.
+uint8_t iso_weeks(uint16_t jan1, uint8_t leap);	//Number of ISO weeks (52 or 53) in a year starting on day "jan1" (days since 1970).
+void cycle_zone(void);				//Select the next time zone and rollover after the last.
+void zone_apply(void);				//Re-set the RTC if the selected zone's offset differs from the offset the RTC is set to.
 void attempt_sync(void);			//Attempt to sync the RTC time with GPS data.  Display status with pseudo-text.
-uint8_t sync_time (uint8_t *time);		//Update the time array by parsing the date and time from the GPS module.  Returns FALSE if data is invalid.
+uint8_t sync_time (rtc_time *time);		//Update the time structure from the GPS module and set the RTC.  Returns FALSE if data is invalid.
+uint8_t gps_get_time (rtc_time *time);		//Update the time structure by parsing the UTC date and time from the GPS module.  Returns FALSE if data is invalid.
+uint8_t gps_merge_date (rtc_time *time);	//Complete a time-only (GGA) UTC time with the date from the RTC.  Returns FALSE if the RTC can't be trusted.
+void nmea_prepare(rtc_time *next);		//Stage the ZDA sentence (UTC) for the second that "next" (local time) will begin.
+void calibration_service(void);			//Measure the CPU clock against the RTC second.  Called once a second by the time display modes.
+void calibration_adjust(int32_t error);		//Step the oscillator calibration search using the error (ppm) measured by a window.
+void resync_service(void);			//Count minutes elapsed and run a background check of the RTC when the re-sync interval expires.
+void gps_wake(void);				//Wake the GPS receiver if it is in backup mode.
+void gps_sleep(void);				//Put the GPS receiver into backup mode until shortly before the next scheduled check.
+void gps_adapt(uint8_t valid, uint32_t utc);	//Adapt the wake-up lead to the outcome of a scheduled check.
+void power_service(void);			//Count the seconds (and seconds the GPS was awake) for the current model.  Called once a second.
+uint32_t power_model(uint16_t gps_seconds, uint16_t seconds);	//Modelled average board current (uA) over "seconds".
+void resync_check(void);			//Compare the RTC to the GPS, re-write the RTC only if required and adapt the re-sync interval.
+int32_t resync_measure(uint32_t gps_epoch);	//Error (ms, RTC minus GPS) against the GPS time just received, at the RTC's next rollover.
+void gps_align(rtc_time *time);			//Wait for the next GPS second after the time just received and advance "time" to it.
+void log_sync(uint8_t outcome, int32_t error);	//Record the outcome of a sync attempt in the sync log (ds3234 battery-backed SRAM).
+int16_t clamp_int16(int32_t value);		//Clamp a value to the int16_t range.
+void telemetry_emit(void);			//Send a telemetry status record (dropped rather than waiting if the transmit buffer is full).
+void console_service(uint8_t run);		//Collect command characters and (if "run") run a pending command or transmit the next log record.
+void console_command(char *line);		//Run a console command line.
 void apply_offset(void);			//Apply the set UTC time offset to the time received from the GPS.
-void rollunder_hours(void);			//Adjust the date when offset has caused the hours to roll under 0.
-void rollover_hours(void);			//Adjust the date when offset has caused the hours to roll over 23.
-void rollunder_days(void);			//Adjust the month when offset has caused the date to roll under 1.
-void rollover_days(void);			//Adjust the month when offset has caused the date to roll over the maximum for the current month.
-void get_intensity(void);			//Allow adjustment of the display intensity (brightness).
 void cycle_intensity(void);			//Cycle through the possible intensity levels.
-void sev_seg_set_word(uint8_t *word, uint8_t word_length);				//Use the seven-segment digits to display "text".
-void sev_seg_flash_word(uint8_t *word, uint8_t word_length, uint16_t duration_ms);	//Use the seven-segment digits to display "text" for a defined duration.
+void sev_seg_set_word(const uint8_t *word, uint8_t word_length);				//Use the seven-segment digits to display "text" (word stored in flash).
+void sev_seg_flash_word(const uint8_t *word, uint8_t word_length, uint16_t duration_ms);	//Use the seven-segment digits to display "text" for a defined duration.
 void sev_seg_startup_ani(void);			////Simple startup animation scans the decimal point (DP) right to left then back a few times.
@@ -1,138 +1,240 @@
-//Functions to control two cascaded MAX7219 8x7-segment display drivers (total 16x 70segment digits).
+//Functions to control a cascade of SEV_SEG_CHIPS MAX7219 8x7-segment display drivers (8 digits per chip).
+//Each LOAD cycle (16 bits per chip shifted out then latched) is queued on the SPI bus as a single transaction and the functions return without
+//waiting for it to be clocked out.  Queued LOAD cycles are latched in the order they were written.
+//A LOAD cycle can write one register in every chip, so the whole display is written in 8 LOAD cycles (one per digit row) whatever the chain length.
 #include <max7219.h>
 
-//Writes a byte to an address in both of the MAX7219s.  Note, one driver will receive data, the other will receive no-op command.
-void sev_seg_write_byte(uint8_t address, uint8_t data)
+//A LOAD cycle waiting to be (or being) clocked out.  bytes[0] is the transaction's command byte, the rest are its data bytes.
+typedef struct
 {
-	cli();		//Temporarily disable interrupts so that spi communications are not corrupted.
+	spi_transaction transaction;
+	uint8_t bytes[SEV_SEG_CHIPS * 2];
+	volatile uint8_t claimed;		//Set while a context is filling the frame (between sev_seg_claim() and spi_submit()).
+} sev_seg_frame;
+
+static sev_seg_frame sev_seg_frames[SEV_SEG_FRAMES];
+static uint8_t sev_seg_next_frame = 0;	//Index of the next frame to be used (frames are re-used in turn).
+
+//Staged LOAD cycles (at most one per digit row) prepared by sev_seg_stage() and queued by sev_seg_commit().
+static sev_seg_frame sev_seg_staged[8];
+static volatile uint8_t sev_seg_staged_count = 0;	//Number of staged LOAD cycles.  Only set once they are complete.
+
+//Fill a frame with a LOAD cycle that writes register "address".
+//If "chip" is SEV_SEG_ALL_CHIPS, chip c receives data[c * stride] (a stride of 0 sends the same data to every chip).
+//Otherwise only "chip" receives data[0] and every other chip receives a no-op.
+static void sev_seg_fill(sev_seg_frame *frame, uint8_t chip, uint8_t address, const uint8_t *data, uint8_t stride)
+{
+	spi_transaction *transaction = &frame->transaction;
+	uint8_t *bytes = frame->bytes;
+
+	spi_wait(transaction);			//Only waits if this frame is still queued from an earlier LOAD cycle.
 
-	if(address & 0x80)		//Check driver flag.  If set, address is for driver B (DIG_8 to DIG_15).
+	//The first 16 bits shifted out end up in the last chip of the chain, so fill the frame from the last chip back to chip 0.
+	for (uint8_t c = 0; c < SEV_SEG_CHIPS; c++)
 	{
-		SEV_SEG_LOAD_LOW;		//Drop the level of the LOAD pin
-		spi_trade_byte(address);	//Send the register address where the data will be stored
-		spi_trade_byte(data);		//Send the data to be stored
-		spi_trade_byte(0);		//Roll no-op data through to push real data out of driver A and into driver B (address byte)
-		spi_trade_byte(0);		//Roll no-op data through to push real data out of driver A and into driver B (data byte)
-		SEV_SEG_LOAD_HIGH;		//Raise the level of the LOAD pin - this triggers latching of the sent bytes (last 16 bits of data are latched).
+		uint8_t *pair = &bytes[(SEV_SEG_CHIPS - 1 - c) * 2];
+
+		if ((chip == SEV_SEG_ALL_CHIPS) || (chip == c))
+		{
+			pair[0] = address;
+			pair[1] = data[(chip == SEV_SEG_ALL_CHIPS) ? (c * stride) : 0];
+		}
+		else
+		{
+			pair[0] = SEV_SEG_NO_OP;
+			pair[1] = 0;
+		}
 	}
-	else					//Not set, therefore address is for driver A (DIG_0 to DIG_7).
+
+	transaction->device = SPI_DEVICE_SEV_SEG;	//LOAD is dropped for the transaction and the rising edge at the end latches the data.
+	transaction->command = bytes[0];
+	transaction->tx = &bytes[1];
+	transaction->rx = NULL;
+	transaction->length = sizeof(frame->bytes) - 1;
+	transaction->complete = NULL;
+}
+
+//Claim the next frame.  Only the index update is atomic.  A frame claimed by an interrupted context (the main loop, if the button ISR writes to
+//the display) is skipped, so it can't be refilled under it.  At most one context can be interrupted part way through a fill, so with
+//SEV_SEG_FRAMES of 2 or more a frame is always found.
+static sev_seg_frame *sev_seg_claim(void)
+{
+	sev_seg_frame *frame;
+
+	PROFILE_BEGIN(PROFILE_SEV_SEG_CLAIM);
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
 	{
-		SEV_SEG_LOAD_LOW;		//Drop the level of the LOAD pin
-		spi_trade_byte(0);		//Roll no-op data in first for driver B when real data for driver A pushes it through (address byte)
-		spi_trade_byte(0);		//Roll no-op data in first for driver B when real data for driver A pushes it through (data byte)
-		spi_trade_byte(address);	//Send the register address where the data will be stored
-		spi_trade_byte(data);		//Send the data to be stored
-		SEV_SEG_LOAD_HIGH;		//Raise the level of the LOAD pin - this triggers latching of the sent bytes (last 16 bits of data are latched).
+		do
+		{
+			frame = &sev_seg_frames[sev_seg_next_frame];
+			sev_seg_next_frame = ((sev_seg_next_frame + 1) % SEV_SEG_FRAMES);
+		} while (frame->claimed);
+		frame->claimed = 1;
 	}
+	PROFILE_END(PROFILE_SEV_SEG_CLAIM);
+	return(frame);
+}
 
-	sei();		//Re-enable interrupts.
+//Queue a LOAD cycle that writes register "address" (see sev_seg_fill() for "chip" and "stride").
+//The frame is claimed atomically, filled with interrupts enabled (including any wait for its previous LOAD cycle, at most one queued RTC burst
+//plus one LOAD cycle), then published by spi_submit(), which only disables interrupts to store it in the queue.
+//LOAD cycles from one context are latched in order.  If the button ISR writes to the display while the main loop is filling a frame, the
+//ISR's LOAD cycles go first, which is no different from the main loop's frame being queued just after the ISR returns.
+static void sev_seg_load(uint8_t chip, uint8_t address, const uint8_t *data, uint8_t stride)
+{
+	sev_seg_frame *frame;
+
+	PROFILE_BEGIN(PROFILE_SEV_SEG_LOAD);
+	frame = sev_seg_claim();
+	sev_seg_fill(frame, chip, address, data, stride);
+	spi_submit(&frame->transaction);
+	frame->claimed = 0;
+	PROFILE_END(PROFILE_SEV_SEG_LOAD);
 }
 
-//Initialise both the display drivers.
-void sev_seg_init(void)
+//Writes a register in one chip.  Every other chip receives a no-op.  Pass SEV_SEG_ALL_CHIPS to write the same data to every chip.
+void sev_seg_write_chip(uint8_t chip, uint8_t address, uint8_t data)
 {
-	SPI_DDR |= (1 << SEV_SEG_LOAD); 			//Set LOAD pin as an output
-	SEV_SEG_PORT |= (1 << SEV_SEG_LOAD);			//Set LOAD pin to high at start (data latching occurs on LOAD rising edge).
+	sev_seg_load(chip, address, &data, 0);
+}
+
+//Writes the same register in every chip in one LOAD cycle.  data[c] is written to chip c.
+void sev_seg_write_row(uint8_t address, const uint8_t *data)
+{
+	sev_seg_load(SEV_SEG_ALL_CHIPS, address, data, 1);
+}
 
-	//First setup max7219 driver A (digits 0-7)
-	sev_seg_write_byte(SEV_SEG_SCAN_LIMIT_A, 7);		//Set number of digits in the display to 8 (Data=number of digits - 1)
-	sev_seg_write_byte(SEV_SEG_INTENSITY_A, 0x08);		//Set brightness (duty cycle) to about half-way.
-	sev_seg_write_byte(SEV_SEG_SHUTDOWN_A, 1);		//Enter normal operation (exit shutdown mode).
-	sev_seg_write_byte(SEV_SEG_DECODE_MODE_A, 0xFF);	//Set all digits to be set by Code B data input.
-	sev_seg_write_byte(SEV_SEG_DISPLAY_TEST_A, 0x00);	//Ensures display test mode is set to normal (sometimes set to test mode on re-programme).
+//Writes a single digit (0 is the left-most).
+void sev_seg_write_digit(uint8_t digit, uint8_t data)
+{
+	sev_seg_write_chip(digit / 8, SEV_SEG_DIGIT(digit % 8), data);
+}
 
-	//Second setup max7219 driver B (digits 8-15)
-	sev_seg_write_byte(SEV_SEG_SCAN_LIMIT_B, 7);		//Set number of digits in the display to 8 (Data=number of digits - 1)
-	sev_seg_write_byte(SEV_SEG_INTENSITY_B, 0x08);		//Set brightness (duty cycle) to about half-way.
-	sev_seg_write_byte(SEV_SEG_SHUTDOWN_B, 1);		//Enter normal operation (exit shutdown mode).
-	sev_seg_write_byte(SEV_SEG_DECODE_MODE_B, 0xFF);	//Set all digits to be set by Code B data input.
-	sev_seg_write_byte(SEV_SEG_DISPLAY_TEST_B, 0x00);	//Ensures display test mode is set to normal (sometimes set to test mode on re-programme).
+//Writes all SEV_SEG_DIGITS digits from "buffer" (buffer[0] is the left-most digit).
+//Each LOAD cycle writes the same digit register (row) of every chip, so a full update is always 8 LOAD cycles of 2 bytes per chip.
+void sev_seg_flush(const uint8_t *buffer)
+{
+	for (uint8_t row = 0; row < 8; row++)
+	{
+		sev_seg_load(SEV_SEG_ALL_CHIPS, SEV_SEG_DIGIT(row), &buffer[row], 8);	//Chip c displays buffer[(c * 8) + row].
+	}
 }
 
-//Clears all digits.  Bypasses function "sev_seg_writeByte" and clears equivalent digits on both drivers simultaneously (~halves clear time).
-//Note the digits bust be in CODE-B mode.
-void sev_seg_all_clear(void)
+//Prepare (but don't send) the LOAD cycles that change the display from "shown" to "buffer".  Only digit rows that differ in at least one chip
+//are staged, so a commit is usually a single LOAD cycle (the seconds digit).  Replaces anything already staged.  Returns the number of rows staged.
+//Staged rows are filled in before the count is set, so sev_seg_commit() (e.g. from an ISR) never sends a partly prepared frame.
+uint8_t sev_seg_stage(const uint8_t *buffer, const uint8_t *shown)
 {
-	cli();		//Temporarily disable interrupts so that spi communications are not corrupted.
+	uint8_t count = 0;
 
-	for (uint8_t i = 8; i > 0; i--)		//Counts down through the digits from digit 7 (8) to digit 0 (1).
+	sev_seg_staged_count = 0;
+	for (uint8_t row = 0; row < 8; row++)
 	{
-		SEV_SEG_LOAD_LOW;				//Drop the level of the LOAD pin.
-		spi_trade_byte(i);				//Push in digit address i (will be in driver B at latch).
-		spi_trade_byte(SEV_SEG_CODEB_BLANK);		//Push in data to clear digit at i (will be in driver B at latch).
-		spi_trade_byte(i);				//Push in digit address i (will be in driver A at latch).
-		spi_trade_byte(SEV_SEG_CODEB_BLANK);		//Push in data to clear digit at i (will be in driver A at latch).
-		SEV_SEG_LOAD_HIGH;				//Raise the level of the LOAD pin - triggers latching of the sent bytes (last 16 bits latched).
+		for (uint8_t c = 0; c < SEV_SEG_CHIPS; c++)
+		{
+			if (buffer[(c * 8) + row] != shown[(c * 8) + row])
+			{
+				sev_seg_fill(&sev_seg_staged[count++], SEV_SEG_ALL_CHIPS, SEV_SEG_DIGIT(row), &buffer[row], 8);
+				break;
+			}
+		}
 	}
+	sev_seg_staged_count = count;
+	return(count);
+}
 
-	sei();		//Re-enable interrupts.
+//Queue the staged LOAD cycles in one burst.  Intended to be called from an ISR at the instant the display should change.
+//Nothing else needs to be prepared here so the first LOAD cycle starts as soon as it is queued.
+void sev_seg_commit(void)
+{
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		for (uint8_t i = 0; i < sev_seg_staged_count; i++)
+		{
+			spi_submit(&sev_seg_staged[i].transaction);
+		}
+		sev_seg_staged_count = 0;
+	}
 }
 
-//Turns display on or off without changing any other registers.  This is useful to prevent display artifacts when switching between manual and code-b modes.
-void sev_seg_power(uint8_t on_or_off)
+//Queue the LOAD cycles that change the display from "shown" to "buffer" now, without touching anything staged (e.g. to change a few fast
+//digits between commits).  Returns the number of rows queued.
+uint8_t sev_seg_update(const uint8_t *buffer, const uint8_t *shown)
 {
-	cli();		//Temporarily disable interrupts so that spi communications are not corrupted.
+	uint8_t count = 0;
 
-	SEV_SEG_LOAD_LOW;				//Drop the level of the LOAD pin.
-	spi_trade_byte(SEV_SEG_SHUTDOWN_B);		//Push in address for shutdown mode (will be in driver B at latch).
-	spi_trade_byte(on_or_off);			//Push in data to set shutdown mode : 1=on, 2=off (will be in driver B at latch).
-	spi_trade_byte(SEV_SEG_SHUTDOWN_A);		//Push in address for shutdown mode (will be in driver A at latch).
-	spi_trade_byte(on_or_off);			//Push in data to set shutdown mode : 1=on, 2=off (will be in driver A at latch).
-	SEV_SEG_LOAD_HIGH;				//Raise the level of the LOAD pin - triggers latching of the sent bytes (last 16 bits latched).
+	for (uint8_t row = 0; row < 8; row++)
+	{
+		for (uint8_t c = 0; c < SEV_SEG_CHIPS; c++)
+		{
+			if (buffer[(c * 8) + row] != shown[(c * 8) + row])
+			{
+				sev_seg_load(SEV_SEG_ALL_CHIPS, SEV_SEG_DIGIT(row), &buffer[row], 8);
+				count++;
+				break;
+			}
+		}
+	}
+	return(count);
+}
 
-	sei();		//Re-enable interrupts.
+//Discard any staged LOAD cycles (e.g. the display has been written by other means so they no longer describe a change from what is shown).
+void sev_seg_unstage(void)
+{
+	sev_seg_staged_count = 0;
 }
 
-//Sets all digits on both drivers to decode mode "manual" or "code B".
-//At init, both drivers are set to code B, this is considered the default for this application.
-//Therefore, when manual is used in a function, the function should reset to code B prior to exit.
-void sev_seg_decode_mode(uint8_t decode_mode)
+//Initialise all of the display drivers.  Each setting is written to every chip in one LOAD cycle.
+void sev_seg_init(void)
 {
-	cli();		//Temporarily disable interrupts so that spi communications are not corrupted.
+	SEV_SEG_DDR |= (1 << SEV_SEG_LOAD); 			//Set LOAD pin as an output
+	SEV_SEG_PORT |= (1 << SEV_SEG_LOAD);			//Set LOAD pin to high at start (data latching occurs on LOAD rising edge).
 
-	SEV_SEG_LOAD_LOW;				//Drop the level of the LOAD pin.
-	spi_trade_byte(SEV_SEG_DECODE_MODE_B);		//Push in address for decode mode (will be in driver B at latch).
-	spi_trade_byte(decode_mode);			//Push in data to set decode mode : 0x00=all manual, OxFF=all Code B (will be in driver B at latch).
-	spi_trade_byte(SEV_SEG_DECODE_MODE_A);		//Push in address for decode mode (will be in driver A at latch).
-	spi_trade_byte(decode_mode);			//Push in data to set decode mode : 0x00=all manual, OxFF=all Code B (will be in driver A at latch).
-	SEV_SEG_LOAD_HIGH;				//Raise the level of the LOAD pin - triggers latching of the sent bytes (last 16 bits latched).
+	sev_seg_write_chip(SEV_SEG_ALL_CHIPS, SEV_SEG_SCAN_LIMIT, 7);		//Set number of digits in the display to 8 (Data=number of digits - 1)
+	sev_seg_write_chip(SEV_SEG_ALL_CHIPS, SEV_SEG_INTENSITY, 0x08);		//Set brightness (duty cycle) to about half-way.
+	sev_seg_write_chip(SEV_SEG_ALL_CHIPS, SEV_SEG_SHUTDOWN, 1);		//Enter normal operation (exit shutdown mode).
+	sev_seg_write_chip(SEV_SEG_ALL_CHIPS, SEV_SEG_DECODE_MODE, 0xFF);	//Set all digits to be set by Code B data input.
+	sev_seg_write_chip(SEV_SEG_ALL_CHIPS, SEV_SEG_DISPLAY_TEST, 0x00);	//Ensures display test mode is set to normal (sometimes set to test mode on re-programme).
+}
 
-	sei();		//Re-enable interrupts.
+//Clears all digits.  Clears equivalent digits on all drivers simultaneously (8 LOAD cycles whatever the chain length).
+//Note the digits bust be in CODE-B mode.
+void sev_seg_all_clear(void)
+{
+	for (uint8_t i = 0; i < 8; i++)
+	{
+		sev_seg_write_chip(SEV_SEG_ALL_CHIPS, SEV_SEG_DIGIT(i), SEV_SEG_CODEB_BLANK);	//Clear digit i on all drivers.
+	}
 }
 
-void sev_seg_set_intensity(uint8_t intensity)
+//Turns display on or off without changing any other registers.  This is useful to prevent display artifacts when switching between manual and code-b modes.
+void sev_seg_power(uint8_t on_or_off)
 {
-	cli();		//Temporarily disable interrupts so that spi communications are not corrupted.
+	sev_seg_write_chip(SEV_SEG_ALL_CHIPS, SEV_SEG_SHUTDOWN, on_or_off);		//Set shutdown mode on all drivers : 1=on, 0=off.
+}
 
-	SEV_SEG_LOAD_LOW;				//Drop the level of the LOAD pin.
-	spi_trade_byte(SEV_SEG_INTENSITY_B);		//Push in address for decode mode (will be in driver B at latch).
-	spi_trade_byte(intensity);			//Push in data to set decode mode : 0x00=all manual, OxFF=all Code B (will be in driver B at latch).
-	spi_trade_byte(SEV_SEG_INTENSITY_A);		//Push in address for decode mode (will be in driver A at latch).
-	spi_trade_byte(intensity);			//Push in data to set decode mode : 0x00=all manual, OxFF=all Code B (will be in driver A at latch).
-	SEV_SEG_LOAD_HIGH;				//Raise the level of the LOAD pin - triggers latching of the sent bytes (last 16 bits latched).
+//Sets all digits on all drivers to decode mode "manual" or "code B".
+//At init, all drivers are set to code B, this is considered the default for this application.
+//Therefore, when manual is used in a function, the function should reset to code B prior to exit.
+void sev_seg_decode_mode(uint8_t decode_mode)
+{
+	sev_seg_write_chip(SEV_SEG_ALL_CHIPS, SEV_SEG_DECODE_MODE, decode_mode);	//0x00=all manual, OxFF=all Code B.
+}
 
-	sei();		//Re-enable interrupts.
+void sev_seg_set_intensity(uint8_t intensity)
+{
+	sev_seg_write_chip(SEV_SEG_ALL_CHIPS, SEV_SEG_INTENSITY, intensity);		//0x00=minimum to 0x0F=maximum.
 }
 
-//Takse any 64-bit integer and displays the decimal value using the 16 7-seg digits.  Least-significant digit will be displayed to the far right (digit 15).
+//Takse any 64-bit integer and displays the decimal value.  Least-significant digit will be displayed to the far right (digit SEV_SEG_DIGITS - 1).
 void sev_seg_display_int(uint64_t num)
 {
-	if (num)						//If the passed-in variable "num" is non-zer0:
-	{
-		int i = SEV_SEG_DIGIT_15;			//First digit (least-sig) will be displayed on 7-seg digit 15 (far right).
-		while(num > 0)					//Loop until the 64-bit integer has been divided to zero.
-		{
-			sev_seg_write_byte(i, (num % 10));	//Write the digit (num modulus 10 gives remainder i.e. 'ones' of the integer)
-			num /= 10;				//Divide num by 10 so that next iteration will determine the next digit.  I.e. remove LS digit.
-			i--;					//Decrement the 7-seg display digit address so that next iteration displays digit to the left.
-			if(i == SEV_SEG_NO_OP_B)		//Decrement from address of dig 8 (driver B) requires resetting the address to dig 7 (driver A).
-			{
-				i = SEV_SEG_DIGIT_7;
-			}
-		}
-	}
-	else							//Else "num" must be zero.
+	uint8_t i = (SEV_SEG_DIGITS - 1);			//First digit (least-sig) will be displayed on the right-most 7-seg digit.
+
+	do
 	{
-		sev_seg_write_byte(SEV_SEG_DIGIT_15, 0);	//Just print a 0 on digit 15.
-	}
+		sev_seg_write_digit(i, (num % 10));		//Write the digit (num modulus 10 gives remainder i.e. 'ones' of the integer)
+		num /= 10;					//Divide num by 10 so that next iteration will determine the next digit.  I.e. remove LS digit.
+		i--;						//Decrement the 7-seg display digit so that next iteration displays digit to the left.
+	} while((num > 0) && (i < SEV_SEG_DIGITS));		//Loop until the integer has been divided to zero (a zero is displayed as "0").
 }
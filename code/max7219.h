@@ -1,22 +1,17 @@
-//Definitions and declarations to control two cascaded MAX7219 8x7-segment display drivers (total 16x 70segment digits).
+//Definitions and declarations to control a cascade of SEV_SEG_CHIPS MAX7219 8x7-segment display drivers (8 digits per chip).
 
-//These max7219.h and .c files will drive two cascaded MAX7219 drivers to control a total 16 digits.
-//The digits are numbered 0 to 15 from left to right: DIG_0-> |8.8.8.8.8.8.8.8.8.8.8.8.8.8.8.8.| <-DIG_15
-//When latched, the drivers expect 16 bits of data.  8 MSBs are the address byte, 8 LSBs are the data byte.
-//The 4 MSBs of the address are "Don't cares" as far as the drivers are concerned, but this code will use the MSB to identify which driver is being used ie:
-//Driver A (DIG_0 to DIG_7) will have the address byte MSB cleared (0)
-//Driver B (DIG_8 to DIG_15) will have the address byte MSB set (1)
+//The chain length is set in board.h.  The digits are numbered 0 to (SEV_SEG_DIGITS - 1) from left to right, e.g. for two chips:
+//DIG_0-> |8.8.8.8.8.8.8.8.8.8.8.8.8.8.8.8.| <-DIG_15
+//Chip 0 (digits 0-7) is connected to MOSI, chip 1 (digits 8-15) is connected to the DOUT of chip 0, etc.
+//When latched, each chip takes the last 16 bits shifted into it.  8 MSBs are the register address byte, 8 LSBs are the data byte.
+//So a LOAD cycle shifts out 16 bits per chip, starting with the chip furthest along the chain, and can write one register in every chip.
 
 #include <avr/io.h>		//From standard AVR libraries - used for calling standard registers etc.
 #include <util/delay.h>		//From the standard AVR libraries - used to call delay_ms() and delay_us() functions.
-#include <spi.h>		//Used for serial communications via SPI
-#include <avr/interrupt.h>	//Required to use sei(); and cli(); so interrupts can be controlled to avoid corrupting spi transmissions.
+#include <spi.h>		//Used for serial communications via SPI.  Also includes board.h which defines the LOAD pin, SPI mode and clock rate.
+#include <profile.h>		//For the cycle profiler probes (empty unless PROFILE is defined).
 
-//Definitions for use by SPI.c functions
-#define SEV_SEG_LOAD	PB1	//Although MAX7219 is not true SPI, LOAD pin triggers latching (on rising edge) and acts similarly to SS/CS.
-#define SEV_SEG_PORT	PORTB	//Port on which the load pin is found.
-#define SEV_SEG_POL	1	//Set polarity for SPI comms.
-#define SEV_SEG_PHA	1	//Set phase for SPI comms
+#define SEV_SEG_FRAMES	4	//Number of LOAD cycles that can be queued on the SPI bus without waiting.
 
 //Definitions for setting shutdown mode (address SEV_SEG_SHUTDOWN_X)
 #define ON	1
@@ -26,41 +21,17 @@
 #define DECODE_CODE_B	0xFF
 #define DECODE_MANUAL	0x00
 
-//Macros for setting the LOAD pin on the MAX7219 low or high.  Serially shifted data is latched into the MAX7219 on a rising edge of LOAD pin.
-#define SEV_SEG_LOAD_HIGH	SEV_SEG_PORT |= (1 << SEV_SEG_LOAD)	//Set LOAD pin high
-#define SEV_SEG_LOAD_LOW	SEV_SEG_PORT &= ~(1 << SEV_SEG_LOAD)	//Set LOAD pin low
+#define SEV_SEG_DIGITS	(SEV_SEG_CHIPS * 8)	//Total number of digits.
+#define SEV_SEG_ALL_CHIPS	0xFF			//Pass as the chip to address every chip in the chain.
 
-//Driver A Register Addresses (MSB cleared to identify as driver A in code (MSB ignored my driver))
-#define	SEV_SEG_NO_OP_A		0x00	//No operation (ignore lower byte).
-#define	SEV_SEG_DIGIT_0		0x01
-#define	SEV_SEG_DIGIT_1		0x02
-#define	SEV_SEG_DIGIT_2		0x03
-#define	SEV_SEG_DIGIT_3		0x04
-#define	SEV_SEG_DIGIT_4		0x05
-#define	SEV_SEG_DIGIT_5		0x06
-#define	SEV_SEG_DIGIT_6		0x07
-#define	SEV_SEG_DIGIT_7		0x08
-#define	SEV_SEG_DECODE_MODE_A	0x09	//Controls Code B Font for each digit. Simple codes to display 0-9,-,H,E,L,P. 0=off, 1=on for each bit.
-#define	SEV_SEG_INTENSITY_A	0x0A	//Controls intensity (brightness) by setting duty cycle - range from 0x00(min) to 0x0F(max)
-#define	SEV_SEG_SCAN_LIMIT_A	0x0B	//Controls number of digits in the display (0-8) - 0=One digit, 1=Two digits...7=Eight digits.
-#define	SEV_SEG_SHUTDOWN_A	0x0C	//Controls shutdown mode. 0=Shutdown, 1=Normal Operation
-#define	SEV_SEG_DISPLAY_TEST_A	0x0F
-
-//Driver B Register Addresses (MSB set to identify as driver B in code (MSB ignored my driver))
-#define	SEV_SEG_NO_OP_B		0x80	//No operation (ignore lower byte).
-#define	SEV_SEG_DIGIT_8		0x81
-#define	SEV_SEG_DIGIT_9		0x82
-#define	SEV_SEG_DIGIT_10	0x83
-#define	SEV_SEG_DIGIT_11	0x84
-#define	SEV_SEG_DIGIT_12	0x85
-#define	SEV_SEG_DIGIT_13	0x86
-#define	SEV_SEG_DIGIT_14	0x87
-#define	SEV_SEG_DIGIT_15	0x88
-#define	SEV_SEG_DECODE_MODE_B	0x89	//Controls Code B Font for each digit. Simple codes to display 0-9,-,H,E,L,P. 0=off, 1=on for each bit.
-#define	SEV_SEG_INTENSITY_B	0x8A	//Controls intensity (brightness) by setting duty cycle - range from 0x00(min) to 0x0F(max)
-#define	SEV_SEG_SCAN_LIMIT_B	0x8B	//Controls number of digits in the display (0-8) - 0=One digit, 1=Two digits...7=Eight digits.
-#define	SEV_SEG_SHUTDOWN_B	0x8C	//Controls shutdown mode. 0=Shutdown, 1=Normal Operation
-#define	SEV_SEG_DISPLAY_TEST_B	0x8F
+//Register addresses (the same in every chip).
+#define	SEV_SEG_NO_OP		0x00	//No operation (ignore lower byte).
+#define	SEV_SEG_DIGIT(n)	((n) + 1)	//Digit register for digit n (0-7) of a chip.
+#define	SEV_SEG_DECODE_MODE	0x09	//Controls Code B Font for each digit. Simple codes to display 0-9,-,H,E,L,P. 0=off, 1=on for each bit.
+#define	SEV_SEG_INTENSITY	0x0A	//Controls intensity (brightness) by setting duty cycle - range from 0x00(min) to 0x0F(max)
+#define	SEV_SEG_SCAN_LIMIT	0x0B	//Controls number of digits in the display (0-8) - 0=One digit, 1=Two digits...7=Eight digits.
+#define	SEV_SEG_SHUTDOWN	0x0C	//Controls shutdown mode. 0=Shutdown, 1=Normal Operation
+#define	SEV_SEG_DISPLAY_TEST	0x0F
 
 //Non-code B Data (i.e. manual config of 7 segments)
 //	Segments represented by bits:
@@ -92,9 +63,68 @@
 #define SEV_SEG_MANUAL_T	0b00001111
 #define SEV_SEG_MANUAL_U	0b00111110
 #define SEV_SEG_MANUAL_Y	0b00111011
+#define SEV_SEG_MANUAL_Z	0b01101101
 #define SEV_SEG_MANUAL_BLANK	0b00000000
 #define SEV_SEG_MANUAL_DASH	0b00000001
 
+//Compile-time encoding of pseudo-text.  SEV_SEG_CHAR(c) converts a character constant into the manual segment code above (case is ignored).
+//Characters that can't be represented are left blank.
+#define SEV_SEG_CHAR(c)	(								\
+	((c) == '0') ? SEV_SEG_MANUAL_0 :	((c) == '1') ? SEV_SEG_MANUAL_1 :	\
+	((c) == '6') ? SEV_SEG_MANUAL_6 :	((c) == '8') ? SEV_SEG_MANUAL_8 :	\
+	((c) == 'A' || (c) == 'a') ? SEV_SEG_MANUAL_A :				\
+	((c) == 'B' || (c) == 'b') ? SEV_SEG_MANUAL_B :				\
+	((c) == 'C' || (c) == 'c') ? SEV_SEG_MANUAL_C :				\
+	((c) == 'D' || (c) == 'd') ? SEV_SEG_MANUAL_D :				\
+	((c) == 'E' || (c) == 'e') ? SEV_SEG_MANUAL_E :				\
+	((c) == 'F' || (c) == 'f') ? SEV_SEG_MANUAL_F :				\
+	((c) == 'G' || (c) == 'g') ? SEV_SEG_MANUAL_G :				\
+	((c) == 'H' || (c) == 'h') ? SEV_SEG_MANUAL_H :				\
+	((c) == 'I' || (c) == 'i') ? SEV_SEG_MANUAL_I :				\
+	((c) == 'J' || (c) == 'j') ? SEV_SEG_MANUAL_J :				\
+	((c) == 'L' || (c) == 'l') ? SEV_SEG_MANUAL_L :				\
+	((c) == 'N' || (c) == 'n') ? SEV_SEG_MANUAL_N :				\
+	((c) == 'O' || (c) == 'o') ? SEV_SEG_MANUAL_O :				\
+	((c) == 'P' || (c) == 'p') ? SEV_SEG_MANUAL_P :				\
+	((c) == 'R' || (c) == 'r') ? SEV_SEG_MANUAL_R :				\
+	((c) == 'S' || (c) == 's') ? SEV_SEG_MANUAL_S :				\
+	((c) == 'T' || (c) == 't') ? SEV_SEG_MANUAL_T :				\
+	((c) == 'U' || (c) == 'u') ? SEV_SEG_MANUAL_U :				\
+	((c) == 'Y' || (c) == 'y') ? SEV_SEG_MANUAL_Y :				\
+	((c) == 'Z' || (c) == 'z') ? SEV_SEG_MANUAL_Z :				\
+	((c) == '-') ? SEV_SEG_MANUAL_DASH : SEV_SEG_MANUAL_BLANK)
+
+//SEV_SEG_TEXT_N(s) expands to an initialiser list of N manual segment codes from the string literal s (padded with blanks if s is shorter than N).
+//E.g. "static const uint8_t word[7] PROGMEM = {SEV_SEG_TEXT_7("SynCIng")};" is evaluated entirely by the compiler.
+#define SEV_SEG_TEXT_CHAR(s, i)	(((i) < (sizeof(s) - 1)) ? SEV_SEG_CHAR((s)[(i) < (sizeof(s) - 1) ? (i) : 0]) : SEV_SEG_MANUAL_BLANK)
+#define SEV_SEG_TEXT_1(s)	SEV_SEG_TEXT_CHAR(s, 0)
+#define SEV_SEG_TEXT_2(s)	SEV_SEG_TEXT_1(s), SEV_SEG_TEXT_CHAR(s, 1)
+#define SEV_SEG_TEXT_3(s)	SEV_SEG_TEXT_2(s), SEV_SEG_TEXT_CHAR(s, 2)
+#define SEV_SEG_TEXT_4(s)	SEV_SEG_TEXT_3(s), SEV_SEG_TEXT_CHAR(s, 3)
+#define SEV_SEG_TEXT_5(s)	SEV_SEG_TEXT_4(s), SEV_SEG_TEXT_CHAR(s, 4)
+#define SEV_SEG_TEXT_6(s)	SEV_SEG_TEXT_5(s), SEV_SEG_TEXT_CHAR(s, 5)
+#define SEV_SEG_TEXT_7(s)	SEV_SEG_TEXT_6(s), SEV_SEG_TEXT_CHAR(s, 6)
+#define SEV_SEG_TEXT_8(s)	SEV_SEG_TEXT_7(s), SEV_SEG_TEXT_CHAR(s, 7)
+#define SEV_SEG_TEXT_9(s)	SEV_SEG_TEXT_8(s), SEV_SEG_TEXT_CHAR(s, 8)
+#define SEV_SEG_TEXT_10(s)	SEV_SEG_TEXT_9(s), SEV_SEG_TEXT_CHAR(s, 9)
+#define SEV_SEG_TEXT_11(s)	SEV_SEG_TEXT_10(s), SEV_SEG_TEXT_CHAR(s, 10)
+#define SEV_SEG_TEXT_12(s)	SEV_SEG_TEXT_11(s), SEV_SEG_TEXT_CHAR(s, 11)
+#define SEV_SEG_TEXT_13(s)	SEV_SEG_TEXT_12(s), SEV_SEG_TEXT_CHAR(s, 12)
+#define SEV_SEG_TEXT_14(s)	SEV_SEG_TEXT_13(s), SEV_SEG_TEXT_CHAR(s, 13)
+#define SEV_SEG_TEXT_15(s)	SEV_SEG_TEXT_14(s), SEV_SEG_TEXT_CHAR(s, 14)
+#define SEV_SEG_TEXT_16(s)	SEV_SEG_TEXT_15(s), SEV_SEG_TEXT_CHAR(s, 15)
+
+//SEV_SEG_DECODE_IMAGE(n) expands to an initialiser list of SEV_SEG_CHIPS decode mode register values (one per chip) that set the first n digits
+//to manual decode (for pseudo-text) and all other digits to code B.  Evaluated entirely by the compiler (chains of up to 4 chips).
+#define SEV_SEG_DECODE_CHIP(n, chip)	(((n) >= (((chip) * 8) + 8)) ? 0x00 : ((n) <= ((chip) * 8)) ? 0xFF : (uint8_t) (0xFF << ((n) - ((chip) * 8))))
+#define SEV_SEG_DECODE_1(n)		SEV_SEG_DECODE_CHIP(n, 0)
+#define SEV_SEG_DECODE_2(n)		SEV_SEG_DECODE_1(n), SEV_SEG_DECODE_CHIP(n, 1)
+#define SEV_SEG_DECODE_3(n)		SEV_SEG_DECODE_2(n), SEV_SEG_DECODE_CHIP(n, 2)
+#define SEV_SEG_DECODE_4(n)		SEV_SEG_DECODE_3(n), SEV_SEG_DECODE_CHIP(n, 3)
+#define SEV_SEG_DECODE_CHAIN(chips, n)	SEV_SEG_DECODE_##chips(n)
+#define SEV_SEG_DECODE_EXPAND(chips, n)	SEV_SEG_DECODE_CHAIN(chips, n)
+#define SEV_SEG_DECODE_IMAGE(n)		SEV_SEG_DECODE_EXPAND(SEV_SEG_CHIPS, n)
+
 //Code B Data - pass to digit registers if code B font is enabled.  Note, DP set by MSB.
 #define SEV_SEG_CODEB_DASH	0x0A	//G segment only (i.e. a "-") (note, DP off)
 #define SEV_SEG_CODEB_E		0x0B	//Code B encoded for displaying character 'E'
@@ -107,10 +137,17 @@
 #define SEV_SEG_DP	0x80
 
 //MAX7219 control function declarations.
-void sev_seg_write_byte(uint8_t address, uint8_t data);	//Writes a byte to an address the MAX7219s.  One driver will receive data, the other will receive no-op.
-void sev_seg_init(void);				//Initialise both the display drivers.
-void sev_seg_all_clear(void);				//Clears all digits (needs to be in CODE-B mode).
-void sev_seg_power(uint8_t on_or_off);			//Turns display on or off without changing any other registers.
-void sev_seg_decode_mode(uint8_t decode_mode);		//Sets all digits on both drivers to decode mode "manual" or "code B".
-void sev_seg_set_intensity(uint8_t intensity);		//Sets the intesity (brightnes) level of all 16 digits (valid values 0x0 to 0xF).
-void sev_seg_display_int(uint64_t num);			//Takse any 64-bit integer and displays the decimal value using the 16 7-seg digits.
+void sev_seg_write_chip(uint8_t chip, uint8_t address, uint8_t data);	//Writes a register in one chip (SEV_SEG_ALL_CHIPS for all).  Other chips get a no-op.
+void sev_seg_write_row(uint8_t address, const uint8_t *data);		//Writes a register in every chip in one LOAD cycle.  data[c] goes to chip c.
+void sev_seg_write_digit(uint8_t digit, uint8_t data);			//Writes a single digit (0 to SEV_SEG_DIGITS - 1).
+void sev_seg_flush(const uint8_t *buffer);				//Writes all SEV_SEG_DIGITS digits from a buffer in 8 LOAD cycles.
+uint8_t sev_seg_stage(const uint8_t *buffer, const uint8_t *shown);	//Prepares (without sending) the LOAD cycles for the rows that differ.
+void sev_seg_commit(void);						//Queues the staged LOAD cycles in one burst (e.g. from an ISR).
+void sev_seg_unstage(void);						//Discards any staged LOAD cycles.
+uint8_t sev_seg_update(const uint8_t *buffer, const uint8_t *shown);	//Queues the LOAD cycles for the rows that differ now (leaves anything staged).
+void sev_seg_init(void);						//Initialise all of the display drivers.
+void sev_seg_all_clear(void);						//Clears all digits (needs to be in CODE-B mode).
+void sev_seg_power(uint8_t on_or_off);					//Turns display on or off without changing any other registers.
+void sev_seg_decode_mode(uint8_t decode_mode);				//Sets all digits on all drivers to decode mode "manual" or "code B".
+void sev_seg_set_intensity(uint8_t intensity);				//Sets the intesity (brightnes) level of all digits (valid values 0x0 to 0xF).
+void sev_seg_display_int(uint64_t num);					//Takse any 64-bit integer and displays the decimal value, right aligned.
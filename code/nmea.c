@@ -0,0 +1,269 @@
+//Functions for the NMEA sentences received from the GPS and the time sentence re-transmitted for downstream devices.
+
+#include <nmea.h>
+
+static uint8_t nmea_sentence[NMEA_SENTENCE_LENGTH];	//Staged sentence.
+static volatile uint8_t nmea_length = 0;		//Length of the staged sentence.  Only set once it is complete (0 if nothing staged).
+static uint8_t nmea_last_backlog = 0;			//Bytes ahead of the last sentence queued.
+static uint8_t nmea_dropped_count = 0;			//Sentences dropped (wraps at 255).
+
+//Returns the value of an ASCII hexadecimal digit (upper case, as used by NMEA checksums), or 0xFF if it isn't one.
+static uint8_t nmea_hex(char c)
+{
+	if ((c >= '0') && (c <= '9'))
+	{
+		return(c - '0');
+	}
+	if ((c >= 'A') && (c <= 'F'))
+	{
+		return(c - 'A' + 10);
+	}
+	return(0xFF);
+}
+
+//Returns 1 if the sentence ends with a checksum ("*hh", the XOR of everything between '$' and '*') that matches.
+static uint8_t nmea_checksum(const char *sentence)
+{
+	const char *p = &sentence[1];
+	uint8_t checksum = 0;
+
+	while (*p && (*p != '*'))
+	{
+		checksum ^= *p++;
+	}
+	if (!*p || (nmea_hex(p[1]) > 0x0F) || (nmea_hex(p[2]) > 0x0F) || p[3])
+	{
+		return(0);				//No checksum, or something after it.
+	}
+	return(checksum == ((nmea_hex(p[1]) << 4) | nmea_hex(p[2])));
+}
+
+//Returns a pointer to the start of field "n" (0 is the address field, e.g. "GPRMC"), or NULL if the sentence has fewer fields.
+static const char *nmea_field(const char *sentence, uint8_t n)
+{
+	const char *p = &sentence[1];
+
+	while (n)
+	{
+		if (!*p || (*p == '*'))
+		{
+			return(NULL);
+		}
+		if (*p++ == ',')
+		{
+			n--;
+		}
+	}
+	return(p);
+}
+
+//Returns 1 if the sentence type (the three characters after the talker) is "a", "b", "c".
+static uint8_t nmea_type(const char *sentence, char a, char b, char c)
+{
+	return((sentence[3] == a) && (sentence[4] == b) && (sentence[5] == c));
+}
+
+//Pack two ASCII digits into a BCD byte if they are digits with a value from "min" to "max".  Returns 0 (and leaves "bcd") otherwise.
+//Stops at the first non-digit, so never reads past the end of the sentence.
+static uint8_t nmea_bcd(const char *p, uint8_t *bcd, uint8_t min, uint8_t max)
+{
+	uint8_t tens = p[0] - '0';	//Characters below '0' roll over to large values.
+	uint8_t ones;
+
+	if (tens > 9)
+	{
+		return(0);
+	}
+	ones = p[1] - '0';
+	if ((ones > 9) || (((tens * 10) + ones) < min) || (((tens * 10) + ones) > max))
+	{
+		return(0);
+	}
+	*bcd = (tens << 4) | ones;
+	return(1);
+}
+
+//Parse a hhmmss time field (any fraction of a second is ignored).
+static uint8_t nmea_time(const char *field, rtc_time *utc)
+{
+	return(field && nmea_bcd(&field[0], &utc->hours, 0, 23) && nmea_bcd(&field[2], &utc->minutes, 0, 59) &&
+		nmea_bcd(&field[4], &utc->seconds, 0, 59));
+}
+
+//Parse a received sentence ('$' to the checksum, null terminated, without <CR><LF>) into "utc" (packed BCD, year 20xx).
+//Returns NMEA_DATE_TIME (RMC or ZDA), NMEA_TIME (GGA, only the time fields of "utc" are set) or NMEA_NONE.
+//"fix" is updated by RMC and GGA sentences and checked by ZDA sentences.
+//Every access is bounded by the terminating null, so any sequence of bytes is safe to parse.
+uint8_t nmea_parse(const char *sentence, uint8_t *fix, rtc_time *utc)
+{
+	const char *field;
+
+	if ((sentence[0] != '$') || !nmea_checksum(sentence) || (nmea_field(sentence, 1) != &sentence[7]))	//5 character address.
+	{
+		return(NMEA_NONE);
+	}
+
+	if (nmea_type(sentence, 'R', 'M', 'C'))		//$--RMC,hhmmss.ss,A,llll.ll,a,yyyyy.yy,a,x.x,x.x,ddmmyy,x.x,a*hh
+	{
+		field = nmea_field(sentence, 2);
+		*fix = (field && (*field == 'A'));
+		field = nmea_field(sentence, 9);
+		if (*fix && nmea_time(nmea_field(sentence, 1), utc) && field &&
+			nmea_bcd(&field[0], &utc->date, 1, 31) && nmea_bcd(&field[2], &utc->month, 1, 12) && nmea_bcd(&field[4], &utc->year, 0, 99))
+		{
+			utc->month |= RTC_CENTURY;
+			return(NMEA_DATE_TIME);
+		}
+	}
+	else if (nmea_type(sentence, 'G', 'G', 'A'))	//$--GGA,hhmmss.ss,llll.ll,a,yyyyy.yy,a,x,xx,x.x,x.x,M,x.x,M,x.x,xxxx*hh
+	{
+		field = nmea_field(sentence, 6);
+		*fix = (field && (*field >= '1') && (*field <= '5'));	//0 is no fix, 6 is dead reckoning, 7 manual, 8 simulated.
+		if (*fix && nmea_time(nmea_field(sentence, 1), utc))
+		{
+			return(NMEA_TIME);
+		}
+	}
+	else if (nmea_type(sentence, 'Z', 'D', 'A'))	//$--ZDA,hhmmss.ss,dd,mm,yyyy,xx,xx*hh
+	{
+		const char *date = nmea_field(sentence, 2);
+		const char *month = nmea_field(sentence, 3);
+		const char *year = nmea_field(sentence, 4);
+
+		if (*fix && nmea_time(nmea_field(sentence, 1), utc) && date && month && year &&
+			nmea_bcd(date, &utc->date, 1, 31) && nmea_bcd(month, &utc->month, 1, 12) &&
+			(year[0] == '2') && (year[1] == '0') && nmea_bcd(&year[2], &utc->year, 0, 99))
+		{
+			utc->month |= RTC_CENTURY;
+			return(NMEA_DATE_TIME);
+		}
+	}
+	return(NMEA_NONE);
+}
+
+//Start a new stream of received bytes.  A ZDA sentence isn't trusted until an RMC or GGA in the same stream has reported a fix.
+void nmea_receive_init(nmea_receiver *receiver)
+{
+	receiver->length = 0;
+	receiver->fix = 0;
+}
+
+//Add a received byte.  A '$' starts a sentence (dropping any that was cut short) and <CR> or <LF> ends it, when it is parsed into "utc".
+//Returns the result of the parse (see nmea_parse()), or NMEA_NONE if no sentence ended with this byte.
+//A sentence too long to be valid is ignored up to the next '$'.
+uint8_t nmea_receive(nmea_receiver *receiver, uint8_t byte, rtc_time *utc)
+{
+	uint8_t length = receiver->length;
+
+	if (byte == '$')
+	{
+		receiver->line[0] = byte;
+		receiver->length = 1;
+	}
+	else if ((byte == '\r') || (byte == '\n'))
+	{
+		receiver->line[length] = '\0';
+		receiver->length = 0;
+		if (length)
+		{
+			return(nmea_parse(receiver->line, &receiver->fix, utc));
+		}
+	}
+	else if (length && (length < (NMEA_LINE_LENGTH - 1)))
+	{
+		receiver->line[length] = byte;
+		receiver->length = length + 1;
+	}
+	else
+	{
+		receiver->length = 0;
+	}
+	return(NMEA_NONE);
+}
+
+//Write a packed BCD byte as two ASCII digits.  Returns a pointer to the next character.
+static uint8_t *nmea_put_bcd(uint8_t *p, uint8_t bcd)
+{
+	*p++ = '0' + (bcd >> 4);
+	*p++ = '0' + (bcd & 0x0F);
+	return(p);
+}
+
+//Write a character followed by a packed BCD byte (e.g. a delimiter and a field).  Returns a pointer to the next character.
+static uint8_t *nmea_put_field(uint8_t *p, uint8_t delimiter, uint8_t bcd)
+{
+	*p++ = delimiter;
+	return(nmea_put_bcd(p, bcd));
+}
+
+//Format the ZDA sentence for "utc" (years 2000-2099) ready to be queued by nmea_commit().
+//The sentence is complete before the length is set, so nmea_commit() (from an ISR) never sends a partly formatted sentence.
+void nmea_stage(const rtc_time *utc, uint8_t holdover)
+{
+	uint8_t *p = nmea_sentence;
+	uint8_t checksum = 0;
+
+	nmea_length = 0;
+	*p++ = '$';
+	*p++ = holdover ? 'Z' : 'G';
+	*p++ = holdover ? 'Q' : 'P';
+	*p++ = 'Z';
+	*p++ = 'D';
+	*p++ = 'A';
+	p = nmea_put_field(p, ',', utc->hours);
+	p = nmea_put_bcd(p, utc->minutes);
+	p = nmea_put_bcd(p, utc->seconds);
+	p = nmea_put_field(p, '.', 0x00);
+	p = nmea_put_field(p, ',', utc->date);
+	p = nmea_put_field(p, ',', utc->month & RTC_MONTH);
+	p = nmea_put_field(p, ',', 0x20);			//Century.
+	p = nmea_put_bcd(p, utc->year);
+	p = nmea_put_field(p, ',', 0x00);			//Local zone hours.
+	p = nmea_put_field(p, ',', 0x00);			//Local zone minutes.
+
+	for (uint8_t *c = &nmea_sentence[1]; c < p; c++)	//Checksum is the XOR of everything between '$' and '*'.
+	{
+		checksum ^= *c;
+	}
+	*p++ = '*';
+	*p++ = "0123456789ABCDEF"[checksum >> 4];
+	*p++ = "0123456789ABCDEF"[checksum & 0x0F];
+	*p++ = '\r';
+	*p++ = '\n';
+
+	nmea_length = p - nmea_sentence;
+}
+
+//Queue the staged sentence.  Intended to be called from the tick ISR so the sentence starts a fixed time after the second begins.
+//Never waits: if the transmit buffer doesn't have room the sentence is dropped (a late time sentence is worse than none).
+void nmea_commit(void)
+{
+	if (nmea_length)
+	{
+		nmea_last_backlog = (USART_TX_BUFFER_LENGTH - 1) - usart_tx_space();
+		if (!usart_queue(nmea_sentence, nmea_length))
+		{
+			nmea_dropped_count++;
+		}
+		nmea_length = 0;
+	}
+}
+
+//Discard the staged sentence (e.g. the RTC has been re-written so it no longer describes the next second).
+void nmea_unstage(void)
+{
+	nmea_length = 0;
+}
+
+//Returns the number of bytes that were waiting in the transmit buffer when the last sentence was queued.
+//Each delayed the start of the sentence by one byte time (about 1ms at 9600 baud).
+uint8_t nmea_backlog(void)
+{
+	return(nmea_last_backlog);
+}
+
+//Returns the number of sentences dropped because the transmit buffer was full.
+uint8_t nmea_dropped(void)
+{
+	return(nmea_dropped_count);
+}
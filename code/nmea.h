@@ -0,0 +1,51 @@
+//Definitions and declarations for the NMEA sentences received from the GPS and the time sentence re-transmitted for downstream devices.
+
+//Received bytes are passed one at a time to nmea_receive(), which collects each sentence into a line buffer ('$' to the checksum, without
+//<CR><LF>) and parses it once it ends.  Everything it depends on is in the nmea_receiver structure and it doesn't touch the hardware, so the
+//same path can be fed a recorded or synthetic byte stream.  The work per byte is bounded (at most one parse of NMEA_LINE_LENGTH characters),
+//so no input can make it hang.  Any talker is accepted (GP, GN, GL, etc.).
+//Only sentences with a valid checksum that carry the time of a valid fix are used:
+//	RMC	UTC date and time, if the status is A (valid).
+//	GGA	UTC time only, if the fix quality is 1 to 5.
+//	ZDA	UTC date and time.  ZDA has no validity field, so it is only used while the last RMC or GGA received reported a valid fix.
+
+//A $--ZDA sentence (UTC time and date) is formatted during the previous second and queued by the RTC square wave interrupt, so it starts a
+//fixed time after the tick (the interrupt latency plus one byte time for each byte already waiting in the USART transmit buffer).
+//	$GPZDA,hhmmss.00,dd,mm,yyyy,00,00*cs<CR><LF>
+//The talker is GP while the RTC is disciplined by the GPS and ZQ (quartz clock) while in holdover, i.e. the last sync attempt failed.
+//The local zone fields are always zero: the sentence carries UTC and the downstream device applies its own offset.
+
+#ifndef NMEA_H
+#define NMEA_H
+
+#include <avr/io.h>
+#include <usart.h>	//Sentences are sent through the USART transmit buffer.
+#include <ds3234.h>	//For the (packed BCD) rtc_time structure.
+
+#define NMEA_SENTENCE_LENGTH	40	//Longest sentence transmitted (bytes, including the checksum and <CR><LF>).
+#define NMEA_LINE_LENGTH	81	//Longest sentence received (NMEA allows 82 bytes including <CR><LF>) plus the terminating null.
+
+//Contents of a received sentence (returned by nmea_parse()).
+#define NMEA_NONE		0	//Not a valid time sentence (other type, bad checksum, no fix or a bad field).
+#define NMEA_TIME		1	//UTC time only (GGA).  The date must come from elsewhere.
+#define NMEA_DATE_TIME		2	//UTC date and time (RMC or ZDA).
+
+//State of the receive path for one stream of bytes.  Initialise with nmea_receive_init().
+typedef struct
+{
+	char line[NMEA_LINE_LENGTH];	//Sentence being received, from '$' up to (but not including) <CR><LF>.
+	uint8_t length;			//Characters in the line buffer.  0 until a '$' is received.
+	uint8_t fix;			//Set if the last RMC or GGA received reported a valid fix.
+} nmea_receiver;
+
+//Function declarations
+void nmea_receive_init(nmea_receiver *receiver);				//Start a new stream (no sentence in progress, no fix).
+uint8_t nmea_receive(nmea_receiver *receiver, uint8_t byte, rtc_time *utc);	//Add a received byte.  Returns NMEA_x once a sentence ends.
+uint8_t nmea_parse(const char *sentence, uint8_t *fix, rtc_time *utc);	//Parse a received sentence.  Returns NMEA_NONE, NMEA_TIME or NMEA_DATE_TIME.
+void nmea_stage(const rtc_time *utc, uint8_t holdover);	//Format (but don't send) the ZDA sentence for "utc".  Replaces anything already staged.
+void nmea_commit(void);					//Queue the staged sentence without waiting.  Called from the tick ISR.
+void nmea_unstage(void);				//Discard the staged sentence.
+uint8_t nmea_backlog(void);				//Bytes that were waiting in the transmit buffer ahead of the last sentence.
+uint8_t nmea_dropped(void);				//Sentences dropped because the transmit buffer was full.
+
+#endif
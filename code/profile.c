@@ -0,0 +1,114 @@
+//Functions for the cycle profiler.  Nothing is compiled unless PROFILE is defined.
+
+#include <profile.h>
+
+#ifdef PROFILE
+
+#include <usart.h>	//Results are transmitted over serial.
+
+static profile_probe profile_probes[PROFILE_PROBES];
+static uint8_t profile_overhead = 0;			//Cycles counted by an empty section (subtracted from every measurement).
+
+//Measure an empty section.  The cycle timebase must already be running.
+void profile_init(void)
+{
+	uint32_t start;
+
+	start = cycles_now();
+	profile_overhead = cycles_now() - start;
+	profile_clear();
+}
+
+//Record a section that started at cycle "start".
+void profile_record(uint8_t id, uint32_t start)
+{
+	uint32_t cycles = cycles_now() - start;
+	profile_probe *probe = &profile_probes[id];
+	uint8_t bucket = 0;
+
+	cycles = (cycles > profile_overhead) ? (cycles - profile_overhead) : 0;
+	for (uint32_t c = (cycles >> PROFILE_BUCKET_SHIFT); c && (bucket < (PROFILE_BUCKETS - 1)); c >>= 1)
+	{
+		bucket++;
+	}
+
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		if (!probe->count || (cycles < probe->min))
+		{
+			probe->min = cycles;
+		}
+		if (cycles > probe->max)
+		{
+			probe->max = cycles;
+		}
+		if ((probe->count == UINT16_MAX) || ((probe->sum + cycles) < probe->sum))	//Would overflow, so halve both to keep the mean.
+		{
+			probe->sum >>= 1;
+			probe->count >>= 1;
+		}
+		probe->sum += cycles;
+		probe->count++;
+		if (probe->histogram[bucket] < UINT16_MAX)
+		{
+			probe->histogram[bucket]++;
+		}
+	}
+}
+
+//Clear the statistics of all probes.
+void profile_clear(void)
+{
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		for (uint8_t i = 0; i < sizeof(profile_probes); i++)
+		{
+			((uint8_t *) profile_probes)[i] = 0;
+		}
+	}
+}
+
+//Transmit the statistics of a probe on a new line as: id,count,min,mean,max (cycles).
+void profile_print_stats(uint8_t id)
+{
+	profile_probe probe;
+
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		probe = profile_probes[id];
+	}
+
+	usart_print_string("\r\n");
+	usart_print_uint(id);
+	usart_print_string(",");
+	usart_print_uint(probe.count);
+	usart_print_string(",");
+	usart_print_uint(probe.min);
+	usart_print_string(",");
+	usart_print_uint(probe.count ? (probe.sum / probe.count) : 0);
+	usart_print_string(",");
+	usart_print_uint(probe.max);
+}
+
+//Transmit the histogram of a probe on a new line, bucket 0 first, separated by commas.
+void profile_print_histogram(uint8_t id)
+{
+	uint16_t histogram[PROFILE_BUCKETS];
+
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		for (uint8_t b = 0; b < PROFILE_BUCKETS; b++)
+		{
+			histogram[b] = profile_probes[id].histogram[b];
+		}
+	}
+
+	usart_print_string("\r\n ");
+	for (uint8_t b = 0; b < PROFILE_BUCKETS; b++)
+	{
+		usart_print_uint(histogram[b]);
+		usart_print_string((b < (PROFILE_BUCKETS - 1)) ? "," : "");
+	}
+}
+
+#endif
@@ -0,0 +1,65 @@
+//Definitions and declarations for the cycle profiler.
+
+//PROFILE_BEGIN(id) and PROFILE_END(id) bracket a section of code (a probe).  The cycles taken are measured with the 32-bit cycle timebase
+//(cycles.h), so long sections (e.g. a GPS sync) are measured as well as short ones.
+//Each probe collects the minimum, maximum and mean cycle count and a histogram with one bucket per power of two.
+//The measured cost of a probe itself is subtracted.  Results are transmitted by the "profile" console command.
+//The profiler is only compiled in if PROFILE is defined (e.g. "make PROFILE=1").  Otherwise the macros are empty and it costs nothing.
+//A section must reach PROFILE_END() on every path (i.e. before each return) and can't be nested inside a section with the same id.
+//While interrupts are disabled only one overflow can be seen, so a section that keeps them disabled for longer than 65536 cycles (8.2ms) is
+//under-counted by a multiple of 65536 cycles.  The button ISR probe therefore starts after the debounce delay.  A sync requested by the
+//button is run by the main loop, so it is measured in full by the sync_time() probe.
+
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <avr/io.h>
+#include <util/atomic.h>	//Required to use ATOMIC_BLOCK() as probes are recorded from ISRs as well as the main loop.
+#include <cycles.h>		//Sections are measured with the cycle timebase.
+
+//Probes.
+#define PROFILE_RTC_GET_TIME	0	//rtc_get_time(): queue the burst read and wait for it.
+#define PROFILE_SEV_SEG_LOAD	1	//sev_seg_load(): claim a frame, fill it and queue one LOAD cycle.
+#define PROFILE_DISPLAY_RENDER	2	//display_render(): render the date, time and value of a mode.
+#define PROFILE_SYNC_TIME	3	//sync_time(): receive the time from the GPS and set the RTC.
+#define PROFILE_BUTTON_ISR	4	//Button pin-change ISR after the debounce delay (includes anything the button starts).
+#define PROFILE_FRACTION	5	//display_fraction(): interpolate, render and queue the fraction of a second digits.
+#define PROFILE_SEV_SEG_CLAIM	6	//sev_seg_claim(): the only section of sev_seg_load() with interrupts disabled.
+#define PROFILE_TICK_COMMIT	7	//Tick ISR from its first instruction until the staged frame is queued (the display latency after the edge).
+#define PROFILE_PROBES		8	//Number of probes.
+
+#define PROFILE_BUCKETS		12	//Histogram buckets.  Bucket 0 is below 2^PROFILE_BUCKET_SHIFT cycles, the last is 2^15 cycles (4ms) or more.
+#define PROFILE_BUCKET_SHIFT	5	//Bucket b (b > 0) counts sections of 2^(b + 4) to 2^(b + 5) - 1 cycles.
+
+#ifdef PROFILE
+
+//Statistics for one probe.
+typedef struct
+{
+	uint16_t count;				//Sections measured (the mean is sum / count).
+	uint32_t sum;				//Total cycles.  Halved with the count if it would overflow, keeping the mean.
+	uint32_t min;				//Fewest cycles.
+	uint32_t max;				//Most cycles.
+	uint16_t histogram[PROFILE_BUCKETS];	//Sections measured in each bucket (saturates at 65535).
+} profile_probe;
+
+#define PROFILE_INIT()		profile_init()
+#define PROFILE_BEGIN(id)	uint32_t profile_start_##id = cycles_now()
+#define PROFILE_END(id)		profile_record((id), profile_start_##id)
+
+//Function declarations
+void profile_init(void);				//Measure the cost of a probe.  The cycle timebase must be running.
+void profile_record(uint8_t id, uint32_t start);	//Record a section that started at cycle "start".
+void profile_clear(void);				//Clear the statistics of all probes.
+void profile_print_stats(uint8_t id);			//Transmit id,count,min,mean,max on a new line.
+void profile_print_histogram(uint8_t id);		//Transmit the histogram buckets on a new line.
+
+#else
+
+#define PROFILE_INIT()
+#define PROFILE_BEGIN(id)
+#define PROFILE_END(id)
+
+#endif
+
+#endif
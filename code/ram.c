@@ -0,0 +1,48 @@
+//Functions for monitoring SRAM usage.
+
+#include <ram.h>
+
+//Symbols provided by the linker script.
+extern uint8_t __data_start;	//Start of the static variables.
+extern uint8_t _end;		//End of the static variables (start of the unused space).
+extern uint8_t __stack;		//Top of SRAM (RAMEND), where the stack starts.
+
+//Paint the unused SRAM.  Placed in .init1 so it runs straight after reset, before the stack pointer and r1 (zero register) are set up and
+//before anything is on the stack, so it is written in assembler and uses no stack itself.
+void ram_paint(void) __attribute__((naked, used, section(".init1")));
+void ram_paint(void)
+{
+	__asm__ volatile (
+		"	ldi r30, lo8(_end)	\n"	//Z = first unused byte.
+		"	ldi r31, hi8(_end)	\n"
+		"	ldi r24, %0		\n"
+		"	ldi r25, hi8(__stack)	\n"
+		"	rjmp 2f			\n"
+		"1:	st Z+, r24		\n"	//Paint and move up.
+		"2:	cpi r30, lo8(__stack)	\n"
+		"	cpc r31, r25		\n"
+		"	brlo 1b			\n"	//Until Z passes the top of SRAM.
+		"	breq 1b			\n"
+		:: "M" (RAM_CANARY)
+	);
+}
+
+//Returns the bytes of SRAM used by static variables.  Fixed at build time (see "make ram").
+uint16_t ram_static(void)
+{
+	return(&_end - &__data_start);
+}
+
+//Count the painted bytes from the end of the static variables up to the first byte the stack has overwritten.
+//The scan takes about 5 cycles per unused byte (roughly 1ms at 8MHz with 1.5KB unused), so it is only run on request or once a second.
+//A large buffer on the stack that was never written could hide a deeper excursion, so treat the result as an upper bound on the headroom.
+uint16_t ram_stack_unused(void)
+{
+	const uint8_t *p = &_end;
+
+	while ((p <= &__stack) && (*p == RAM_CANARY))
+	{
+		p++;
+	}
+	return(p - &_end);
+}
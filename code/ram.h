@@ -0,0 +1,19 @@
+//Definitions and declarations for monitoring SRAM usage.
+
+//At reset, before the C runtime initialises anything, every byte from the end of the static variables (.data, .bss and .noinit) to the top of
+//SRAM is painted with RAM_CANARY.  The stack grows down into this space, so the lowest byte that has been overwritten marks the deepest the
+//stack has reached since reset (the high-water mark).  The bytes left painted are the headroom that has never been used.
+//Nothing uses the heap (no malloc()), so the space between the static variables and the stack belongs to the stack alone.
+
+#ifndef RAM_H
+#define RAM_H
+
+#include <avr/io.h>
+
+#define RAM_CANARY	0xC5	//Value painted into the unused SRAM.
+
+//Function declarations
+uint16_t ram_static(void);		//Returns the bytes of SRAM used by static variables (.data, .bss and .noinit).
+uint16_t ram_stack_unused(void);	//Returns the bytes of SRAM the stack has never reached since reset.
+
+#endif
@@ -0,0 +1,101 @@
+//Functions for the background re-sync scheduler.
+
+#include <resync.h>
+
+//Count a minute towards the next check.  Called by resync_service() at the start of each minute.
+uint8_t resync_minute(void)
+{
+	resync_minutes++;
+	return(resync_minutes >= resync_interval);
+}
+
+//Record the error (ms, RTC minus GPS) found by a check at GPS time "gps_epoch" (UTC), measured to the millisecond if "phased" or otherwise to
+//whole seconds.  A millisecond error over the time since an in-phase write updates the drift.  An RTC that wasn't set in phase is re-written
+//once it can be, to start the drift measurement.  Returns non-zero if the RTC must be re-written.
+uint8_t resync_assess(int32_t error, uint8_t phased, uint32_t gps_epoch)
+{
+	uint8_t rewrite;
+
+	if (phased)
+	{
+		rewrite = (labs(error) >= RESYNC_THRESHOLD_MS) || !resync_aligned;
+		if (resync_aligned && resync_set && (gps_epoch > resync_set))	//The error has built up since the RTC was last set.
+		{
+			drift = ((int64_t) error * 1000) / (int32_t) (gps_epoch - resync_set);
+		}
+	}
+	else
+	{
+		rewrite = (labs(error) >= (RESYNC_THRESHOLD * 1000L));
+	}
+	resync_error = (error + ((error < 0) ? -500 : 500)) / 1000;	//Positive error means the RTC is running ahead (rounded to seconds).
+	return(rewrite);
+}
+
+//Record that the RTC has just been set to GPS time "utc" (UTC), at the start of that GPS second if "phased".  The error measured by the next
+//check has built up from here.
+void resync_written(uint32_t utc, uint8_t phased)
+{
+	resync_set = utc;
+	resync_aligned = phased;
+}
+
+//Set the interval to the next check after a check at GPS time "gps_epoch" (which re-wrote the RTC if "rewrite"), and restart the count.
+//Once the drift is known, the next check is when it is predicted to have built up the threshold.  Until then the interval is halved after a
+//re-write and doubled while the RTC is still good.
+void resync_reschedule(uint8_t rewrite, uint32_t gps_epoch)
+{
+	if (drift != RESYNC_DRIFT_UNKNOWN)
+	{
+		resync_interval = resync_schedule((resync_set && (gps_epoch > resync_set)) ? (gps_epoch - resync_set) : 0);	//0 once re-written.
+	}
+	else if (rewrite)
+	{
+		resync_interval = clamp_uint16(resync_interval / 2, RESYNC_INTERVAL_MIN, RESYNC_INTERVAL_MAX);
+	}
+	else
+	{
+		resync_interval = clamp_uint16(resync_interval * 2, RESYNC_INTERVAL_MIN, RESYNC_INTERVAL_MAX);
+	}
+	resync_minutes = 0;
+}
+
+//A check found no valid time from the GPS.  Try again after the minimum interval.
+void resync_missed(void)
+{
+	resync_minutes = resync_interval - RESYNC_INTERVAL_MIN;
+}
+
+//Minutes from now until the error built up since the RTC was set is predicted (from the measured drift) to reach RESYNC_THRESHOLD_MS, where
+//"elapsed" is the seconds since the RTC was set (0 if it has just been re-written).  Clamped to the interval limits.
+uint16_t resync_schedule(uint32_t elapsed)
+{
+	uint32_t magnitude = labs(drift);
+	uint32_t seconds;
+
+	if (!magnitude)				//The error isn't growing (within the resolution it was measured to).
+	{
+		return(RESYNC_INTERVAL_MAX);
+	}
+	seconds = ((uint32_t) RESYNC_THRESHOLD_MS * 1000UL) / magnitude;	//Time for the drift to build up the threshold.
+	seconds = (seconds > elapsed) ? (seconds - elapsed) : 0;
+	if (seconds > ((uint32_t) RESYNC_INTERVAL_MAX * SECONDS_IN_A_MINUTE))
+	{
+		return(RESYNC_INTERVAL_MAX);
+	}
+	return(clamp_uint16(seconds / SECONDS_IN_A_MINUTE, RESYNC_INTERVAL_MIN, RESYNC_INTERVAL_MAX));
+}
+
+//Clamp a value to the range "min" to "max".
+uint16_t clamp_uint16(uint16_t value, uint16_t min, uint16_t max)
+{
+	if (value < min)
+	{
+		return(min);
+	}
+	if (value > max)
+	{
+		return(max);
+	}
+	return(value);
+}
@@ -0,0 +1,46 @@
+//Definitions and declarations for the background re-sync scheduler: whether the error found by a check of the RTC against the GPS calls for
+//the RTC to be re-written, the drift it shows and when the next check is due.  The measuring and the RTC writes are done by gps_clock.c
+//(resync_check() and sync_time()).  Nothing here touches the hardware, so it also builds on the host (see test/soak.c).
+//
+//While a time mode is displayed, the RTC is periodically checked against the GPS and only re-written if the error reaches the threshold.
+//The GPS sentence arrives some time after the second it gives, so a whole-second comparison with an RTC read after it is out by up to a
+//second either way.  Instead, the start of the receiver's output for the epoch is timed (gps_get_time()), the RTC is written in phase with the
+//next GPS second (gps_align()) and the error is measured to the millisecond at the RTC's next rollover (resync_measure()).  If the start of the
+//output wasn't seen (the sentence arrived in a burst already under way), only whole seconds can be compared, against RESYNC_THRESHOLD.
+//Once the drift has been measured, the next check is scheduled for when the error built up since the RTC was last set is predicted to reach
+//the threshold (so a slow RTC is checked less often), within the interval limits.  Until then the interval is doubled every time the RTC is
+//found within the threshold and halved every time it is not.
+//Therefore in steady-state the GPS is rarely read and the RTC is rarely re-written (each re-write is a display glitch).
+
+#ifndef RESYNC_H
+#define RESYNC_H
+
+#include <avr/io.h>
+#include <stdlib.h>		//For labs().
+#include <calendar.h>		//For SECONDS_IN_A_MINUTE.
+
+#define RESYNC_INTERVAL_MIN	15		//Shortest interval (minutes) between background checks.
+#define RESYNC_INTERVAL_MAX	1440		//Longest interval (minutes) between background checks (24 hours).
+#define RESYNC_INTERVAL_INIT	60		//Interval (minutes) used after boot or after a manual sync.
+#define RESYNC_THRESHOLD_MS	500		//The RTC is only re-written if the error measured to the millisecond is equal to or greater than this.
+#define RESYNC_THRESHOLD	2		//Or, if only whole seconds could be compared, if the error (seconds) is equal to or greater than this.
+#define RESYNC_DRIFT_UNKNOWN	INT32_MIN	//Value of "drift" until it has been measured.
+
+//Scheduler state (defined in gps_clock.h, and saved for a warm restart).
+extern uint16_t resync_interval;
+extern uint16_t resync_minutes;
+extern int32_t resync_error;
+extern int32_t drift;
+extern uint32_t resync_set;
+extern uint8_t resync_aligned;
+
+//Function declarations
+uint8_t resync_minute(void);					//Count a minute.  Returns non-zero once the re-sync interval has expired.
+uint8_t resync_assess(int32_t error, uint8_t phased, uint32_t gps_epoch);	//Record a check's error.  Returns non-zero if the RTC must be re-written.
+void resync_written(uint32_t utc, uint8_t phased);		//Record that the RTC has been set to GPS time "utc" (in phase with the GPS if "phased").
+void resync_reschedule(uint8_t rewrite, uint32_t gps_epoch);	//Set the interval to the next check after a check at "gps_epoch".
+void resync_missed(void);					//No valid time from the GPS, so try again after the minimum interval.
+uint16_t resync_schedule(uint32_t elapsed);			//Interval (minutes) until the error is predicted to reach the threshold.
+uint16_t clamp_uint16(uint16_t value, uint16_t min, uint16_t max);	//Clamp a value to the range "min" to "max" (also used by gps_clock.c).
+
+#endif
@@ -1,32 +1,150 @@
 //Functions used for serial communications via SPI
+//The RTC and the display drivers share the bus through a queue of transactions.  Each transaction is clocked out by the SPI serial transfer
+//complete interrupt so the CPU is free while bytes shift out, and the bus clock and mode are switched per device between transactions.
+//Interrupts are only disabled briefly to add to the queue, and a transaction is never interleaved with another.
+//If interrupts are disabled (e.g. called from within an ISR), waiting functions service the bus by polling so they can't deadlock.
 
 #include <spi.h>
 
-//Will initialise SPI hardware as master device and frequency/16 then enable.
-void spi_init(uint8_t polarity, uint8_t phase)
+static spi_transaction *spi_queue[SPI_QUEUE_LENGTH];	//Transactions waiting for the bus.  The first is the one being clocked out.
+static volatile uint8_t spi_queue_first = 0;		//Index of the transaction currently on the bus.
+static volatile uint8_t spi_queue_count = 0;		//Number of transactions in the queue (including the one on the bus).
+static uint8_t spi_index;				//Number of data bytes of the current transaction sent so far.
+
+//Will initialise SPI hardware as master device then enable.  The clock rate and mode of each device are set in board.h.
+void spi_init(void)
 {
-	//Set data directions (inputs/outputs) and pull-ups as required
-	SPI_DDR |= (1 << SPI_MOSI);		//MOSI - Output on MOSI
-	SPI_PORT |= (1 << SPI_MISO);	 	//MISO - Left set as an input but pullup activated
-	SPI_DDR |= (1 << SPI_SCK);		//SCK - Output on SCK
-	SPI_DDR |= (1 << PB2);			//PB2 on AVR is designated SS but any I/O pin can be used, the designation is really for when AVR
-						// SPI acts in slave mode.  HOWEVER must always set PB2 to output even if alternate I/O pin is in
-						// use, otherwise AVR defers to other uCUs as per multimaster setup.
-
-	//SPCR = SPI Control Register
-	SPCR |= (1 << SPR1);	//Div 16, safer for breadboards (Slower SPI frequency to reduce chance of interference)
-	SPCR |= (1 << MSTR);	//Clockmaster
-	SPCR |= (1 << SPE);	//Enable SPI
-
-	//Set Polarity/Phase Mode as required for the connected SPI device.
-	SPCR |= (polarity << CPOL);	//CPOL = SPI Clock Polarity, 0 for Clock Idles Low, 1 for clock idles high
-	SPCR |= (phase << CPHA);	//CPHA = SPI Clock Phase, 1 for Data Sampled on Falling Edge, 0 for Rising Edge
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)	//Don't allow a transaction to start while the SPI is being reconfigured.
+	{
+		//Set data directions (inputs/outputs) and pull-ups as required
+		SPI_DDR |= (1 << SPI_MOSI);		//MOSI - Output on MOSI
+		SPI_PORT |= (1 << SPI_MISO);	 	//MISO - Left set as an input but pullup activated
+		SPI_DDR |= (1 << SPI_SCK);		//SCK - Output on SCK
+		SPI_DDR |= (1 << SPI_SS);		//PB2 on AVR is designated SS but any I/O pin can be used, the designation is really for when AVR
+							// SPI acts in slave mode.  HOWEVER must always set PB2 to output even if alternate I/O pin is in
+							// use, otherwise AVR defers to other uCUs as per multimaster setup.
+
+		//SPCR = SPI Control Register
+		SPCR = ((1 << SPR1) | (1 << MSTR) | (1 << SPE));	//Div 16, clockmaster, enable SPI.  Interrupt not enabled until a transaction starts.
+
+		spi_queue_first = 0;
+		spi_queue_count = 0;
+	}
+}
+
+//Apply the device's clock rate and mode, select the device and send the command byte.  Called with interrupts disabled while the bus is idle.
+static void spi_start(spi_transaction *transaction)
+{
+	uint8_t device = transaction->device;
+
+	SPCR = ((1 << SPIE) | (1 << SPE) | (1 << MSTR) | spi_device_spcr(device));	//Clock rate and mode.  SPIE enables the interrupt.
+	SPSR = spi_device_spsr(device);							//Double speed bit.  Other SPSR bits are read only.
+	spi_device_select(device);							//Select the device (active low).
+	spi_index = 0;
+	SPDR = transaction->command;							//SPI starts sending immediately.
+}
+
+//Handle the end of a byte: store the received byte then send the next one, or complete the transaction and start the next in the queue.
+//At fosc/2 and fosc/4 a byte takes less time (16 or 32 cycles) than entering and leaving the ISR, so the rest of the transaction is sent
+//without leaving this function.  Slower clocks return and wait for the next interrupt.
+static void spi_service(void)
+{
+	spi_transaction *transaction = spi_queue[spi_queue_first];
+	uint8_t data;
+
+	do
+	{
+		data = SPDR;						//Received byte.  Reading SPDR (after SPSR) clears SPIF.
+		if(spi_index && transaction->rx)
+		{
+			transaction->rx[spi_index - 1] = data;		//The byte received with the command byte is discarded.
+		}
+
+		if(spi_index < transaction->length)
+		{
+			SPDR = (transaction->tx ? transaction->tx[spi_index] : 0);	//Send the next data byte (zero if there is nothing to send).
+			spi_index++;
+		}
+		else
+		{
+			spi_device_release(transaction->device);			//Release the device.  LOAD rising edge latches the MAX7219s.
+
+			spi_queue_first = ((spi_queue_first + 1) % SPI_QUEUE_LENGTH);
+			spi_queue_count--;
+			transaction->busy = 0;
+			if(transaction->complete)
+			{
+				transaction->complete(transaction);
+			}
+
+			if(spi_queue_count)
+			{
+				spi_start(spi_queue[spi_queue_first]);		//Start the next transaction.
+			}
+			else
+			{
+				SPCR &= ~(1 << SPIE);				//Bus idle, nothing more to interrupt for.
+			}
+			return;
+		}
+
+		if(SPCR & ((1 << SPR1) | (1 << SPR0)))
+		{
+			return;			//Slow clock rate, wait for the next interrupt.
+		}
+		while(!(SPSR & (1 << SPIF))) {}	//Fast clock rate, wait here for the byte to finish.
+	} while(1);
+}
+
+//SPI serial transfer complete.
+ISR(SPI_STC_vect)
+{
+	spi_service();
+}
+
+//If interrupts are disabled the ISR can't run, so service the bus directly whenever a byte has finished.
+void spi_poll(void)
+{
+	if(!(SREG & (1 << SREG_I)) && (SPSR & (1 << SPIF)))
+	{
+		spi_service();
+	}
+}
+
+//Add a transaction to the queue.  Transactions are clocked out in the order they were submitted.
+//If the queue is full, wait until there is space.  To keep a group of transactions together (e.g. set an address then burst), submit them all
+//from within a single ATOMIC_BLOCK(ATOMIC_RESTORESTATE).
+void spi_submit(spi_transaction *transaction)
+{
+	uint8_t queued = 0;
+
+	transaction->busy = 1;
+	while(!queued)
+	{
+		ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+		{
+			if(spi_queue_count < SPI_QUEUE_LENGTH)
+			{
+				spi_queue[(spi_queue_first + spi_queue_count) % SPI_QUEUE_LENGTH] = transaction;
+				if(!spi_queue_count++)
+				{
+					spi_start(transaction);		//Bus was idle so start now.
+				}
+				queued = 1;
+			}
+		}
+		if(!queued)
+		{
+			spi_poll();				//Queue is full.
+		}
+	}
 }
 
-//The basic function used to send and receive a byte via SPI (as a byte rolls out, one rolls in).
-void spi_trade_byte(uint8_t byte)
+//Wait until a submitted transaction is complete.
+void spi_wait(spi_transaction *transaction)
 {
-	SPDR = byte; 				//SPI starts sending immediately.  SPDR=SPI Data Register
-	while(!(SPSR & (1 << SPIF))) {}		//Wait until SPIF (SPI Interrupt Flag) in the SPSR (SPI Status Register) is set indication transfer is complete
-	//SPDR now contains the received byte
+	while(transaction->busy)
+	{
+		spi_poll();
+	}
 }
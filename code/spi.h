@@ -1,13 +1,35 @@
 //Definitions and declarations used for serial communications via SPI
 
+#ifndef SPI_H
+#define SPI_H
+
 #include <avr/io.h>
+#include <board.h>		//Pins, clock rate and mode of each device on the bus.
+#include <avr/interrupt.h>	//Required for the SPI serial transfer complete interrupt.
+#include <util/atomic.h>	//Required to use ATOMIC_BLOCK() so interrupts can be controlled to avoid corrupting the transaction queue.
+#include <stddef.h>		//Required for NULL.
+
+#define SPI_QUEUE_LENGTH	8	//Maximum number of transactions waiting for the bus.
+
+//A transaction is everything clocked out between selecting a device (board.h SPI_DEVICE_*) and releasing it.
+//The device's clock rate and mode are applied at the start of each transaction.
+//The command byte (e.g. a register address) is shifted out first and the byte received with it is discarded.  The "length" data bytes follow.
+//The transaction and its buffers must remain valid until "busy" is cleared.
+typedef struct spi_transaction spi_transaction;
+struct spi_transaction
+{
+	uint8_t device;					//Device to select (SPI_DEVICE_RTC or SPI_DEVICE_SEV_SEG).
+	uint8_t command;				//First byte shifted out.
+	const uint8_t *tx;				//Data bytes to send (NULL sends zeros).
+	uint8_t *rx;					//Received data bytes are stored here (NULL discards them).  May be the same buffer as tx.
+	uint8_t length;					//Number of data bytes following the command byte.
+	void (*complete)(spi_transaction *transaction);	//Called from the ISR once the select line is released (NULL for none).
+	volatile uint8_t busy;				//Set by spi_submit(), cleared once the transaction is complete.
+};
 
-#define SPI_PORT	PORTB	//Port B utilised for SPI comms
-#define SPI_DDR		DDRB	//Data Direction Register B used to set SPI comms input/output pins.
-#define SPI_MOSI	PB3	//Pin B3 used for SPI MOSI (Master Out, Slave In)
-#define SPI_MISO	PB4	//Pin B4 used for SPI MOSI (Master In, Slave Out)
-#define SPI_SCK		PB5	//Pin B5 used for SPI SCK (Synchronous Clock)
-//Note, SS Pin (slave select) not defined to allow compatibility with multiple SPI devices on the bus.  Should be defined in device header.
+void spi_init(void);					//Initialise the SPI hardware as master device and the transaction queue.
+void spi_submit(spi_transaction *transaction);		//Add a transaction to the queue.  Starts immediately if the bus is idle.
+void spi_wait(spi_transaction *transaction);		//Wait until a submitted transaction is complete.
+void spi_poll(void);					//Service the bus by polling if interrupts are disabled.
 
-void spi_init(uint8_t polarity, uint8_t phase);	//Will initialise SPI hardware as master device and frequency/16 then enable.
-void spi_trade_byte(uint8_t byte);		//The basic function used to send and receive a byte via SPI
+#endif
@@ -0,0 +1,128 @@
+//Functions for the sync log kept in the DS3234 battery-backed SRAM.
+
+#include <sync_log.h>
+
+//Local copy of the header so that the SRAM only needs to be read once at boot.
+static sync_log_header header;
+
+//Calculate the header checksum (sum of all bytes other than the checksum itself, inverted).
+static uint8_t sync_log_checksum(void)
+{
+	uint8_t *bytes = (uint8_t *) &header;
+	uint8_t sum = 0;
+
+	for (uint8_t i = 0; i < sizeof(header); i++)
+	{
+		if (&bytes[i] != &header.checksum)
+		{
+			sum += bytes[i];
+		}
+	}
+	return(~sum);
+}
+
+//Load the header from SRAM.  If valid, restore the re-sync scheduler state (warm-start) and return 1.
+//The restored interval is clamped to "interval_min" to "interval_max", as the checksum can't rule out every corrupted value.
+//Otherwise (e.g. first boot or RTC battery replaced) start a new, empty log and return 0.
+uint8_t sync_log_init(int32_t *drift, uint16_t *interval, uint16_t interval_min, uint16_t interval_max)
+{
+	rtc_sram_read(SYNC_LOG_HEADER_ADDRESS, (uint8_t *) &header, sizeof(header));
+
+	if ((header.magic == SYNC_LOG_MAGIC) && (header.checksum == sync_log_checksum()) &&
+		(header.head < SYNC_LOG_SIZE) && (header.count <= SYNC_LOG_SIZE))
+	{
+		*drift = header.drift;
+		*interval = header.interval;
+		if (*interval < interval_min)
+		{
+			*interval = interval_min;
+		}
+		else if (*interval > interval_max)
+		{
+			*interval = interval_max;
+		}
+		return(1);
+	}
+
+	header.magic = SYNC_LOG_MAGIC;		//Start a new log.
+	header.head = 0;
+	header.count = 0;
+	header.drift = *drift;
+	header.interval = *interval;
+	header.checksum = sync_log_checksum();
+	rtc_sram_write(SYNC_LOG_HEADER_ADDRESS, (uint8_t *) &header, sizeof(header));
+	return(0);
+}
+
+//Append a record to the ring buffer (overwriting the oldest if full) and save the re-sync scheduler state to the header.
+void sync_log_add(sync_log_record *record, int32_t drift, uint16_t interval)
+{
+	rtc_sram_write(SYNC_LOG_RECORD_ADDRESS + (header.head * SYNC_LOG_RECORD_SIZE), (uint8_t *) record, SYNC_LOG_RECORD_SIZE);
+
+	header.head++;
+	if (header.head >= SYNC_LOG_SIZE)
+	{
+		header.head = 0;
+	}
+	if (header.count < SYNC_LOG_SIZE)
+	{
+		header.count++;
+	}
+	header.drift = drift;
+	header.interval = interval;
+	header.checksum = sync_log_checksum();
+	rtc_sram_write(SYNC_LOG_HEADER_ADDRESS, (uint8_t *) &header, sizeof(header));
+}
+
+//Transmit all records over serial, oldest first, one per line as: timestamp,error,latency(ms),outcome
+void sync_log_dump(void)
+{
+	sync_log_record record;
+
+	sync_log_print_header();
+	for (uint8_t i = 0; i < header.count; i++)
+	{
+		sync_log_read(i, &record);
+		sync_log_print_record(&record);
+	}
+}
+
+//Returns the number of records in the log.
+uint8_t sync_log_count(void)
+{
+	return(header.count);
+}
+
+//Read record "n" (0 is the oldest) from SRAM.
+void sync_log_read(uint8_t n, sync_log_record *record)
+{
+	uint8_t index = header.head + SYNC_LOG_SIZE - header.count + n;	//Index of the record in the ring buffer.
+
+	while (index >= SYNC_LOG_SIZE)
+	{
+		index -= SYNC_LOG_SIZE;
+	}
+	rtc_sram_read(SYNC_LOG_RECORD_ADDRESS + (index * SYNC_LOG_RECORD_SIZE), (uint8_t *) record, SYNC_LOG_RECORD_SIZE);
+}
+
+//Transmit the saved re-sync scheduler state (drift ppm, interval min) on a new line.
+void sync_log_print_header(void)
+{
+	usart_print_string("\r\nSync log (drift ppm, interval min): ");
+	usart_print_int(header.drift);
+	usart_print_string(",");
+	usart_print_uint(header.interval);
+}
+
+//Transmit a record (timestamp, error s, latency ms, outcome) on a new line.
+void sync_log_print_record(sync_log_record *record)
+{
+	usart_print_string("\r\n");
+	usart_print_uint(record->timestamp);
+	usart_print_string(",");
+	usart_print_int(record->error);
+	usart_print_string(",");
+	usart_print_uint(record->latency * 10);
+	usart_print_string(",");
+	usart_print_uint(record->outcome);
+}
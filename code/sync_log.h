@@ -0,0 +1,60 @@
+//Definitions and declarations for the sync log kept in the DS3234 battery-backed SRAM.
+
+//The log survives a power-cycle (provided the RTC battery is good) without wearing the AVR's eeprom.
+//SRAM map (256 bytes):
+//	0x00 to 0x0F:	Header - identifies a valid log, tracks the ring buffer position and stores the re-sync scheduler state for warm-start.
+//	0x10 to 0xFF:	Ring buffer of SYNC_LOG_SIZE records, each SYNC_LOG_RECORD_SIZE bytes.  Oldest record is overwritten when full.
+
+#ifndef SYNC_LOG_H
+#define SYNC_LOG_H
+
+#include <avr/io.h>
+#include <ds3234.h>	//For battery-backed SRAM access.
+#include <usart.h>	//For dumping the log over serial.
+
+#define SYNC_LOG_MAGIC		0xC5	//Arbitrary value used to identify a valid log header (SRAM contents are random after the battery is replaced).
+#define SYNC_LOG_HEADER_ADDRESS	0x00	//SRAM address of the header.
+#define SYNC_LOG_HEADER_SIZE	16	//Bytes reserved for the header.
+#define SYNC_LOG_RECORD_ADDRESS	0x10	//SRAM address of the first record.
+#define SYNC_LOG_RECORD_SIZE	8	//Bytes in each record (sizeof(sync_log_record)).
+#define SYNC_LOG_SIZE		30	//Number of records in the ring buffer ((256 - 16) / 8).
+
+//Outcomes recorded for each sync attempt.
+#define SYNC_LOG_NO_GPS		0	//No valid time received from the GPS.
+#define SYNC_LOG_IN_SYNC	1	//Background check found the RTC within the threshold, RTC left alone.
+#define SYNC_LOG_RTC_SET	2	//Background check found the RTC outside the threshold, RTC re-written.
+#define SYNC_LOG_MANUAL		3	//Boot, button or offset change sync, RTC re-written without measuring the error.
+
+#define SYNC_LOG_ERROR_UNKNOWN	-32768	//Recorded as the error when the RTC was not compared to the GPS.
+
+//A single log record.  Multi-byte fields are stored little-endian (native AVR order).
+typedef struct
+{
+	uint32_t timestamp;	//UTC epoch time of the attempt.
+	int16_t error;		//Measured RTC error (seconds, RTC minus GPS), clamped to the int16_t range.
+	uint8_t latency;	//Time taken to receive the GPS time (units of 10ms, 255 = 2.55s or more).
+	uint8_t outcome;	//One of SYNC_LOG_NO_GPS, SYNC_LOG_IN_SYNC, SYNC_LOG_RTC_SET or SYNC_LOG_MANUAL.
+} sync_log_record;
+
+//The log header.  Padded to SYNC_LOG_HEADER_SIZE bytes.
+typedef struct
+{
+	uint8_t magic;		//SYNC_LOG_MAGIC if the log is valid.
+	uint8_t head;		//Index of the next record to be written.
+	uint8_t count;		//Number of valid records (up to SYNC_LOG_SIZE).
+	uint8_t checksum;	//Sum of all other header bytes, inverted.
+	int32_t drift;		//Last drift estimate (ppm) from the re-sync scheduler (INT32_MIN until measured).
+	uint16_t interval;	//Last re-sync interval (minutes) from the re-sync scheduler.
+	uint8_t reserved[6];
+} sync_log_header;
+
+//Function declarations
+uint8_t sync_log_init(int32_t *drift, uint16_t *interval, uint16_t interval_min, uint16_t interval_max);	//Load the header (see sync_log.c).
+void sync_log_add(sync_log_record *record, int32_t drift, uint16_t interval);	//Append a record to the ring buffer and save the scheduler state.
+void sync_log_dump(void);					//Transmit all records (oldest first) over serial.
+uint8_t sync_log_count(void);					//Returns the number of records in the log.
+void sync_log_read(uint8_t n, sync_log_record *record);		//Read record "n" (0 is the oldest).
+void sync_log_print_header(void);				//Transmit the saved re-sync scheduler state.
+void sync_log_print_record(sync_log_record *record);		//Transmit a record.
+
+#endif
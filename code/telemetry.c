@@ -0,0 +1,31 @@
+//Functions for the binary telemetry stream transmitted over serial.
+
+#include <telemetry.h>
+
+//Frame a record and add it to the USART transmit buffer.  Returns 1 if queued, 0 if dropped (buffer full or payload too long).
+uint8_t telemetry_send(uint8_t type, const void *payload, uint8_t length)
+{
+	uint8_t frame[TELEMETRY_MAX_PAYLOAD + 4];
+	const uint8_t *bytes = (const uint8_t *) payload;
+	uint8_t crc = 0;
+
+	if (length > TELEMETRY_MAX_PAYLOAD)
+	{
+		return(0);
+	}
+
+	frame[0] = TELEMETRY_START;
+	frame[1] = length;
+	frame[2] = type;
+	for (uint8_t i = 0; i < length; i++)
+	{
+		frame[i + 3] = bytes[i];
+	}
+	for (uint8_t i = 1; i < (length + 3); i++)	//CRC covers everything after the start byte.
+	{
+		crc = _crc8_ccitt_update(crc, frame[i]);
+	}
+	frame[length + 3] = crc;
+
+	return(usart_queue(frame, length + 4));
+}
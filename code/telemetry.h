@@ -0,0 +1,45 @@
+//Definitions and declarations for the binary telemetry stream transmitted over serial.
+
+//Each record is sent as a frame so that a monitor can find it among other serial output (e.g. the sync log dump) and reject corruption:
+//	TELEMETRY_START, length, type, payload (length bytes), CRC-8 (CCITT) of length, type and payload.
+//Multi-byte fields are little-endian (native AVR order).
+//Frames are only added to the USART transmit buffer if there is room for the whole frame, otherwise they are dropped, so sending
+//telemetry never waits for the serial port.  Frames are also discarded while the GPS receiver sleeps (if GPS_POWER_SAVE, see board.h).
+
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <avr/io.h>
+#include <util/crc16.h>	//Required for _crc8_ccitt_update().
+#include <usart.h>	//Frames are sent through the USART transmit buffer.
+
+#define TELEMETRY_START		0xA5	//First byte of every frame.
+#define TELEMETRY_MAX_PAYLOAD	32	//Largest payload (bytes).
+
+//Record types.
+#define TELEMETRY_STATUS	0x01	//telemetry_status, sent once a second by the time display modes.
+
+//Status record.
+typedef struct
+{
+	uint8_t sequence;	//Incremented with each record sent (gaps show dropped frames).
+	uint8_t seconds;	//RTC seconds (BCD) when sent.
+	uint8_t outcome;	//Outcome of the last sync attempt (SYNC_LOG_x).
+	int16_t error;		//RTC error (seconds, RTC minus GPS) measured at the last background check.
+	int16_t drift;		//Drift estimate (ppm) from the re-sync scheduler (-32768 until measured).
+	uint16_t interval;	//Current re-sync interval (minutes).
+	uint8_t rx_frame;	//USART receive frame errors (the line).
+	uint8_t rx_overrun;	//USART receive overruns (interrupts held off too long).
+	uint8_t rx_full;	//Bytes dropped by the full USART receive buffer (the main loop didn't read them).
+	uint8_t dropped;	//Telemetry frames dropped because the transmit buffer was full.
+	uint16_t render_cycles;	//CPU cycles taken to render the last frame.
+	uint16_t idle;		//Time spent idle waiting for the last tick (units of TICK_WAIT_US).
+	uint8_t nmea_backlog;	//Bytes waiting in the transmit buffer ahead of the last NMEA time sentence.
+	uint16_t stack_unused;	//SRAM the stack has never reached since reset (bytes).
+	int16_t clock_error;	//CPU clock error (ppm, positive is fast) measured against the RTC second.
+} telemetry_status;
+
+//Function declarations
+uint8_t telemetry_send(uint8_t type, const void *payload, uint8_t length);	//Frame and queue a record.  Returns 0 if it was dropped.
+
+#endif
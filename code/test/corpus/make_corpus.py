@@ -0,0 +1,210 @@
+#!/usr/bin/env python3
+# Generate the NMEA replay corpus (*.nmea) and the times the parser must find in each stream (*.expected).
+# The streams are synthesized in the NEO-7's default output format (NMEA 2.3, 9600 baud, one navigation epoch per second in the order RMC,
+# VTG, GGA, GSA, GSV..., GLL), laid out as the receiver sends them.  They are not a capture from hardware: replace or add *.nmea files
+# recorded from a receiver (with a matching *.expected) to replay real output.
+#
+# The expected results are worked out here from the NMEA rules the parser implements (see nmea.h), not by running the parser:
+#	RMC	date and time if the checksum is good and the status is A.  Any RMC with a good checksum sets or clears the fix.
+#	GGA	time only if the checksum is good and the fix quality is 1 to 5.  Any GGA with a good checksum sets or clears the fix.
+#	ZDA	date and time if the checksum is good and the last RMC or GGA reported a fix.
+# Run with "make corpus" (in code/test) after changing the streams, and commit the regenerated files.
+
+import datetime
+import os
+import random
+import sys
+
+SECOND = datetime.timedelta(seconds=1)
+
+class Stream:
+	def __init__(self, seed):
+		self.data = bytearray()
+		self.expected = []
+		self.fix = False
+		self.random = random.Random(seed)
+
+	# Add raw bytes (noise, binary messages or a sentence built by hand).
+	def raw(self, data):
+		self.data += data
+
+	# Add a sentence ("body" is everything between '$' and '*').  A good checksum is added unless "checksum" is given.
+	def sentence(self, body, checksum=None, ending=b"\r\n"):
+		if checksum is None:
+			checksum = "%02X" % checksum_of(body)
+		self.data += b"$" + body.encode("ascii") + b"*" + checksum.encode("ascii") + ending
+
+	def date_time(self, t):
+		self.expected.append(t.strftime("D %Y-%m-%d %H:%M:%S"))
+
+	def time(self, t):
+		self.expected.append(t.strftime("T %H:%M:%S"))
+
+	def position(self):
+		return ("%010.5f" % (4717.11 + self.random.uniform(-0.01, 0.01)), "%011.5f" % (833.91 + self.random.uniform(-0.01, 0.01)))
+
+	# Recommended minimum data.  "t" is None before the receiver has the time.
+	def rmc(self, t, valid, talker="GP"):
+		if valid:
+			lat, lon = self.position()
+			self.sentence("%sRMC,%s,A,%s,N,%s,E,0.004,,%s,,,A" % (talker, hhmmss(t), lat, lon, t.strftime("%d%m%y")))
+			self.date_time(t)
+		else:
+			self.sentence("%sRMC,%s,V,,,,,,,%s,,,N" % (talker, hhmmss(t) if t else "", t.strftime("%d%m%y") if t else ""))
+		self.fix = valid
+
+	# Fix data.  Quality 0 is no fix, 1 to 5 are fixes, 6 is dead reckoning.
+	def gga(self, t, quality, talker="GP"):
+		if quality:
+			lat, lon = self.position()
+			self.sentence("%sGGA,%s,%s,N,%s,E,%d,08,1.01,499.6,M,48.0,M,," % (talker, hhmmss(t), lat, lon, quality))
+		else:
+			self.sentence("%sGGA,%s,,,,,0,00,99.99,,,,,," % (talker, hhmmss(t) if t else ""))
+		self.fix = (1 <= quality <= 5)
+		if self.fix:
+			self.time(t)
+
+	# Date and time (not in the NEO-7's default output, but can be enabled with UBX-CFG-MSG).
+	def zda(self, t, talker="GP"):
+		self.sentence("%sZDA,%s,%s,00,00" % (talker, hhmmss(t), t.strftime("%d,%m,%Y")))
+		if self.fix:
+			self.date_time(t)
+
+	# One navigation epoch of the default output, plus ZDA if "zda".
+	def epoch(self, t, valid, zda=False):
+		self.rmc(t, valid)
+		if valid:
+			self.sentence("GPVTG,,T,,M,0.004,N,0.008,K,A")
+		else:
+			self.sentence("GPVTG,,,,,,,,,N")
+		self.gga(t, 1 if valid else 0)
+		if valid:
+			self.sentence("GPGSA,A,3,23,29,07,08,09,18,26,28,,,,,1.94,1.18,1.54")
+			self.sentence("GPGSV,3,1,10,23,38,230,44,29,71,156,47,07,29,116,41,08,09,081,36")
+			self.sentence("GPGSV,3,2,10,09,55,317,45,18,27,284,40,26,35,051,43,28,20,193,39")
+			self.sentence("GPGSV,3,3,10,10,02,014,,13,05,342,")
+			lat, lon = self.position()
+			self.sentence("GPGLL,%s,N,%s,E,%s,A,A" % (lat, lon, hhmmss(t)))
+		else:
+			self.sentence("GPGSA,A,1,,,,,,,,,,,,,99.99,99.99,99.99")
+			self.sentence("GPGSV,1,1,00")
+			self.sentence("GPGLL,,,,,%s,V,N" % (hhmmss(t) if t else ""))
+		if zda and t:
+			self.zda(t)
+
+	def write(self, path):
+		with open(path + ".nmea", "wb") as f:
+			f.write(self.data)
+		with open(path + ".expected", "w") as f:
+			f.write("".join(line + "\n" for line in self.expected))
+
+def checksum_of(body):
+	checksum = 0
+	for c in body.encode("ascii"):
+		checksum ^= c
+	return checksum
+
+def hhmmss(t):
+	return t.strftime("%H%M%S.00")
+
+# Power up with no time, then the time without a fix (status V), then a fix.
+def cold_start():
+	s = Stream(1)
+	t = datetime.datetime(2025, 6, 14, 11, 59, 50)
+	for i in range(5):
+		s.epoch(None, False)
+	for i in range(5):
+		s.epoch(t, False)
+		t += SECOND
+	for i in range(10):
+		s.epoch(t, True)
+		t += SECOND
+	return s
+
+# A steady fix across the end of a year.
+def new_year():
+	s = Stream(2)
+	t = datetime.datetime(2025, 12, 31, 23, 59, 30)
+	for i in range(60):
+		s.epoch(t, True)
+		t += SECOND
+	return s
+
+# A steady fix with ZDA enabled, across a leap day.
+def leap_day():
+	s = Stream(3)
+	t = datetime.datetime(2028, 2, 28, 23, 59, 50)
+	for i in range(20):
+		s.epoch(t, True, zda=True)
+		t += SECOND
+	t = datetime.datetime(2028, 2, 29, 23, 59, 50)
+	for i in range(20):
+		s.epoch(t, True, zda=True)
+		t += SECOND
+	return s
+
+# A multi-constellation receiver (GN talker) that loses and regains the fix.
+def fix_lost():
+	s = Stream(4)
+	t = datetime.datetime(2030, 3, 31, 0, 59, 55)
+	for valid in [True] * 5 + [False] * 5 + [True] * 5:
+		s.rmc(t, valid, talker="GN")
+		s.gga(t, 1 if valid else 0, talker="GN")
+		s.zda(t, talker="GN")
+		t += SECOND
+	return s
+
+# Corrupted input.  Each case notes why it must (or mustn't) give a time.
+def noise():
+	s = Stream(5)
+	t = datetime.datetime(2026, 10, 25, 0, 59, 58)
+	s.raw(bytes(range(256)))							# Every byte value (includes '$', <CR> and <LF>).
+	s.rmc(t, True)									# Good: the parser has recovered.
+	s.sentence("GPRMC,%s,A,4717.11,N,00833.91,E,0.0,,251026,,,A" % hhmmss(t), checksum="00")	# Bad checksum.
+	s.sentence("GPGGA,%s,4717.11,N,00833.91,E,1,08,1.0,499.6,M,48.0,M,," % hhmmss(t), checksum="5b")	# Lower case checksum.
+	s.sentence("GPRMC,%s,A,4717.11,N,00833.91,E,0.0,,251026,,,A" % hhmmss(t), checksum="")	# No checksum digits.
+	s.raw(b"$GPRMC,%s,A,4717.11,N,00833.91,E,0.0,,251026,,,A\r\n" % hhmmss(t).encode())	# No checksum at all.
+	s.raw(b"$GPRMC,%s,A,4717.11,N,008" % hhmmss(t).encode())			# Truncated by the next '$'...
+	t += SECOND
+	s.rmc(t, True)									# ...which is good.
+	s.raw(b"$GPGGA," + b"9" * 200 + b"\r\n")					# Too long for the line buffer.
+	s.raw(b"\xb5\x62\x01\x07\x5c\x00" + bytes(s.random.randrange(256) for i in range(92)) + b"\x00\x00")	# UBX binary (NAV-PVT sized).
+	s.raw(b"\r\n")
+	s.gga(t, 6)									# Dead reckoning: no fix.
+	s.zda(t)									# So ZDA isn't trusted.
+	s.gga(t, 2)									# Differential fix: good.
+	s.zda(t)									# Now ZDA is trusted.
+	t += SECOND
+	s.sentence("GPRMC,%s,A,4717.11,N,00833.91,E,0.0,,321026,,,A" % hhmmss(t))	# Date 32: sets the fix but isn't a valid date.
+	s.sentence("GPRMC,%s,A,4717.11,N,00833.91,E,0.0,,251326,,,A" % hhmmss(t))	# Month 13.
+	s.sentence("GPRMC,246000.00,A,4717.11,N,00833.91,E,0.0,,251026,,,A")		# Hour 24.
+	s.sentence("GPRMC,%s,A,4717.11,N,00833.91,E,0.0,,2510,,,A" % hhmmss(t))	# Short date.
+	s.sentence("GPZDA,%s,25,10,1999,00,00" % hhmmss(t))				# Not 20xx.
+	s.sentence("GPZDA,%s,25,10" % hhmmss(t))					# Missing year.
+	s.sentence("GPZDA,%s,25,10,2026,00,00" % hhmmss(t), checksum="FF", ending=b"\n")	# Bad checksum, <LF> only.
+	s.sentence("GPRMCX,%s,A,4717.11,N,00833.91,E,0.0,,251026,,,A" % hhmmss(t))	# 6 character address.
+	s.sentence("GPRMC,%s,A,4717.11,N,00833.91,E,0.0,,251026,,,A" % hhmmss(t), ending=b"\r")	# Good, <CR> only.
+	s.date_time(t)
+	s.fix = True
+	s.rmc(t, False)									# Status V clears the fix...
+	s.zda(t)									# ...so ZDA isn't trusted.
+	s.raw(b"$\r\n$$$\r\r\n\n*\r\n$*00\r\n")					# Empty and degenerate lines.
+	t += SECOND
+	s.rmc(t, True)
+	s.zda(t)
+	return s
+
+STREAMS = [
+	("neo7_cold_start", cold_start),
+	("neo7_new_year", new_year),
+	("neo7_leap_day", leap_day),
+	("gnss_fix_lost", fix_lost),
+	("noise", noise),
+]
+
+def main(directory):
+	for name, make in STREAMS:
+		make().write(os.path.join(directory, name))
+
+if __name__ == "__main__":
+	main(sys.argv[1] if len(sys.argv) > 1 else os.path.dirname(os.path.abspath(__file__)))
@@ -0,0 +1,10 @@
+//Host stand-in for <avr/interrupt.h>.  There are no interrupts on the host, so an ISR is an ordinary function.
+
+#ifndef HOST_AVR_INTERRUPT_H
+#define HOST_AVR_INTERRUPT_H
+
+#define ISR(vector, ...)	void vector(void)
+#define sei()
+#define cli()
+
+#endif
@@ -0,0 +1,27 @@
+//Host stand-in for <avr/io.h>, so the firmware modules that don't touch the hardware can be built and run on a PC (see ../makefile).
+//The registers are only declared: anything that reads or writes one won't link, which keeps hardware access out of the host build.
+
+#ifndef HOST_AVR_IO_H
+#define HOST_AVR_IO_H
+
+#include <stdint.h>
+
+extern volatile uint8_t PORTB, DDRB, PINB, PORTC, DDRC, PINC, PORTD, DDRD, PIND;
+extern volatile uint8_t SPCR, SPSR, SPDR, SREG;
+
+//Port bits (used by the board.h pin helpers).
+#define PB1	1
+#define PB2	2
+
+//SPCR and SPSR bits (used by the board.h register images).
+#define CPHA	2
+#define CPOL	3
+#define SPI2X	0
+
+//External interrupt control (used by board.h).
+#define ISC01	1
+#define INT0	0
+
+#define SREG_I	7
+
+#endif
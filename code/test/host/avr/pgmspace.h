@@ -0,0 +1,18 @@
+//Host stand-in for <avr/pgmspace.h>.  The host has one address space, so flash reads are ordinary reads.
+
+#ifndef HOST_AVR_PGMSPACE_H
+#define HOST_AVR_PGMSPACE_H
+
+#include <stdint.h>
+#include <string.h>
+
+#define PROGMEM
+#define PSTR(string)		(string)
+#define pgm_read_byte(address)	(*(const uint8_t *) (address))
+#define pgm_read_word(address)	(*(const uint16_t *) (address))
+#define pgm_read_dword(address)	(*(const uint32_t *) (address))
+#define pgm_read_ptr(address)	(*(void * const *) (address))
+#define memcpy_P		memcpy
+#define strcmp_P		strcmp
+
+#endif
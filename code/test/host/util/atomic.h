@@ -0,0 +1,10 @@
+//Host stand-in for <util/atomic.h>.  The host build is single threaded, so an atomic block runs its body once.
+
+#ifndef HOST_UTIL_ATOMIC_H
+#define HOST_UTIL_ATOMIC_H
+
+#define ATOMIC_BLOCK(type)	for (uint8_t atomic_once = 1; atomic_once; atomic_once = 0)
+#define ATOMIC_RESTORESTATE
+#define ATOMIC_FORCEON
+
+#endif
@@ -0,0 +1,10 @@
+//Host stand-in for <util/setbaud.h>.  The USART isn't used on the host (see ../host_usart.c).
+
+#ifndef HOST_UTIL_SETBAUD_H
+#define HOST_UTIL_SETBAUD_H
+
+#define UBRRH_VALUE	0
+#define UBRRL_VALUE	0
+#define USE_2X		0
+
+#endif
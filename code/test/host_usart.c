@@ -0,0 +1,27 @@
+//Host stand-ins for the USART functions called by the modules under test.  Transmitted bytes are discarded.
+
+#include <usart.h>
+
+//The transmit buffer is always empty.
+uint8_t usart_tx_space(void)
+{
+	return(USART_TX_BUFFER_LENGTH - 1);
+}
+
+//Accept (and discard) every message.
+uint8_t usart_queue(const uint8_t *data, uint8_t length)
+{
+	return(1);
+}
+
+void usart_transmit_byte(uint8_t data)
+{
+}
+
+void usart_print_string(const char string[])
+{
+}
+
+void usart_print_string_P(const char *string)
+{
+}
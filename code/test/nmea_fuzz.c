@@ -0,0 +1,61 @@
+//libFuzzer entry point for the GPS receive path.  Every input is fed byte by byte to nmea_receive() (as gps_get_time() does) and also
+//parsed directly as a sentence, and each result is checked.  Build with "make fuzz" (needs clang), or run the same checks without libFuzzer
+//with "make fuzz_host" (see nmea_fuzz_main.c).
+
+#include <stdlib.h>
+#include <string.h>
+#include <nmea.h>
+
+//Returns 1 if "bcd" is a packed BCD value from "min" to "max".
+static uint8_t fuzz_bcd(uint8_t bcd, uint8_t min, uint8_t max)
+{
+	uint8_t value = ((bcd >> 4) * 10) + (bcd & 0x0F);
+
+	return(((bcd >> 4) <= 9) && ((bcd & 0x0F) <= 9) && (value >= min) && (value <= max));
+}
+
+//A time is only returned with valid fields, and only once a fix has been reported.
+static void fuzz_check(uint8_t found, uint8_t fix, const rtc_time *utc)
+{
+	if (found == NMEA_NONE)
+	{
+		return;
+	}
+	if ((found > NMEA_DATE_TIME) || !fix ||
+		!fuzz_bcd(utc->hours, 0, 23) || !fuzz_bcd(utc->minutes, 0, 59) || !fuzz_bcd(utc->seconds, 0, 59))
+	{
+		abort();
+	}
+	if ((found == NMEA_DATE_TIME) && (!(utc->month & RTC_CENTURY) ||
+		!fuzz_bcd(utc->date, 1, 31) || !fuzz_bcd(utc->month & RTC_MONTH, 1, 12) || !fuzz_bcd(utc->year, 0, 99)))
+	{
+		abort();
+	}
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+	nmea_receiver receiver;
+	char sentence[NMEA_LINE_LENGTH];
+	rtc_time utc;
+	uint8_t found;
+	uint8_t fix = 1;
+
+	nmea_receive_init(&receiver);
+	for (size_t i = 0; i < size; i++)
+	{
+		found = nmea_receive(&receiver, data[i], &utc);
+		if (receiver.length >= NMEA_LINE_LENGTH)
+		{
+			abort();
+		}
+		fuzz_check(found, receiver.fix, &utc);
+	}
+
+	size = (size < (NMEA_LINE_LENGTH - 1)) ? size : (NMEA_LINE_LENGTH - 1);
+	memcpy(sentence, data, size);
+	sentence[size] = '\0';
+	found = nmea_parse(sentence, &fix, &utc);
+	fuzz_check(found, fix, &utc);
+	return(0);
+}
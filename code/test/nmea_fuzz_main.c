@@ -0,0 +1,150 @@
+//Stand-alone driver for the fuzz checks in nmea_fuzz.c, for hosts without libFuzzer (e.g. gcc only).
+//	nmea_fuzz_host [-n iterations] [-s seed] file...
+//Each file is checked as it is, then random mutations of them (bytes changed, inserted or deleted, and files spliced together) are checked.
+//Built with the address and undefined behaviour sanitizers, so an out of bounds access fails as well as a failed check.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#define FUZZ_MAX_LENGTH		4096	//Longest mutated input.
+#define FUZZ_ITERATIONS		200000	//Default number of mutated inputs.
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+
+static uint32_t fuzz_state;
+
+//xorshift32 pseudo-random number generator, so a run can be repeated from its seed.
+static uint32_t fuzz_random(void)
+{
+	fuzz_state ^= fuzz_state << 13;
+	fuzz_state ^= fuzz_state >> 17;
+	fuzz_state ^= fuzz_state << 5;
+	return(fuzz_state);
+}
+
+//Bytes that the parser treats specially are chosen more often than the rest.
+static uint8_t fuzz_byte(void)
+{
+	static const uint8_t special[] = "$,*\r\n0123456789ABCDEFAVGPRMCZDAGGA.";
+
+	return((fuzz_random() & 1) ? special[fuzz_random() % (sizeof(special) - 1)] : (uint8_t) fuzz_random());
+}
+
+//Read a whole file (truncated to FUZZ_MAX_LENGTH).
+static size_t fuzz_load(const char *path, uint8_t **data)
+{
+	FILE *file = fopen(path, "rb");
+	size_t length;
+
+	*data = malloc(FUZZ_MAX_LENGTH);
+	if (!file || !*data)
+	{
+		fprintf(stderr, "nmea_fuzz_host: can't read %s\n", path);
+		exit(2);
+	}
+	length = fread(*data, 1, FUZZ_MAX_LENGTH, file);
+	fclose(file);
+	return(length);
+}
+
+int main(int argc, char *argv[])
+{
+	uint32_t iterations = FUZZ_ITERATIONS;
+	uint32_t seed = 1;
+	int first = 1;
+	int count;
+	uint8_t **files;
+	size_t *lengths;
+	uint8_t input[FUZZ_MAX_LENGTH];
+	size_t length;
+
+	while ((first + 1 < argc) && (argv[first][0] == '-'))
+	{
+		if (!strcmp(argv[first], "-n"))
+		{
+			iterations = strtoul(argv[first + 1], NULL, 0);
+		}
+		else if (!strcmp(argv[first], "-s"))
+		{
+			seed = strtoul(argv[first + 1], NULL, 0) | 1;	//xorshift32 never leaves 0.
+		}
+		first += 2;
+	}
+	fuzz_state = seed;
+	count = argc - first;
+	if (count < 1)
+	{
+		fprintf(stderr, "usage: nmea_fuzz_host [-n iterations] [-s seed] file...\n");
+		return(2);
+	}
+	files = calloc(count, sizeof(uint8_t *));
+	lengths = calloc(count, sizeof(size_t));
+	for (int i = 0; i < count; i++)
+	{
+		lengths[i] = fuzz_load(argv[first + i], &files[i]);
+		LLVMFuzzerTestOneInput(files[i], lengths[i]);
+	}
+
+	for (uint32_t n = 0; n < iterations; n++)
+	{
+		int i = fuzz_random() % count;
+		size_t start = lengths[i] ? (fuzz_random() % lengths[i]) : 0;
+
+		length = (fuzz_random() % 512) + 1;				//A window of one file...
+		length = ((start + length) <= lengths[i]) ? length : (lengths[i] - start);
+		memcpy(input, &files[i][start], length);
+		for (uint8_t m = fuzz_random() % 16; m; m--)			//...with up to 15 mutations.
+		{
+			size_t at = length ? (fuzz_random() % length) : 0;
+
+			switch (fuzz_random() % 4)
+			{
+				case 0:						//Change a byte.
+					if (length)
+					{
+						input[at] = fuzz_byte();
+					}
+					break;
+				case 1:						//Insert a byte.
+					if (length < FUZZ_MAX_LENGTH)
+					{
+						memmove(&input[at + 1], &input[at], length - at);
+						input[at] = fuzz_byte();
+						length++;
+					}
+					break;
+				case 2:						//Delete a byte.
+					if (length)
+					{
+						memmove(&input[at], &input[at + 1], length - at - 1);
+						length--;
+					}
+					break;
+				default:					//Splice in part of another file.
+				{
+					int j = fuzz_random() % count;
+					size_t from = lengths[j] ? (fuzz_random() % lengths[j]) : 0;
+					size_t add = fuzz_random() % 128;
+
+					add = ((from + add) <= lengths[j]) ? add : (lengths[j] - from);
+					add = ((length + add) <= FUZZ_MAX_LENGTH) ? add : (FUZZ_MAX_LENGTH - length);
+					memmove(&input[at + add], &input[at], length - at);
+					memcpy(&input[at], &files[j][from], add);
+					length += add;
+					break;
+				}
+			}
+		}
+		LLVMFuzzerTestOneInput(input, length);
+	}
+	printf("%u mutated inputs checked (seed %u)\n", iterations, seed);
+	for (int i = 0; i < count; i++)
+	{
+		free(files[i]);
+	}
+	free(files);
+	free(lengths);
+	return(0);
+}
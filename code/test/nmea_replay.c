@@ -0,0 +1,254 @@
+//Replay recorded or synthetic byte streams through the firmware's GPS receive path (nmea_receive() in ../nmea.c) on the host.
+//	nmea_replay file.nmea			Print each time found (one line each, as in the corpus *.expected files).
+//	nmea_replay -t file.nmea...		Replay the files repeatedly for about a second and report the throughput.
+//	nmea_replay -b file.nmea...		Benchmark the time to sync of each file (see replay_bench()).
+//The times are printed as "D yyyy-mm-dd hh:mm:ss" (NMEA_DATE_TIME) or "T hh:mm:ss" (NMEA_TIME).
+//Host figures only show how the parser scales with its input.  The cycles taken on the AVR are measured with the profiler (see profile.h).
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <nmea.h>
+
+#define REPLAY_MIN_NS	1000000000LL	//Throughput is measured over at least this long.
+#define REPLAY_BYTE_MS	(10000.0 / 9600)	//Time to receive a byte at 9600 baud (start, 8 data and stop bits).
+#define REPLAY_STEP_MS	10			//Interval between the start times tried by the benchmark.
+
+typedef struct
+{
+	uint8_t *data;
+	size_t length;
+} replay_stream;
+
+//Read a whole file.  Exits if it can't be read.
+static void replay_load(const char *path, replay_stream *stream)
+{
+	FILE *file = fopen(path, "rb");
+	long length;
+
+	if (!file || fseek(file, 0, SEEK_END) || ((length = ftell(file)) < 0) || fseek(file, 0, SEEK_SET))
+	{
+		fprintf(stderr, "nmea_replay: can't read %s\n", path);
+		exit(2);
+	}
+	stream->length = length;
+	stream->data = malloc(length ? length : 1);
+	if (!stream->data || (fread(stream->data, 1, length, file) != (size_t) length))
+	{
+		fprintf(stderr, "nmea_replay: can't read %s\n", path);
+		exit(2);
+	}
+	fclose(file);
+}
+
+//Print a parsed time.
+static void replay_print(uint8_t found, const rtc_time *utc)
+{
+	if (found == NMEA_DATE_TIME)
+	{
+		printf("D 20%02x-%02x-%02x ", utc->year, utc->month & RTC_MONTH, utc->date);
+	}
+	else
+	{
+		printf("T ");
+	}
+	printf("%02x:%02x:%02x\n", utc->hours, utc->minutes, utc->seconds);
+}
+
+//Feed every byte of the stream to a new receiver.  Returns the number of times found, printing them if "print" is set.
+static uint32_t replay(const replay_stream *stream, uint8_t print)
+{
+	nmea_receiver receiver;
+	rtc_time utc;
+	uint32_t times = 0;
+	uint8_t found;
+
+	nmea_receive_init(&receiver);
+	for (size_t i = 0; i < stream->length; i++)
+	{
+		found = nmea_receive(&receiver, stream->data[i], &utc);
+		if (found != NMEA_NONE)
+		{
+			times++;
+			if (print)
+			{
+				replay_print(found, &utc);
+			}
+		}
+	}
+	return(times);
+}
+
+static long long replay_now_ns(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return((now.tv_sec * 1000000000LL) + now.tv_nsec);
+}
+
+//Replay all the streams until at least REPLAY_MIN_NS has passed, then report bytes per second and the time per sentence ('$').
+static void replay_throughput(const replay_stream *streams, int count)
+{
+	long long start = replay_now_ns();
+	long long elapsed;
+	unsigned long long bytes = 0;
+	unsigned long long sentences = 0;
+	unsigned long long passes = 0;
+	unsigned long long times = 0;
+
+	do
+	{
+		for (int i = 0; i < count; i++)
+		{
+			times += replay(&streams[i], 0);
+			bytes += streams[i].length;
+		}
+		passes++;
+		elapsed = replay_now_ns() - start;
+	} while (elapsed < REPLAY_MIN_NS);
+
+	for (int i = 0; i < count; i++)
+	{
+		for (size_t j = 0; j < streams[i].length; j++)
+		{
+			sentences += (streams[i].data[j] == '$');
+		}
+	}
+	sentences *= passes;
+	printf("%llu bytes, %llu sentences, %llu times found in %.3f s\n", bytes, sentences, times, elapsed / 1e9);
+	printf("%.0f bytes/s (%.1f ns/byte), %.1f ns/sentence\n", bytes / (elapsed / 1e9), (double) elapsed / bytes, (double) elapsed / sentences);
+}
+
+//Returns 1 if the receiver's line (the sentence just parsed) is an RMC.
+static uint8_t replay_rmc(const nmea_receiver *receiver)
+{
+	return(!strncmp(&receiver->line[3], "RMC", 3));
+}
+
+//Compare for qsort().
+static int replay_compare(const void *a, const void *b)
+{
+	double difference = *(const double *) a - *(const double *) b;
+
+	return((difference > 0) - (difference < 0));
+}
+
+//Print the median and worst of "count" times to sync.
+static void replay_summary(const char *policy, double *times, size_t count)
+{
+	qsort(times, count, sizeof(double), replay_compare);
+	printf("  %-20s median %6.0f ms, worst %6.0f ms\n", policy, times[count / 2], times[count - 1]);
+}
+
+//Time to sync from a start time every REPLAY_STEP_MS through the stream, as gps_get_time() sees it: received bytes are flushed at the start,
+//then a new receiver is fed the bytes that arrive after it until the first time is accepted.  Two policies are compared:
+//	first valid	the first RMC, ZDA or GGA that gives a time (as gps_get_time() does, assuming the RTC date is valid for a GGA).
+//	RMC only	the first valid RMC (as sync_time() did before it accepted ZDA and GGA).
+//There are no timestamps in the stream, so the receiver's timing is modelled: each navigation epoch starts on a whole second with its RMC
+//(the first sentence the NEO-7 sends), and its bytes follow back to back at 9600 baud.  Starts with no time found before the stream ends
+//aren't counted.
+static void replay_bench(const replay_stream *stream, const char *name)
+{
+	double *arrival = malloc((stream->length + 1) * sizeof(double));	//Time (ms) at which each byte has been received.
+	double *first;								//Times to sync for each policy.
+	double *rmc;
+	double end;
+	size_t starts = 0;
+	double epoch = -1000;
+	size_t epoch_start = 0;
+
+	for (size_t i = 0; i < stream->length; i++)
+	{
+		if ((stream->data[i] == '$') && ((i + 6) <= stream->length) && !memcmp(&stream->data[i + 3], "RMC", 3))
+		{
+			epoch += 1000;
+			epoch_start = i;
+		}
+		arrival[i] = ((epoch < 0) ? 0 : epoch) + ((i - epoch_start + 1) * REPLAY_BYTE_MS);
+	}
+
+	end = stream->length ? arrival[stream->length - 1] : 0;
+	first = malloc(((size_t) (end / REPLAY_STEP_MS) + 1) * sizeof(double));
+	rmc = malloc(((size_t) (end / REPLAY_STEP_MS) + 1) * sizeof(double));
+	for (double start = 0; start < end; start += REPLAY_STEP_MS)
+	{
+		nmea_receiver receiver;
+		rtc_time utc;
+		uint8_t found;
+		double found_first = -1;
+		double found_rmc = -1;
+		size_t i = 0;
+
+		nmea_receive_init(&receiver);
+		while ((i < stream->length) && (arrival[i] <= start))
+		{
+			i++;
+		}
+		for (; (i < stream->length) && (found_rmc < 0); i++)
+		{
+			found = nmea_receive(&receiver, stream->data[i], &utc);
+			if ((found != NMEA_NONE) && (found_first < 0))
+			{
+				found_first = arrival[i] - start;
+			}
+			if ((found == NMEA_DATE_TIME) && replay_rmc(&receiver))
+			{
+				found_rmc = arrival[i] - start;
+			}
+		}
+		if (found_rmc >= 0)
+		{
+			first[starts] = found_first;
+			rmc[starts] = found_rmc;
+			starts++;
+		}
+	}
+
+	printf("%s (%zu starts):\n", name, starts);
+	if (starts)
+	{
+		replay_summary("first valid", first, starts);
+		replay_summary("RMC only", rmc, starts);
+	}
+	free(arrival);
+	free(first);
+	free(rmc);
+}
+
+int main(int argc, char *argv[])
+{
+	char mode = ((argc > 1) && (argv[1][0] == '-')) ? argv[1][1] : 0;
+	int first = mode ? 2 : 1;
+	int count = argc - first;
+	replay_stream *streams;
+
+	if ((count < 1) || (!mode && (count > 1)) || (mode && (mode != 't') && (mode != 'b')))
+	{
+		fprintf(stderr, "usage: nmea_replay file.nmea\n       nmea_replay -t file.nmea...\n       nmea_replay -b file.nmea...\n");
+		return(2);
+	}
+	streams = calloc(count, sizeof(replay_stream));
+	for (int i = 0; i < count; i++)
+	{
+		replay_load(argv[first + i], &streams[i]);
+	}
+
+	if (mode == 't')
+	{
+		replay_throughput(streams, count);
+	}
+	else if (mode == 'b')
+	{
+		for (int i = 0; i < count; i++)
+		{
+			replay_bench(&streams[i], argv[first + i]);
+		}
+	}
+	else
+	{
+		replay(&streams[0], 1);
+	}
+	return(0);
+}
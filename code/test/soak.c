@@ -0,0 +1,513 @@
+//Accelerated-time soak of the clock's calendar, time zone and re-sync logic on the host.
+//	soak_test [-z zone] [-d days] [-y year] [-s seed] [-w rollovers]
+//Each zone (all of them unless -z is given) is run second by second for "days" from Jan 1st of "year" (UTC), against a virtual DS3234 that
+//counts the time registers itself, until the RTC's year rolls over from 99 or UTC reaches 2100 (the end of the range of the calendar, see
+//calendar.h, and of the ZDA sentence).  With -w, the run fails unless that many rollovers to 2100 were checked.  The firmware paths are those
+//of gps_clock.c, calling the real calendar.c, zone.c and resync.c:
+//	each second	the frame pre-rendered with next_second() must match the RTC after the tick (including the year and century flag at the
+//			rollover to 2100), and the time read from the RTC must match the reference (the host's IANA time zone database, through
+//			localtime_r()), as must its UTC (local_to_utc()) and the UTC date and time sent in the ZDA sentence.
+//	each minute	resync_service(): zone_correct() once the zone's next transition has passed, and resync_minute() counts towards the check.
+//	each check	resync_check(): the RTC's error (to the millisecond) is passed to resync_assess().  A re-write is in phase with the GPS second
+//			(resync_written()), and resync_reschedule() sets the next check.  One check in SOAK_GPS_MISS finds no GPS time
+//			(resync_missed()).  A check that follows a good one must find the error under SOAK_ERROR_MAX_MS.
+//	injected	the RTC runs fast or slow by up to SOAK_DRIFT_MAX ppb, changing by up to a quarter every SOAK_DRIFT_PERIOD, and the clock is
+//			powered off for random spans of up to SOAK_OFF_MAX seconds (the RTC keeps counting).  It then boots as main() does:
+//			zone_correct(), then a GPS sync (which can also miss), keeping the drift and interval that sync_log_init() restores.
+//The RTC's own UTC is the reference, so the reference is (true UTC + whole seconds the RTC is ahead).  The second at which an offset change
+//takes effect is shown at the old offset, because the change is only applied once that second's frame has been committed (see
+//resync_service()).  Those seconds are counted separately rather than failed.
+//Daylight saving zones can only be compared while their transitions are compiled (ZONE_FIRST_YEAR to ZONE_LAST_YEAR, see zone_table.h).
+
+#define _DEFAULT_SOURCE		//For setenv() and timegm().
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <calendar.h>
+#include <resync.h>
+#define ZONE_TABLE		//For the zone names (the reference uses the IANA zone of the same name).
+#include <zone.h>
+
+#define SOAK_DAYS		450		//Default days per zone (covers a leap day and both daylight saving transitions).
+#define SOAK_YEAR		2027		//Default first year.
+#define SOAK_DRIFT_MAX		20000		//Largest RTC drift (ppb, i.e. 20ppm).
+#define SOAK_DRIFT_PERIOD	(30 * 86400L)	//The drift changes this often (ageing and temperature).
+#define SOAK_GPS_MISS		16		//One GPS read in this many finds no valid time.
+#define SOAK_ERROR_MAX_MS	(2 * RESYNC_THRESHOLD_MS)	//Largest error a check may find if the check before it was good (ms).
+#define SOAK_OFF_PERIOD		(23 * 86400L)	//Mean time between power cycles.
+#define SOAK_OFF_MAX		(3 * 86400L)	//Longest time powered off.
+#define SOAK_QUARTER		900		//Every zone's offset is a whole number of quarter hours, and changes on a quarter hour.
+#define SOAK_ERRORS_MAX		10		//Stop reporting after this many failures per zone.
+#define SOAK_NS			1000000000LL	//Nanoseconds in a second.
+#define SOAK_2100		4102444800UL	//Jan 1st 2100 (UTC seconds since epoch).
+
+//The globals in gps_clock.h used by calendar.c, zone.c and resync.c.
+int8_t offset;
+uint16_t resync_interval;
+uint16_t resync_minutes;
+int32_t resync_error;
+int32_t drift;
+uint32_t resync_set;
+uint8_t resync_aligned;
+
+//Virtual DS3234: counts its time-keeping registers in binary, with its own month lengths (every fourth year a leap year, as the DS3234), and
+//toggles the century flag as the year rolls over from 99 to 00.  "ahead" is how far its count is ahead of UTC, so it gains or loses a
+//second as the drift builds up.
+typedef struct
+{
+	uint8_t century;	//Century flag (RTC_CENTURY in the month register).
+	uint8_t year;		//0-99.
+	uint8_t month;		//1-12.
+	uint8_t date;		//1-31.
+	uint8_t day;		//1-7.
+	uint8_t hours;
+	uint8_t minutes;
+	uint8_t seconds;
+	int64_t ahead;		//Nanoseconds the RTC is ahead of UTC.
+} soak_rtc;
+
+typedef struct
+{
+	unsigned long seconds;		//Seconds checked (powered on).
+	unsigned long transitions;	//Seconds shown at the old offset as the offset changed.
+	unsigned long checks;		//Background checks of the RTC against the GPS.
+	unsigned long rewrites;		//Checks that re-wrote the RTC.
+	unsigned long misses;		//GPS reads (checks and boot syncs) that found no valid time.
+	unsigned long wraps;		//Rollovers from 2099 to 2100 checked.
+	long error_max;			//Largest error (ms) found by a check that followed a good one.
+	unsigned long errors;
+} soak_counts;
+
+static uint32_t soak_state = 1;
+
+//xorshift32 pseudo-random number generator, so a run can be repeated from its seed.
+static uint32_t soak_random(void)
+{
+	soak_state ^= soak_state << 13;
+	soak_state ^= soak_state >> 17;
+	soak_state ^= soak_state << 5;
+	return(soak_state);
+}
+
+//Whole seconds in "ns", rounded down (towards minus infinity).
+static int64_t soak_seconds(int64_t ns)
+{
+	return((ns >= 0) ? (ns / SOAK_NS) : -((SOAK_NS - 1 - ns) / SOAK_NS));
+}
+
+static void soak_rtc_tick(soak_rtc *rtc)
+{
+	static const uint8_t days[12] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+
+	if (++rtc->seconds < 60)
+	{
+		return;
+	}
+	rtc->seconds = 0;
+	if (++rtc->minutes < 60)
+	{
+		return;
+	}
+	rtc->minutes = 0;
+	if (++rtc->hours < 24)
+	{
+		return;
+	}
+	rtc->hours = 0;
+	rtc->day = (rtc->day % 7) + 1;
+	if (++rtc->date <= (days[rtc->month - 1] + ((rtc->month == 2) && !(rtc->year % 4))))
+	{
+		return;
+	}
+	rtc->date = 1;
+	if (++rtc->month <= 12)
+	{
+		return;
+	}
+	rtc->month = 1;
+	if (++rtc->year <= 99)
+	{
+		return;
+	}
+	rtc->year = 0;
+	rtc->century ^= 1;
+}
+
+//Run the RTC for one second of UTC, drifting by "drift_ppb".  Returns the number of times it ticked (0 to 2).
+static uint8_t soak_rtc_run(soak_rtc *rtc, int32_t drift_ppb)
+{
+	int64_t before = soak_seconds(rtc->ahead);
+	uint8_t ticks;
+
+	rtc->ahead += drift_ppb;
+	ticks = 1 + (soak_seconds(rtc->ahead) - before);
+	for (uint8_t i = 0; i < ticks; i++)
+	{
+		soak_rtc_tick(rtc);
+	}
+	return(ticks);
+}
+
+//rtc_get_time() and rtc_set_time() for the virtual DS3234.  Writing it restarts its second, in phase with UTC.
+static void soak_rtc_read(const soak_rtc *rtc, rtc_time *time)
+{
+	time->seconds = BIN_TO_BCD(rtc->seconds);
+	time->minutes = BIN_TO_BCD(rtc->minutes);
+	time->hours = BIN_TO_BCD(rtc->hours);
+	time->day = rtc->day;
+	time->date = BIN_TO_BCD(rtc->date);
+	time->month = BIN_TO_BCD(rtc->month) | (rtc->century ? RTC_CENTURY : 0);
+	time->year = BIN_TO_BCD(rtc->year);
+}
+
+static void soak_rtc_write(soak_rtc *rtc, const rtc_time *time)
+{
+	rtc->seconds = BCD_TO_BIN(time->seconds);
+	rtc->minutes = BCD_TO_BIN(time->minutes);
+	rtc->hours = BCD_TO_BIN(time->hours);
+	rtc->day = time->day;
+	rtc->date = BCD_TO_BIN(time->date);
+	rtc->month = BCD_TO_BIN(time->month & RTC_MONTH);
+	rtc->century = !!(time->month & RTC_CENTURY);
+	rtc->year = BCD_TO_BIN(time->year);
+	rtc->ahead = 0;
+}
+
+//Select the reference time zone for a zone: a POSIX offset for the fixed zones (the sign is inverted), otherwise the IANA zone.
+static void soak_reference_zone(uint8_t zone)
+{
+	char tz[64];
+	int8_t fixed;
+
+	if (zone >= ZONE_FIXED)
+	{
+		snprintf(tz, sizeof(tz), ":%s", (const char *) pgm_read_ptr(&zone_infos[zone - ZONE_FIXED].name));
+	}
+	else
+	{
+		fixed = zone_offset(zone, 0, NULL);
+		snprintf(tz, sizeof(tz), "<ZZZ>%c%d:%02d", (fixed < 0) ? '+' : '-', abs(fixed) / 10, (abs(fixed) % 10) * 6);
+	}
+	setenv("TZ", tz, 1);
+	tzset();
+}
+
+//Broken down local time and UTC of "reference".  localtime_r() and gmtime_r() are only called once per quarter hour, and the seconds
+//counted on from there, as every zone's offset (and every change of it) is a whole number of quarter hours.
+static void soak_reference(time_t reference, struct tm *local, struct tm *utc)
+{
+	static time_t quarter = -1;
+	static struct tm local_quarter, utc_quarter;
+	time_t seconds;
+
+	if ((quarter < 0) || (reference < quarter) || (reference >= (quarter + SOAK_QUARTER)))
+	{
+		quarter = reference - (reference % SOAK_QUARTER);
+		localtime_r(&quarter, &local_quarter);
+		gmtime_r(&quarter, &utc_quarter);
+	}
+	seconds = reference - quarter;
+	*local = local_quarter;
+	local->tm_min += seconds / 60;
+	local->tm_sec = seconds % 60;
+	*utc = utc_quarter;
+	utc->tm_min += seconds / 60;
+	utc->tm_sec = seconds % 60;
+}
+
+//Forget the cached quarter hour (the reference zone has changed).
+static void soak_reference_reset(void)
+{
+	struct tm local, utc;
+
+	soak_reference(-SOAK_QUARTER, &local, &utc);
+}
+
+//Returns 1 if "time" is the broken down time "tm" (and the ISO weekday matches, if "weekday").
+static uint8_t soak_match(const rtc_time *time, const struct tm *tm, uint8_t weekday)
+{
+	return((time->seconds == BIN_TO_BCD(tm->tm_sec)) && (time->minutes == BIN_TO_BCD(tm->tm_min)) && (time->hours == BIN_TO_BCD(tm->tm_hour)) &&
+		(time->date == BIN_TO_BCD(tm->tm_mday)) && ((time->month & RTC_MONTH) == BIN_TO_BCD(tm->tm_mon + 1)) &&
+		(time->year == BIN_TO_BCD(tm->tm_year - 100)) && (!weekday || (time->day == (tm->tm_wday ? tm->tm_wday : 7))));
+}
+
+static void soak_fail(soak_counts *counts, uint8_t zone, uint32_t utc, const char *check, const rtc_time *time)
+{
+	if (++counts->errors <= SOAK_ERRORS_MAX)
+	{
+		printf("  zone %u at UTC %u: %s (shown %s%02x-%02x-%02x %02x:%02x:%02x day %u, offset %d)\n", zone, utc, check,
+			(time->month & RTC_CENTURY) ? "20" : "21", time->year, time->month & RTC_MONTH, time->date, time->hours, time->minutes,
+			time->seconds, time->day, offset);
+	}
+}
+
+//zone_apply(): re-set the RTC if the zone's offset at the RTC's UTC differs from the offset the RTC is set to.
+static void soak_zone_apply(soak_rtc *rtc, uint8_t zone, uint32_t *zone_next)
+{
+	rtc_time rtc_now;
+	int64_t ahead = rtc->ahead;
+
+	soak_rtc_read(rtc, &rtc_now);
+	if (zone_correct(zone, &rtc_now, zone_next))
+	{
+		soak_rtc_write(rtc, &rtc_now);
+		rtc->ahead = ahead;			//Re-written a few ms after its tick, so the error stands.
+	}
+}
+
+//sync_time(): set the RTC in phase with the GPS second "utc", at the zone's offset.
+static void soak_sync(soak_rtc *rtc, uint8_t zone, uint32_t utc, uint32_t *zone_next)
+{
+	rtc_time time;
+
+	resync_written(utc, 1);
+	offset = zone_offset(zone, utc, zone_next);
+	utc_to_local(utc, &time);
+	soak_rtc_write(rtc, &time);
+}
+
+//resync_check(): measure the RTC against the GPS at "utc", re-write it if the scheduler asks and set the next check.
+//Returns 1 if the GPS gave a time.
+static uint8_t soak_check(soak_rtc *rtc, uint8_t zone, uint32_t utc, uint32_t *zone_next, uint8_t bounded, soak_counts *counts)
+{
+	rtc_time time;
+	int32_t error = rtc->ahead / 1000000;	//RTC minus GPS (ms), as resync_measure() finds it at the RTC's next tick.
+	uint8_t rewrite;
+
+	if (!(soak_random() % SOAK_GPS_MISS))
+	{
+		counts->misses++;
+		resync_missed();
+		return(0);
+	}
+
+	counts->checks++;
+	if (bounded)
+	{
+		if (labs(error) > counts->error_max)
+		{
+			counts->error_max = labs(error);
+		}
+		if (labs(error) >= SOAK_ERROR_MAX_MS)
+		{
+			soak_rtc_read(rtc, &time);
+			soak_fail(counts, zone, utc, "error at a check (after a good one) reached SOAK_ERROR_MAX_MS", &time);
+		}
+	}
+
+	rewrite = resync_assess(error, 1, utc);
+	if (rewrite)
+	{
+		counts->rewrites++;
+		soak_sync(rtc, zone, utc, zone_next);
+	}
+	resync_reschedule(rewrite, utc);
+	return(1);
+}
+
+//Run one zone for "seconds" from "start" (UTC), or until the RTC's year rolls over from 99 or UTC reaches 2100.
+static void soak_zone(uint8_t zone, uint32_t start, uint32_t seconds, soak_counts *counts)
+{
+	soak_rtc rtc;
+	rtc_time time;			//Time read from the RTC (what is displayed).
+	rtc_time next;			//Frame pre-rendered for the next second.
+	rtc_time utc;
+	uint32_t zone_next;
+	int32_t drift_ppb = (int32_t) (soak_random() % (2 * SOAK_DRIFT_MAX + 1)) - SOAK_DRIFT_MAX;
+	uint32_t drift_at = start + SOAK_DRIFT_PERIOD;
+	uint32_t off_at = start + (soak_random() % (2 * SOAK_OFF_PERIOD));
+	uint32_t on_at = 0;
+	uint8_t powered = 1;
+	uint8_t rendered = 0;		//Set if "next" was rendered for this second.
+	uint8_t bounded = 1;		//Set while the last GPS read was good and the clock has been powered since.
+	uint8_t last_minute;
+	time_t reference;		//The RTC's UTC.
+	struct tm tm, tm_utc;
+
+	soak_reference_zone(zone);
+	soak_reference_reset();
+	drift = RESYNC_DRIFT_UNKNOWN;		//First boot: the sync log is empty.
+	resync_interval = RESYNC_INTERVAL_INIT;
+	resync_minutes = 0;
+	soak_sync(&rtc, zone, start, &zone_next);
+	soak_rtc_read(&rtc, &time);
+	last_minute = time.minutes;
+
+	for (uint32_t now = start + 1; now != (start + seconds); now++)
+	{
+		if (now >= drift_at)			//Ageing or a change of temperature.
+		{
+			drift_at += SOAK_DRIFT_PERIOD;
+			drift_ppb += (int32_t) (((int64_t) drift_ppb * ((int32_t) (soak_random() % 51) - 25)) / 100);
+			drift_ppb = (drift_ppb > SOAK_DRIFT_MAX) ? SOAK_DRIFT_MAX : ((drift_ppb < -SOAK_DRIFT_MAX) ? -SOAK_DRIFT_MAX : drift_ppb);
+		}
+
+		switch (soak_rtc_run(&rtc, drift_ppb))
+		{
+			case 0 :			//A slow RTC is still in the second it was last seen in (no tick, so nothing to check).
+				continue;
+			case 2 :			//A fast RTC ticked twice since it was last seen.
+				rendered = 0;
+			break;
+		}
+
+		if (!powered)
+		{
+			if (now < on_at)
+			{
+				continue;
+			}
+			powered = 1;			//Boot: correct the RTC for any offset change while off, then sync.
+			soak_zone_apply(&rtc, zone, &zone_next);
+			resync_set = 0;			//Lost with the RAM.
+			resync_aligned = 0;
+			resync_minutes = 0;
+			bounded = !!(soak_random() % SOAK_GPS_MISS);
+			if (bounded)
+			{
+				soak_sync(&rtc, zone, now, &zone_next);
+			}
+			else
+			{
+				counts->misses++;
+			}
+			rendered = 0;
+		}
+
+		soak_rtc_read(&rtc, &time);		//poll() reads the RTC.
+		next.day = time.day;			//next_second() leaves the day of the week (unused by the display).
+		if (rendered && memcmp(&time, &next, sizeof(time)))
+		{
+			soak_fail(counts, zone, now, "pre-rendered frame differs from the RTC", &next);
+		}
+		if (!(time.month & RTC_CENTURY))	//The RTC has rolled over to 2100, the end of the calendar's range.
+		{
+			counts->wraps += rendered;	//Only counted if the rollover's frame was checked.
+			return;
+		}
+		reference = now + soak_seconds(rtc.ahead);
+		if (reference >= SOAK_2100)		//UTC has reached 2100 (the RTC is still in 2099 at a negative offset).
+		{
+			return;
+		}
+		counts->seconds++;
+
+		soak_reference(reference, &tm, &tm_utc);
+		if (local_to_utc(&time) != (uint32_t) reference)
+		{
+			soak_fail(counts, zone, now, "local_to_utc() differs from the reference", &time);
+		}
+		else if (soak_match(&time, &tm, 1))
+		{
+		}
+		else if ((uint32_t) reference >= zone_next)	//The offset changes at this second, and is applied once it has been shown.
+		{
+			counts->transitions++;
+		}
+		else
+		{
+			soak_fail(counts, zone, now, "local time differs from the reference", &time);
+		}
+		epoch_to_time(local_to_utc(&time), &utc);	//nmea_prepare(): the ZDA sentence carries UTC.
+		if (!soak_match(&utc, &tm_utc, 1))
+		{
+			soak_fail(counts, zone, now, "UTC (ZDA) differs from the reference", &utc);
+		}
+
+		if (time.minutes != last_minute)	//resync_service(): once a minute.
+		{
+			last_minute = time.minutes;
+			if (local_to_utc(&time) >= zone_next)
+			{
+				soak_zone_apply(&rtc, zone, &zone_next);
+				soak_rtc_read(&rtc, &time);
+				last_minute = time.minutes;
+			}
+			if (resync_minute())
+			{
+				bounded = soak_check(&rtc, zone, now, &zone_next, bounded, counts);
+				soak_rtc_read(&rtc, &time);
+				last_minute = time.minutes;
+			}
+		}
+
+		next = time;				//Pre-render the next second.
+		next_second(&next);
+		rendered = 1;
+
+		if (now >= off_at)			//Power off.  The RTC keeps counting.
+		{
+			powered = 0;
+			on_at = now + 1 + (soak_random() % SOAK_OFF_MAX);
+			off_at = on_at + (soak_random() % (2 * SOAK_OFF_PERIOD));
+			rendered = 0;
+		}
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	int first_zone = 0;
+	int last_zone = ZONE_COUNT - 1;
+	long days = SOAK_DAYS;
+	int year = SOAK_YEAR;
+	long wraps = -1;		//Rollovers to 2100 expected (-1 if not checked).
+	struct tm tm = {0};
+	uint32_t start;
+	soak_counts counts = {0};
+	struct timespec begin, end;
+	double elapsed;
+
+	for (int i = 1; (i + 1) < argc; i += 2)
+	{
+		if (!strcmp(argv[i], "-z"))
+		{
+			first_zone = last_zone = atoi(argv[i + 1]);
+		}
+		else if (!strcmp(argv[i], "-d"))
+		{
+			days = atol(argv[i + 1]);
+		}
+		else if (!strcmp(argv[i], "-y"))
+		{
+			year = atoi(argv[i + 1]);
+		}
+		else if (!strcmp(argv[i], "-s"))
+		{
+			soak_state = strtoul(argv[i + 1], NULL, 0) | 1;
+		}
+		else if (!strcmp(argv[i], "-w"))
+		{
+			wraps = atol(argv[i + 1]);
+		}
+	}
+	if ((first_zone < 0) || (last_zone >= ZONE_COUNT) || (days < 1) || (year < 2001) || (year > 2099))
+	{
+		fprintf(stderr, "usage: soak_test [-z zone] [-d days] [-y year] [-s seed] [-w rollovers]  (zone 0-%d, year 2001 to 2099)\n", ZONE_COUNT - 1);
+		return(2);
+	}
+	tm.tm_year = year - 1900;
+	tm.tm_mday = 1;
+	start = timegm(&tm);
+
+	clock_gettime(CLOCK_MONOTONIC, &begin);
+	for (int zone = first_zone; zone <= last_zone; zone++)
+	{
+		soak_zone(zone, start, days * SECONDS_IN_A_DAY, &counts);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	elapsed = (end.tv_sec - begin.tv_sec) + ((end.tv_nsec - begin.tv_nsec) / 1e9);
+
+	printf("%d zones x %ld days from %d: %lu seconds checked, %lu shown at the old offset as it changed, %lu rollovers to 2100, %lu failures\n",
+		last_zone - first_zone + 1, days, year, counts.seconds, counts.transitions, counts.wraps, counts.errors);
+	printf("%lu checks, %lu re-writes, %lu GPS misses, largest error after a good check %ldms\n",
+		counts.checks, counts.rewrites, counts.misses, counts.error_max);
+	printf("%.0f simulated days/s\n", (counts.seconds / (double) SECONDS_IN_A_DAY) / elapsed);
+	if ((wraps >= 0) && (counts.wraps != (unsigned long) wraps))
+	{
+		printf("expected %ld rollovers to 2100\n", wraps);
+		return(1);
+	}
+	return(counts.errors ? 1 : 0);
+}
@@ -0,0 +1,59 @@
+//Functions for the UBX (u-blox binary protocol) messages sent to the GPS receiver.
+
+#include <ubx.h>
+
+//Frame a message and add it to the USART transmit buffer.  Returns 1 if queued, 0 if not (buffer full or payload too long).
+uint8_t ubx_send(uint8_t class, uint8_t id, const void *payload, uint8_t length)
+{
+	uint8_t frame[UBX_MAX_PAYLOAD + 8];
+	const uint8_t *bytes = (const uint8_t *) payload;
+	uint8_t ck_a = 0;
+	uint8_t ck_b = 0;
+
+	if (length > UBX_MAX_PAYLOAD)
+	{
+		return(0);
+	}
+
+	frame[0] = UBX_SYNC_1;
+	frame[1] = UBX_SYNC_2;
+	frame[2] = class;
+	frame[3] = id;
+	frame[4] = length;
+	frame[5] = 0;				//Length is 16 bits, but no payload sent is longer than 255 bytes.
+	for (uint8_t i = 0; i < length; i++)
+	{
+		frame[i + 6] = bytes[i];
+	}
+	for (uint8_t i = 2; i < (length + 6); i++)	//Checksum covers everything after the sync bytes.
+	{
+		ck_a += frame[i];
+		ck_b += ck_a;
+	}
+	frame[length + 6] = ck_a;
+	frame[length + 7] = ck_b;
+
+	return(usart_queue(frame, length + 8));
+}
+
+//Put the receiver into backup mode.  It wakes by itself after "duration" ms (or earlier, see ubx_wake()).
+uint8_t ubx_backup(uint32_t duration)
+{
+	ubx_rxm_pmreq request;
+
+	request.duration = duration;
+	request.flags = UBX_PMREQ_BACKUP;
+	return(ubx_send(UBX_CLASS_RXM, UBX_ID_RXM_PMREQ, &request, sizeof(request)));
+}
+
+//Wake the receiver from backup mode by sending it a few bytes.  Harmless if it is already awake.
+uint8_t ubx_wake(void)
+{
+	uint8_t bytes[UBX_WAKE_LENGTH];
+
+	for (uint8_t i = 0; i < UBX_WAKE_LENGTH; i++)
+	{
+		bytes[i] = UBX_WAKE_BYTE;
+	}
+	return(usart_queue(bytes, UBX_WAKE_LENGTH));
+}
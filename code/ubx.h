@@ -0,0 +1,43 @@
+//Definitions and declarations for the UBX (u-blox binary protocol) messages sent to the GPS receiver.
+
+//Each message is sent as a frame:
+//	UBX_SYNC_1, UBX_SYNC_2, class, id, length (2 bytes), payload (length bytes), CK_A, CK_B
+//The checksum is an 8-bit Fletcher checksum of class, id, length and payload.  Multi-byte fields are little-endian (native AVR order).
+//Frames are only added to the USART transmit buffer if there is room for the whole frame, otherwise nothing is sent, so this never waits
+//for the serial port.  The NMEA, console and telemetry output shares the line, and any of it wakes the receiver from backup mode, so the
+//caller must hold the USART transmitter (usart_tx_hold()) once ubx_backup() has queued the request, and release it before ubx_wake().
+
+#ifndef UBX_H
+#define UBX_H
+
+#include <avr/io.h>
+#include <usart.h>	//Frames are sent through the USART transmit buffer.
+
+#define UBX_SYNC_1		0xB5	//First byte of every frame.
+#define UBX_SYNC_2		0x62	//Second byte of every frame.
+#define UBX_MAX_PAYLOAD		8	//Largest payload sent (bytes).
+
+//Message classes and ids.
+#define UBX_CLASS_RXM		0x02	//Receiver manager messages.
+#define UBX_ID_RXM_PMREQ	0x41	//Power management request.
+
+//UBX-RXM-PMREQ flags.
+#define UBX_PMREQ_BACKUP	(1 << 1)	//Enter backup mode (the receiver keeps its ephemeris and time for a hot start).
+
+//Wake-up.  Activity on the receiver's RXD wakes it from backup mode early.  The bytes themselves are lost, so they are 0xFF (idle-like).
+#define UBX_WAKE_BYTE		0xFF
+#define UBX_WAKE_LENGTH		8
+
+//UBX-RXM-PMREQ payload.
+typedef struct
+{
+	uint32_t duration;	//Time (ms) to stay in backup mode before waking by itself.  0 means until woken.
+	uint32_t flags;		//UBX_PMREQ_BACKUP.
+} ubx_rxm_pmreq;
+
+//Function declarations
+uint8_t ubx_send(uint8_t class, uint8_t id, const void *payload, uint8_t length);	//Frame and queue a message.  Returns 0 if it wasn't sent.
+uint8_t ubx_backup(uint32_t duration);	//Put the receiver into backup mode for "duration" ms.  Returns 0 if the request wasn't sent.
+uint8_t ubx_wake(void);			//Wake the receiver from backup mode.  Returns 0 if the wake-up bytes weren't sent.
+
+#endif
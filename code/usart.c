@@ -2,6 +2,19 @@
 
 #include <usart.h>
 
+static uint8_t usart_tx_buffer[USART_TX_BUFFER_LENGTH];	//Bytes waiting to be transmitted.
+static volatile uint8_t usart_tx_head = 0;		//Index at which the next byte will be added.
+static volatile uint8_t usart_tx_tail = 0;		//Index of the next byte to be transmitted.  Buffer is empty when head == tail.
+static uint8_t usart_rx_buffer[USART_RX_BUFFER_LENGTH];	//Bytes received but not yet read.
+static volatile uint8_t usart_rx_head = 0;		//Index at which the next received byte will be stored.
+static volatile uint8_t usart_rx_tail = 0;		//Index of the next byte to be read.  Buffer is empty when head == tail.
+static usart_errors usart_error_count;			//Receive errors.
+static volatile uint8_t usart_tx_holding = 0;		//Set while new bytes are discarded rather than transmitted.
+
+#define USART_TX_MASK		(USART_TX_BUFFER_LENGTH - 1)
+#define USART_TX_FREE		((uint8_t) (usart_tx_tail - usart_tx_head - 1) & USART_TX_MASK)	//Bytes that can be added (one slot is always left empty).
+#define USART_RX_MASK		(USART_RX_BUFFER_LENGTH - 1)
+
 //Initialise the USART peripheral.
 void usart_init(void)
 {
@@ -15,7 +28,7 @@ void usart_init(void)
 		UCSR0A &= ~(1 << U2X0);
 	#endif
 
-	UCSR0B = (1 << TXEN0) | (1 << RXEN0);		//UCSR0B = USART0 Control and Status Register B
+	UCSR0B = (1 << RXCIE0) | (1 << TXEN0) | (1 << RXEN0);	//UCSR0B = USART0 Control and Status Register B
 							//RXCIE0 = USART0 RX Complete Interrupt Enable
 							//TXEN0 = Transmit Enable USART0
 							//RXEN0 = Receive Enable USART0
@@ -25,19 +38,165 @@ void usart_init(void)
 							//(USBS = Usart Stop Bit Select, Stays at 0b0 for 1 stop bit).
 }
 
-//Returns a byte as received by the USART.
+//Change the baud rate at runtime.  Unlike usart_init(), the register value is calculated when called rather than by util/setbaud.h.
+//Double-speed mode is always used as it gives the smallest error for the higher baud rates at F_CPU = 8MHz.
+void usart_set_baud(uint32_t baud)
+{
+	UCSR0A |= (1 << U2X0);					//U2X0 = Double USART0 Transmission Speed Enable
+	UBRR0 = ((F_CPU + (4 * baud)) / (8 * baud)) - 1;	//Rounded to the nearest whole value.  UBRR0 = USART0 Baud Rate Register.
+}
+
+//Move a received byte from the data register to the receive buffer.  Frame errors, overruns and bytes dropped by a full buffer are counted.
+static void usart_rx_service(void)
+{
+	uint8_t status = UCSR0A;			//Error flags must be read before UDR0.
+	uint8_t data = UDR0;				//UDR0 = USART0 Data Register
+	uint8_t head = ((usart_rx_head + 1) & USART_RX_MASK);
+
+	if (status & (1 << FE0))			//FE0 = Frame Error.
+	{
+		usart_error_count.frame++;
+	}
+	if (status & (1 << DOR0))			//DOR0 = Data OverRun.
+	{
+		usart_error_count.overrun++;
+	}
+	if (head == usart_rx_tail)			//No room in the receive buffer.
+	{
+		usart_error_count.full++;
+	}
+	else
+	{
+		usart_rx_buffer[usart_rx_head] = data;
+		usart_rx_head = head;
+	}
+}
+
+//USART0 receive complete.
+ISR(USART_RX_vect)
+{
+	usart_rx_service();
+}
+
+//Returns a byte as received by the USART.  Waits until one has been received.
 uint8_t usart_receive_byte(void)
 {
-	while (!(UCSR0A & (1 << RXC0))) {}		//Wait until the USART0 receive complete flag is set
-	return UDR0;					//Returns received data.  UDR0 = USART0 Data Register
+	uint8_t data;
+
+	while (!usart_byte_waiting()) {}		//Wait until a byte has been received.
+	data = usart_rx_buffer[usart_rx_tail];
+	usart_rx_tail = ((usart_rx_tail + 1) & USART_RX_MASK);
+	return(data);
+}
+
+//Returns non-zero if a received byte is waiting to be read.  Unlike usart_receive_byte(), this will not block.
+uint8_t usart_byte_waiting(void)
+{
+	usart_poll();					//Interrupts may be disabled.
+	return (usart_rx_head != usart_rx_tail);
+}
+
+//Discard all received bytes that haven't been read (e.g. so that only data received after a request is parsed).
+void usart_rx_flush(void)
+{
+	usart_rx_tail = usart_rx_head;
+}
+
+//Copy the receive error counters.
+void usart_get_errors(usart_errors *errors)
+{
+	*errors = usart_error_count;
+}
+
+//Move the next byte from the transmit buffer to the data register, or disable the interrupt once the buffer is empty.
+static void usart_tx_service(void)
+{
+	if (usart_tx_tail != usart_tx_head)
+	{
+		UDR0 = usart_tx_buffer[usart_tx_tail];			//UDR0 = USART0 Data Register
+		usart_tx_tail = ((usart_tx_tail + 1) & USART_TX_MASK);
+	}
+	else
+	{
+		UCSR0B &= ~(1 << UDRIE0);				//Nothing left to send.  UDRIE0 = Data Register Empty Interrupt Enable.
+	}
+}
+
+//USART0 data register empty.
+ISR(USART_UDRE_vect)
+{
+	usart_tx_service();
+}
+
+//If interrupts are disabled the ISRs can't run, so transmit whenever the data register is empty and receive whenever a byte has arrived.
+void usart_poll(void)
+{
+	if (!(SREG & (1 << SREG_I)))
+	{
+		if ((UCSR0A & (1 << UDRE0)) && (UCSR0B & (1 << UDRIE0)))
+		{
+			usart_tx_service();
+		}
+		if (UCSR0A & (1 << RXC0))
+		{
+			usart_rx_service();
+		}
+	}
 }
 
-//Transmits a byte from the USART.
+//Returns the number of bytes that can be added to the transmit buffer without waiting.
+uint8_t usart_tx_space(void)
+{
+	return(USART_TX_FREE);
+}
+
+//Hold (discard new bytes) or release transmission.  Bytes already in the buffer are still sent, so the last message queued before the hold
+//(e.g. a power-down request) isn't cut short.
+void usart_tx_hold(uint8_t hold)
+{
+	usart_tx_holding = hold;
+}
+
+//Returns non-zero if transmission is held.
+uint8_t usart_tx_held(void)
+{
+	return(usart_tx_holding);
+}
+
+//Adds a byte to the transmit buffer.  Only waits if the buffer is full.
 void usart_transmit_byte(uint8_t data)
 {
-	while (!(UCSR0A & (1 << UDRE0))) {}		//Wait until the USART0 data register is empty (ready to transmit).
-       							//Otherwise operates too fast and drops characters.
-	UDR0 = data;					//UDR0 = USART0 Data Register
+	while (!usart_queue(&data, 1))
+	{
+		usart_poll();					//Buffer is full.
+	}
+}
+
+//Adds all "length" bytes to the transmit buffer, or none of them if there isn't room.  Never waits.  Returns 1 if the bytes were added.
+//Atomic so that bytes added by an ISR can't be interleaved.
+//While transmission is held the bytes are discarded and 1 is returned, as they will never be sent (so callers don't count them as dropped).
+uint8_t usart_queue(const uint8_t *data, uint8_t length)
+{
+	uint8_t queued = 0;
+
+	if (usart_tx_holding)
+	{
+		return(1);
+	}
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		if (USART_TX_FREE >= length)
+		{
+			for (uint8_t i = 0; i < length; i++)
+			{
+				usart_tx_buffer[usart_tx_head] = data[i];
+				usart_tx_head = ((usart_tx_head + 1) & USART_TX_MASK);
+			}
+			UCSR0B |= (1 << UDRIE0);			//The interrupt fires as soon as the data register is empty.
+			queued = 1;
+		}
+	}
+	return(queued);
 }
 
 //Transmits a string of characters.
@@ -51,14 +210,22 @@ void usart_print_string(const char string[])
 	}
 }
 
+//Transmits a string of characters stored in flash (e.g. PSTR("text")).
+void usart_print_string_P(const char *string)
+{
+	char character;
+
+	while ((character = pgm_read_byte(string++)) != '\0')
+	{
+		usart_transmit_byte(character);
+	}
+}
+
 //Takes an integer and transmits the characters.
 void usart_print_byte(uint8_t byte)
 {
-	//while (!(UCSR0A & (1 << UDRE0))) {}		//Wait until the USART 0 data register is empty (ready to transmit).
 	//usart_transmit_byte('0'+ (byte/100));		//Hundreds
-	while (!(UCSR0A & (1 << UDRE0))) {}		//Wait until the USART 0 data register is empty (ready to transmit).
 	usart_transmit_byte('0'+ ((byte/10) % 10));	//Tens
-	while (!(UCSR0A & (1 << UDRE0))) {}		//Wait until the USART 0 data register is empty (ready to transmit).
 	usart_transmit_byte('0'+ (byte % 10));		//Ones
 }
 
@@ -78,3 +245,47 @@ void usart_print_binary_byte(uint8_t byte)
 		}
 	}
 }
+
+//Takes an integer and transmits two hexadecimal characters (upper case).
+void usart_print_hex(uint8_t byte)
+{
+	uint8_t nibble;
+
+	for (uint8_t i = 0; i < 2; i++)
+	{
+		nibble = (i ? byte : (byte >> 4)) & 0x0F;
+		usart_transmit_byte((nibble < 10) ? ('0' + nibble) : ('A' + nibble - 10));
+	}
+}
+
+//Takes an unsigned 32-bit integer and transmits the decimal characters.
+void usart_print_uint(uint32_t num)
+{
+	char digits[10];				//Enough for the 10 decimal digits of the largest 32-bit value.
+	uint8_t i = 0;
+
+	do						//Fill the digits array least-significant digit first.
+	{
+		digits[i++] = '0' + (num % 10);
+		num /= 10;
+	} while (num);
+
+	while (i)					//Then transmit them most-significant digit first.
+	{
+		usart_transmit_byte(digits[--i]);
+	}
+}
+
+//Takes a signed 32-bit integer and transmits the decimal characters (with a leading '-' if negative).
+void usart_print_int(int32_t num)
+{
+	if (num < 0)
+	{
+		usart_transmit_byte('-');
+		usart_print_uint(-(uint32_t) num);
+	}
+	else
+	{
+		usart_print_uint(num);
+	}
+}
@@ -1,16 +1,57 @@
 //Definitions and declarations used for serial communications via USART
+//Transmitted bytes are added to a ring buffer and sent by the data register empty interrupt, so printing doesn't wait for each character.
+//Received bytes are added to a ring buffer by the receive complete interrupt, so they can be read whenever the main loop is ready.
+//If interrupts are disabled (e.g. called from within an ISR), the functions that wait move bytes to/from the hardware by polling instead.
+//Transmission can be held (see usart_tx_hold()), e.g. while a device that is woken by activity on its RXD is powered down.
+
+#ifndef USART_H
+#define USART_H
 
 #ifndef BAUD		//If BAUD isn't already defined,
 #define BAUD  9600	//Set the BAUD rate (bits/second).
 #endif
 
 #include <avr/io.h>		//Needed to identify AVR registers and bits.
+#include <avr/interrupt.h>	//Required for the data register empty interrupt.
+#include <util/atomic.h>	//Required to use ATOMIC_BLOCK() so the transmit buffer can be shared with ISRs.
+#include <avr/pgmspace.h>	//Required to read strings stored in flash.
 #include <util/setbaud.h>	//Used to caluculate Usart Baud Rate Register (High and Low) values as a function of F_CPU and BAUD
 
+#define USART_TX_BUFFER_LENGTH	128	//Bytes in the transmit ring buffer.  Must be a power of two (indexes wrap with a mask).
+//Sized for the most queued within a second.  A console reply (up to 96 bytes, CONSOLE_REPLY_LENGTH) is only started with that much room and
+//at least 100ms (TICK_GUARD) before the tick, by which time about 96 bytes have been sent at 9600 baud.  The tick then queues the ZDA sentence
+//(up to 40 bytes, NMEA_SENTENCE_LENGTH) and the status telemetry frame (26 bytes), so at most 31 + 40 + 26 = 97 bytes are waiting.
+//64 bytes (as first chosen) would not hold a whole reply.
+#define USART_RX_BUFFER_LENGTH	64	//Bytes in the receive ring buffer.  Must be a power of two.
+
+//Receive error counters.  Each wraps at 255.
+//Only frame errors come from the line.  Overruns and a full buffer are bytes the firmware lost, so they are counted apart.
+typedef struct
+{
+	uint8_t frame;		//Frame errors (stop bit not found, e.g. wrong baud rate or line noise).
+	uint8_t overrun;	//Bytes lost in the hardware (DOR0): the receive interrupt was held off for over 2 byte times (interrupts disabled).
+	uint8_t full;		//Bytes lost because the receive buffer was full: the main loop didn't read them in time.
+} usart_errors;
+
 //Function declarations
 void usart_init(void);				//Initialise the USART peripheral.
+void usart_set_baud(uint32_t baud);		//Change the baud rate at runtime (BAUD is the default set by usart_init()).
 uint8_t usart_receive_byte(void);		//Returns a byte as received by the USART.
-void usart_transmit_byte(uint8_t data);		//Transmits a byte from the USART.
+uint8_t usart_byte_waiting(void);		//Returns non-zero if a received byte is waiting to be read (does not block).
+void usart_rx_flush(void);			//Discard all received bytes that haven't been read.
+void usart_get_errors(usart_errors *errors);	//Copy the receive error counters.
+void usart_transmit_byte(uint8_t data);		//Adds a byte to the transmit buffer (only waits if the buffer is full).
+uint8_t usart_queue(const uint8_t *data, uint8_t length);	//Adds all "length" bytes to the transmit buffer without waiting.  Returns 0 if there isn't room.
+uint8_t usart_tx_space(void);			//Returns the number of bytes that can be added to the transmit buffer without waiting.
+void usart_tx_hold(uint8_t hold);		//While held, bytes added to the transmit buffer are discarded (bytes already queued are still sent).
+uint8_t usart_tx_held(void);			//Returns non-zero if transmission is held.
+void usart_poll(void);				//Transmit and receive by polling if interrupts are disabled.
 void usart_print_string(const char string[]);	//Transmits a string of characters.
+void usart_print_string_P(const char *string);	//Transmits a string of characters stored in flash (PROGMEM).
 void usart_print_byte(uint8_t byte);		//Takes an integer and transmits the characters.
 void usart_print_binary_byte(uint8_t byte);	//Takes an integer and prints the binary equivalent.
+void usart_print_hex(uint8_t byte);		//Takes an integer and transmits two hexadecimal characters.
+void usart_print_uint(uint32_t num);		//Takes an unsigned 32-bit integer and transmits the decimal characters.
+void usart_print_int(int32_t num);		//Takes a signed 32-bit integer and transmits the decimal characters.
+
+#endif
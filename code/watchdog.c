@@ -0,0 +1,36 @@
+//Functions for the watchdog supervisor.
+
+#include <watchdog.h>
+
+//Kept in .noinit so the value saved by watchdog_boot() isn't cleared by the C runtime (which runs after it).
+uint8_t watchdog_reset_cause __attribute__((section(".noinit")));
+
+static uint8_t watchdog_pending = 0;	//Tasks that have checked in since the watchdog was last reset.
+
+//Save and clear the reset cause, then disable the watchdog.  Placed in .init3 so it runs straight after reset, before the C runtime clears
+//.bss and copies .data (which takes longer than the shortest watchdog timeout).  WDRF must be cleared before the watchdog can be disabled.
+void watchdog_boot(void) __attribute__((naked, used, section(".init3")));
+void watchdog_boot(void)
+{
+	watchdog_reset_cause = MCUSR;
+	MCUSR = 0;
+	wdt_disable();
+}
+
+//Start the watchdog.  Every task must check in within WATCHDOG_TIMEOUT from here on.
+void watchdog_init(void)
+{
+	watchdog_pending = 0;
+	wdt_enable(WATCHDOG_TIMEOUT);
+}
+
+//Record that "task" has run.  Only called from the main loop (never from an ISR), so no atomic access is needed.
+void watchdog_checkin(uint8_t task)
+{
+	watchdog_pending |= task;
+	if ((watchdog_pending & WATCHDOG_TASKS) == WATCHDOG_TASKS)
+	{
+		wdt_reset();
+		watchdog_pending = 0;
+	}
+}
@@ -0,0 +1,41 @@
+//Definitions and declarations for the watchdog supervisor.
+
+//The hardware watchdog resets the AVR if it isn't reset within WATCHDOG_TIMEOUT.  It is only reset once every task in WATCHDOG_TASKS has
+//checked in since it was last reset, so the main loop spinning without ever reaching the display (or the reverse) still causes a reset.
+//Waits that are bounded by their own limit (the GPS timeout and byte limit, pseudo-text shown for a fixed time) reset the watchdog directly
+//with watchdog_wait(), as they may take longer than WATCHDOG_TIMEOUT without a pass of the main loop.
+//The reset cause (MCUSR) is saved straight after reset, before the C runtime starts, and the watchdog is disabled until watchdog_init()
+//(after a watchdog reset it stays enabled and would reset the AVR again during start-up).
+
+#ifndef WATCHDOG_H
+#define WATCHDOG_H
+
+#include <avr/io.h>
+#include <avr/wdt.h>	//Required for wdt_enable(), wdt_reset() and wdt_disable().
+
+#define WATCHDOG_TIMEOUT	WDTO_4S		//Longest time (nominal, the watchdog oscillator is only accurate to about 10%) without a reset.
+
+//Tasks that must check in.  Each is a bit in WATCHDOG_TASKS.
+#define WATCHDOG_LOOP		(1 << 0)	//A pass of the poll() loop.
+#define WATCHDOG_DISPLAY	(1 << 1)	//The RTC read or a frame shown (i.e. the display isn't stuck waiting for a tick or the SPI bus).
+#define WATCHDOG_TASKS		(WATCHDOG_LOOP | WATCHDOG_DISPLAY)
+
+//Bits of watchdog_reset_cause (copied from MCUSR).
+#define WATCHDOG_POWER_ON	(1 << PORF)	//Power-on reset.
+#define WATCHDOG_EXTERNAL	(1 << EXTRF)	//Reset pin.
+#define WATCHDOG_BROWN_OUT	(1 << BORF)	//Brown-out reset.
+#define WATCHDOG_RESET		(1 << WDRF)	//Watchdog reset.
+
+extern uint8_t watchdog_reset_cause;	//MCUSR at reset.
+
+//Function declarations
+void watchdog_init(void);			//Start the watchdog with WATCHDOG_TIMEOUT.
+void watchdog_checkin(uint8_t task);		//Record that "task" has run.  Resets the watchdog once every task in WATCHDOG_TASKS has.
+
+//Reset the watchdog from within a wait that is bounded by its own limit.
+static inline void watchdog_wait(void)
+{
+	wdt_reset();
+}
+
+#endif
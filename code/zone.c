@@ -0,0 +1,92 @@
+//Functions for the time zone rules.
+
+#define ZONE_TABLE	//Define the tables in zone_table.h here (only).
+#include <zone.h>
+
+//Returns the offset (tenths of an hour) of "zone" at "utc" (seconds since epoch).  Zones beyond ZONE_COUNT are treated as UTC.
+//If "next" is not NULL it is set to the instant the offset next changes, or ZONE_NEVER.
+int8_t zone_offset(uint8_t zone, uint32_t utc, uint32_t *next)
+{
+	zone_info info;
+	uint16_t low, high, middle;
+
+	if (next)
+	{
+		*next = ZONE_NEVER;
+	}
+	if (zone >= ZONE_COUNT)
+	{
+		zone = ZONE_UTC;
+	}
+	if (zone < ZONE_FIXED)
+	{
+		return(ZONE_FIXED_MIN + (zone * ZONE_FIXED_STEP));
+	}
+
+	memcpy_P(&info, &zone_infos[zone - ZONE_FIXED], sizeof(info));
+
+	//Find the first transition after "utc".  The one before it (if any) is in effect.
+	low = info.first;
+	high = info.first + info.count;
+	while (low < high)
+	{
+		middle = (low + high) / 2;
+		if (pgm_read_dword(&zone_transitions[middle].utc) <= utc)
+		{
+			low = middle + 1;
+		}
+		else
+		{
+			high = middle;
+		}
+	}
+
+	if (next && (low < (info.first + info.count)))
+	{
+		*next = pgm_read_dword(&zone_transitions[low].utc);
+	}
+	return((low == info.first) ? info.initial : (int8_t) pgm_read_byte(&zone_transitions[low - 1].offset));
+}
+
+//Re-express the local time "time" (at the RTC's offset) at the offset "zone" has at that instant, and set "next" to the zone's next
+//transition.  Returns non-zero if the offset has changed, in which case "offset" and "time" have been updated and the RTC must be re-written.
+//Used by zone_apply() when daylight saving starts or ends, at boot and when another zone is selected.
+uint8_t zone_correct(uint8_t zone, rtc_time *time, uint32_t *next)
+{
+	uint32_t utc = local_to_utc(time);	//As seconds since epoch.
+	int8_t new_offset = zone_offset(zone, utc, next);
+
+	if (new_offset == offset)
+	{
+		return(0);
+	}
+	offset = new_offset;
+	utc_to_local(utc, time);
+	return(1);
+}
+
+//Transmit the name of a zone: "UTC+hh:mm" for a fixed offset, otherwise its IANA name.  Zones beyond ZONE_COUNT are treated as UTC.
+void zone_print_name(uint8_t zone)
+{
+	int8_t offset;
+
+	if (zone >= ZONE_COUNT)
+	{
+		zone = ZONE_UTC;
+	}
+	if (zone >= ZONE_FIXED)
+	{
+		usart_print_string_P(pgm_read_ptr(&zone_infos[zone - ZONE_FIXED].name));
+		return;
+	}
+
+	offset = zone_offset(zone, 0, NULL);
+	usart_print_string((offset < 0) ? "UTC-" : "UTC+");
+	if (offset < 0)
+	{
+		offset = -offset;
+	}
+	usart_transmit_byte('0' + (offset / 100));
+	usart_transmit_byte('0' + ((offset / 10) % 10));
+	usart_print_string((offset % 10) ? ":30" : ":00");
+}
@@ -0,0 +1,46 @@
+//Definitions and declarations for the time zone rules.
+
+//A zone is either a fixed offset from UTC or a zone with daylight saving whose rules have been compiled (by zone_compile.py) into a flash table
+//of the instants its offset changes.  Finding the offset in effect at a time is a binary search of the zone's transitions, and the instant of
+//the next transition is returned with it, so the caller only needs to search again once that instant has passed (at most twice a year).
+//Offsets are in tenths of an hour (multiples of 5), as used for the RTC's offset from UTC.
+
+#ifndef ZONE_H
+#define ZONE_H
+
+#include <avr/io.h>
+#include <avr/pgmspace.h>	//The tables are stored in flash.
+#include <string.h>		//Required for memcpy_P().
+#include <usart.h>		//For printing zone names.
+#include <calendar.h>		//For the local time conversions (at "offset").
+
+#define ZONE_NEVER	0xFFFFFFFFUL	//Next transition of a zone with no more transitions (or a fixed offset).
+#define ZONE_FIXED_MIN	-120		//Offset of zone 0.  Fixed offset zones are in steps of ZONE_FIXED_STEP from here.
+#define ZONE_FIXED_STEP	5
+#define ZONE_UTC	((0 - ZONE_FIXED_MIN) / ZONE_FIXED_STEP)		//Fixed offset zone for UTC (the default).
+#define ZONE_FROM_OFFSET(offset)	(((offset) - ZONE_FIXED_MIN) / ZONE_FIXED_STEP)	//Fixed offset zone for an offset.
+
+//An offset and the instant it takes effect.
+typedef struct
+{
+	uint32_t utc;		//Seconds since epoch (UTC).
+	int8_t offset;		//Tenths of an hour.
+} zone_transition;
+
+//A zone with daylight saving.  Its transitions are zone_transitions[first] to zone_transitions[first + count - 1].
+typedef struct
+{
+	const char *name;	//IANA name (flash).
+	int8_t initial;		//Offset before the first transition.
+	uint16_t first;
+	uint8_t count;
+} zone_info;
+
+#include <zone_table.h>		//ZONE_COUNT and ZONE_FIXED (generated).
+
+//Function declarations
+int8_t zone_offset(uint8_t zone, uint32_t utc, uint32_t *next);	//Offset of a zone at "utc".  Sets "next" (if not NULL) to the next transition.
+void zone_print_name(uint8_t zone);					//Transmit the name of a zone (e.g. "UTC+05:30" or "Europe/London").
+uint8_t zone_correct(uint8_t zone, rtc_time *time, uint32_t *next);	//Move a local time to the zone's current offset.  Non-zero if it changed.
+
+#endif
@@ -0,0 +1,133 @@
+#!/usr/bin/env python3
+# Compile the time zone rules below into zone_table.h: a flash table of the UTC instants at which each zone's offset changes.
+# The rules are POSIX TZ strings (as found at the end of each IANA tzdata file) so the output doesn't depend on the host's tzdata.
+# Run with "make zones" after changing the zone list or the range of years, and commit the regenerated zone_table.h.
+#
+# Offsets must be whole half hours from -12:00 to +12:00 (the clock keeps offsets in tenths of an hour, multiples of 5 from -120 to 120).
+# Zones with other offsets (e.g. Nepal +5:45, or New Zealand daylight time +13:00) can't be represented and are rejected.
+
+import calendar
+import re
+import sys
+import time
+
+FIRST_YEAR = 2025	# Transitions are compiled from the start of this year...
+LAST_YEAR = 2040	# ...to the end of this one.  After that a zone keeps the offset of its last transition.
+
+# Zones with daylight saving, selected after the fixed offsets.  Names are kept short enough for the console.
+ZONES = [
+	("Europe/London",		"GMT0BST,M3.5.0/1,M10.5.0"),
+	("Europe/Berlin",		"CET-1CEST,M3.5.0,M10.5.0/3"),
+	("Europe/Athens",		"EET-2EEST,M3.5.0/3,M10.5.0/4"),
+	("America/St_Johns",		"NST3:30NDT,M3.2.0,M11.1.0"),
+	("America/Halifax",		"AST4ADT,M3.2.0,M11.1.0"),
+	("America/New_York",		"EST5EDT,M3.2.0,M11.1.0"),
+	("America/Chicago",		"CST6CDT,M3.2.0,M11.1.0"),
+	("America/Denver",		"MST7MDT,M3.2.0,M11.1.0"),
+	("America/Los_Angeles",		"PST8PDT,M3.2.0,M11.1.0"),
+	("America/Anchorage",		"AKST9AKDT,M3.2.0,M11.1.0"),
+	("Australia/Adelaide",		"ACST-9:30ACDT,M10.1.0,M4.1.0/3"),
+	("Australia/Sydney",		"AEST-10AEDT,M10.1.0,M4.1.0/3"),
+]
+
+FIXED_MIN = -120	# Fixed offsets (tenths of an hour) from UTC-12:00...
+FIXED_MAX = 120		# ...to UTC+12:00 in half hours are zones 0 to 48.
+FIXED_STEP = 5
+
+NAME = r"(?:[A-Za-z]{3,}|<[+\-0-9A-Za-z]+>)"
+OFFSET = r"[+\-]?\d{1,2}(?::\d{2}){0,2}"
+RULE = r"M\d{1,2}\.\d\.\d(?:/" + OFFSET + r")?"
+POSIX = re.compile(r"^(" + NAME + r")(" + OFFSET + r")(?:(" + NAME + r")(" + OFFSET + r")?,(" + RULE + r"),(" + RULE + r"))?$")
+
+def seconds(text):
+	"""Seconds represented by [+|-]hh[:mm[:ss]]."""
+	sign = -1 if text.startswith("-") else 1
+	parts = [int(p) for p in text.lstrip("+-").split(":")] + [0, 0]
+	return sign * ((parts[0] * 3600) + (parts[1] * 60) + parts[2])
+
+def tenths(offset, zone):
+	"""Offset (seconds east of UTC) in tenths of an hour.  Only whole half hours from FIXED_MIN to FIXED_MAX are allowed."""
+	if (offset % 1800) or not (FIXED_MIN <= (offset // 360) <= FIXED_MAX):
+		sys.exit("%s: offset %+d seconds is not a whole half hour from %+d to %+d hours" % (zone, offset, FIXED_MIN // 10, FIXED_MAX // 10))
+	return offset // 360
+
+def rule_local(rule, year):
+	"""Local time (seconds since epoch, as if local time were UTC) at which a Mm.w.d[/time] rule takes effect in "year"."""
+	date, _, at = rule.partition("/")
+	month, week, weekday = (int(p) for p in date[1:].split("."))
+	first = calendar.weekday(year, month, 1)			# Monday is 0.
+	day = 1 + ((((weekday - 1) % 7) - first) % 7)			# First "weekday" (0 is Sunday) of the month.
+	day += 7 * (week - 1)
+	while day > calendar.monthrange(year, month)[1]:		# Week 5 means the last such day of the month.
+		day -= 7
+	return calendar.timegm((year, month, day, 0, 0, 0)) + (seconds(at) if at else 7200)
+
+def compile_zone(zone, posix):
+	"""Returns the offset before FIRST_YEAR and the list of (utc, offset) transitions for a POSIX TZ string."""
+	match = POSIX.match(posix)
+	if not match:
+		sys.exit("%s: can't parse \"%s\"" % (zone, posix))
+	standard = -seconds(match.group(2))				# POSIX offsets are west of UTC.
+	if not match.group(3):
+		return tenths(standard, zone), []
+	daylight = -seconds(match.group(4)) if match.group(4) else standard + 3600
+	transitions = []
+	for year in range(FIRST_YEAR, LAST_YEAR + 1):
+		transitions.append((rule_local(match.group(5), year) - standard, daylight))	# Start rule is in standard time.
+		transitions.append((rule_local(match.group(6), year) - daylight, standard))	# End rule is in daylight time.
+	transitions.sort()
+	initial = transitions[-1][1]					# Offset in effect at the end of the previous year.
+	return tenths(initial, zone), [(utc, tenths(offset, zone)) for utc, offset in transitions]
+
+def main(path):
+	lines = []
+	table = []
+	infos = []
+	for zone, posix in ZONES:
+		initial, transitions = compile_zone(zone, posix)
+		infos.append((zone, posix, initial, len(table), len(transitions)))
+		table.extend(transitions)
+	if len(table) > 0xFFFF or max(info[4] for info in infos) > 0xFF:
+		sys.exit("too many transitions")
+
+	fixed = ((FIXED_MAX - FIXED_MIN) // FIXED_STEP) + 1
+	lines.append("//Time zone transition table.  Generated by zone_compile.py (\"make zones\") - do not edit.")
+	lines.append("//Transitions are compiled from %d to %d.  The tables are only defined where ZONE_TABLE is defined (zone.c)." % (FIRST_YEAR, LAST_YEAR))
+	lines.append("")
+	lines.append("#ifndef ZONE_TABLE_H")
+	lines.append("#define ZONE_TABLE_H")
+	lines.append("")
+	lines.append("#define ZONE_FIRST_YEAR\t%d" % FIRST_YEAR)
+	lines.append("#define ZONE_LAST_YEAR\t%d" % LAST_YEAR)
+	lines.append("#define ZONE_FIXED\t%d\t//Zones 0 to ZONE_FIXED - 1 are fixed offsets from UTC%+.1f to UTC%+.1f in half hours." % (fixed, FIXED_MIN / 10, FIXED_MAX / 10))
+	lines.append("#define ZONE_COUNT\t%d\t//Followed by the zones with daylight saving below." % (fixed + len(infos)))
+	lines.append("")
+	lines.append("#ifdef ZONE_TABLE")
+	for index, (zone, posix, initial, first, count) in enumerate(infos):
+		lines.append("static const char zone_name_%d[] PROGMEM = \"%s\";" % (index, zone))
+	lines.append("")
+	lines.append("//Instant (UTC, seconds since epoch) each offset (tenths of an hour) takes effect, in order for each zone.")
+	lines.append("static const zone_transition zone_transitions[] PROGMEM =")
+	lines.append("{")
+	for index, (zone, posix, initial, first, count) in enumerate(infos):
+		lines.append("\t//%s\t%s" % (zone, posix))
+		for utc, offset in table[first:first + count]:
+			lines.append("\t{%dUL, %d},\t//%s" % (utc, offset, time.strftime("%Y-%m-%d %H:%M UTC", time.gmtime(utc))))
+	lines.append("};")
+	lines.append("")
+	lines.append("//Zones with daylight saving (zone ZONE_FIXED onwards).")
+	lines.append("static const zone_info zone_infos[] PROGMEM =")
+	lines.append("{")
+	lines.append("\t//Name\t\tInitial\tFirst\tCount")
+	for index, (zone, posix, initial, first, count) in enumerate(infos):
+		lines.append("\t{zone_name_%d,\t%d,\t%d,\t%d},\t//Zone %d: %s" % (index, initial, first, count, fixed + index, zone))
+	lines.append("};")
+	lines.append("#endif")
+	lines.append("")
+	lines.append("#endif")
+
+	with open(path, "w", newline="\n") as output:
+		output.write("\n".join(lines) + "\n")
+
+if __name__ == "__main__":
+	main(sys.argv[1] if len(sys.argv) > 1 else "zone_table.h")
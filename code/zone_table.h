@@ -0,0 +1,446 @@
+//Time zone transition table.  Generated by zone_compile.py ("make zones") - do not edit.
+//Transitions are compiled from 2025 to 2040.  The tables are only defined where ZONE_TABLE is defined (zone.c).
+
+#ifndef ZONE_TABLE_H
+#define ZONE_TABLE_H
+
+#define ZONE_FIRST_YEAR	2025
+#define ZONE_LAST_YEAR	2040
+#define ZONE_FIXED	49	//Zones 0 to ZONE_FIXED - 1 are fixed offsets from UTC-12.0 to UTC+12.0 in half hours.
+#define ZONE_COUNT	61	//Followed by the zones with daylight saving below.
+
+#ifdef ZONE_TABLE
+static const char zone_name_0[] PROGMEM = "Europe/London";
+static const char zone_name_1[] PROGMEM = "Europe/Berlin";
+static const char zone_name_2[] PROGMEM = "Europe/Athens";
+static const char zone_name_3[] PROGMEM = "America/St_Johns";
+static const char zone_name_4[] PROGMEM = "America/Halifax";
+static const char zone_name_5[] PROGMEM = "America/New_York";
+static const char zone_name_6[] PROGMEM = "America/Chicago";
+static const char zone_name_7[] PROGMEM = "America/Denver";
+static const char zone_name_8[] PROGMEM = "America/Los_Angeles";
+static const char zone_name_9[] PROGMEM = "America/Anchorage";
+static const char zone_name_10[] PROGMEM = "Australia/Adelaide";
+static const char zone_name_11[] PROGMEM = "Australia/Sydney";
+
+//Instant (UTC, seconds since epoch) each offset (tenths of an hour) takes effect, in order for each zone.
+static const zone_transition zone_transitions[] PROGMEM =
+{
+	//Europe/London	GMT0BST,M3.5.0/1,M10.5.0
+	{1743296400UL, 10},	//2025-03-30 01:00 UTC
+	{1761440400UL, 0},	//2025-10-26 01:00 UTC
+	{1774746000UL, 10},	//2026-03-29 01:00 UTC
+	{1792890000UL, 0},	//2026-10-25 01:00 UTC
+	{1806195600UL, 10},	//2027-03-28 01:00 UTC
+	{1824944400UL, 0},	//2027-10-31 01:00 UTC
+	{1837645200UL, 10},	//2028-03-26 01:00 UTC
+	{1856394000UL, 0},	//2028-10-29 01:00 UTC
+	{1869094800UL, 10},	//2029-03-25 01:00 UTC
+	{1887843600UL, 0},	//2029-10-28 01:00 UTC
+	{1901149200UL, 10},	//2030-03-31 01:00 UTC
+	{1919293200UL, 0},	//2030-10-27 01:00 UTC
+	{1932598800UL, 10},	//2031-03-30 01:00 UTC
+	{1950742800UL, 0},	//2031-10-26 01:00 UTC
+	{1964048400UL, 10},	//2032-03-28 01:00 UTC
+	{1982797200UL, 0},	//2032-10-31 01:00 UTC
+	{1995498000UL, 10},	//2033-03-27 01:00 UTC
+	{2014246800UL, 0},	//2033-10-30 01:00 UTC
+	{2026947600UL, 10},	//2034-03-26 01:00 UTC
+	{2045696400UL, 0},	//2034-10-29 01:00 UTC
+	{2058397200UL, 10},	//2035-03-25 01:00 UTC
+	{2077146000UL, 0},	//2035-10-28 01:00 UTC
+	{2090451600UL, 10},	//2036-03-30 01:00 UTC
+	{2108595600UL, 0},	//2036-10-26 01:00 UTC
+	{2121901200UL, 10},	//2037-03-29 01:00 UTC
+	{2140045200UL, 0},	//2037-10-25 01:00 UTC
+	{2153350800UL, 10},	//2038-03-28 01:00 UTC
+	{2172099600UL, 0},	//2038-10-31 01:00 UTC
+	{2184800400UL, 10},	//2039-03-27 01:00 UTC
+	{2203549200UL, 0},	//2039-10-30 01:00 UTC
+	{2216250000UL, 10},	//2040-03-25 01:00 UTC
+	{2234998800UL, 0},	//2040-10-28 01:00 UTC
+	//Europe/Berlin	CET-1CEST,M3.5.0,M10.5.0/3
+	{1743296400UL, 20},	//2025-03-30 01:00 UTC
+	{1761440400UL, 10},	//2025-10-26 01:00 UTC
+	{1774746000UL, 20},	//2026-03-29 01:00 UTC
+	{1792890000UL, 10},	//2026-10-25 01:00 UTC
+	{1806195600UL, 20},	//2027-03-28 01:00 UTC
+	{1824944400UL, 10},	//2027-10-31 01:00 UTC
+	{1837645200UL, 20},	//2028-03-26 01:00 UTC
+	{1856394000UL, 10},	//2028-10-29 01:00 UTC
+	{1869094800UL, 20},	//2029-03-25 01:00 UTC
+	{1887843600UL, 10},	//2029-10-28 01:00 UTC
+	{1901149200UL, 20},	//2030-03-31 01:00 UTC
+	{1919293200UL, 10},	//2030-10-27 01:00 UTC
+	{1932598800UL, 20},	//2031-03-30 01:00 UTC
+	{1950742800UL, 10},	//2031-10-26 01:00 UTC
+	{1964048400UL, 20},	//2032-03-28 01:00 UTC
+	{1982797200UL, 10},	//2032-10-31 01:00 UTC
+	{1995498000UL, 20},	//2033-03-27 01:00 UTC
+	{2014246800UL, 10},	//2033-10-30 01:00 UTC
+	{2026947600UL, 20},	//2034-03-26 01:00 UTC
+	{2045696400UL, 10},	//2034-10-29 01:00 UTC
+	{2058397200UL, 20},	//2035-03-25 01:00 UTC
+	{2077146000UL, 10},	//2035-10-28 01:00 UTC
+	{2090451600UL, 20},	//2036-03-30 01:00 UTC
+	{2108595600UL, 10},	//2036-10-26 01:00 UTC
+	{2121901200UL, 20},	//2037-03-29 01:00 UTC
+	{2140045200UL, 10},	//2037-10-25 01:00 UTC
+	{2153350800UL, 20},	//2038-03-28 01:00 UTC
+	{2172099600UL, 10},	//2038-10-31 01:00 UTC
+	{2184800400UL, 20},	//2039-03-27 01:00 UTC
+	{2203549200UL, 10},	//2039-10-30 01:00 UTC
+	{2216250000UL, 20},	//2040-03-25 01:00 UTC
+	{2234998800UL, 10},	//2040-10-28 01:00 UTC
+	//Europe/Athens	EET-2EEST,M3.5.0/3,M10.5.0/4
+	{1743296400UL, 30},	//2025-03-30 01:00 UTC
+	{1761440400UL, 20},	//2025-10-26 01:00 UTC
+	{1774746000UL, 30},	//2026-03-29 01:00 UTC
+	{1792890000UL, 20},	//2026-10-25 01:00 UTC
+	{1806195600UL, 30},	//2027-03-28 01:00 UTC
+	{1824944400UL, 20},	//2027-10-31 01:00 UTC
+	{1837645200UL, 30},	//2028-03-26 01:00 UTC
+	{1856394000UL, 20},	//2028-10-29 01:00 UTC
+	{1869094800UL, 30},	//2029-03-25 01:00 UTC
+	{1887843600UL, 20},	//2029-10-28 01:00 UTC
+	{1901149200UL, 30},	//2030-03-31 01:00 UTC
+	{1919293200UL, 20},	//2030-10-27 01:00 UTC
+	{1932598800UL, 30},	//2031-03-30 01:00 UTC
+	{1950742800UL, 20},	//2031-10-26 01:00 UTC
+	{1964048400UL, 30},	//2032-03-28 01:00 UTC
+	{1982797200UL, 20},	//2032-10-31 01:00 UTC
+	{1995498000UL, 30},	//2033-03-27 01:00 UTC
+	{2014246800UL, 20},	//2033-10-30 01:00 UTC
+	{2026947600UL, 30},	//2034-03-26 01:00 UTC
+	{2045696400UL, 20},	//2034-10-29 01:00 UTC
+	{2058397200UL, 30},	//2035-03-25 01:00 UTC
+	{2077146000UL, 20},	//2035-10-28 01:00 UTC
+	{2090451600UL, 30},	//2036-03-30 01:00 UTC
+	{2108595600UL, 20},	//2036-10-26 01:00 UTC
+	{2121901200UL, 30},	//2037-03-29 01:00 UTC
+	{2140045200UL, 20},	//2037-10-25 01:00 UTC
+	{2153350800UL, 30},	//2038-03-28 01:00 UTC
+	{2172099600UL, 20},	//2038-10-31 01:00 UTC
+	{2184800400UL, 30},	//2039-03-27 01:00 UTC
+	{2203549200UL, 20},	//2039-10-30 01:00 UTC
+	{2216250000UL, 30},	//2040-03-25 01:00 UTC
+	{2234998800UL, 20},	//2040-10-28 01:00 UTC
+	//America/St_Johns	NST3:30NDT,M3.2.0,M11.1.0
+	{1741498200UL, -25},	//2025-03-09 05:30 UTC
+	{1762057800UL, -35},	//2025-11-02 04:30 UTC
+	{1772947800UL, -25},	//2026-03-08 05:30 UTC
+	{1793507400UL, -35},	//2026-11-01 04:30 UTC
+	{1805002200UL, -25},	//2027-03-14 05:30 UTC
+	{1825561800UL, -35},	//2027-11-07 04:30 UTC
+	{1836451800UL, -25},	//2028-03-12 05:30 UTC
+	{1857011400UL, -35},	//2028-11-05 04:30 UTC
+	{1867901400UL, -25},	//2029-03-11 05:30 UTC
+	{1888461000UL, -35},	//2029-11-04 04:30 UTC
+	{1899351000UL, -25},	//2030-03-10 05:30 UTC
+	{1919910600UL, -35},	//2030-11-03 04:30 UTC
+	{1930800600UL, -25},	//2031-03-09 05:30 UTC
+	{1951360200UL, -35},	//2031-11-02 04:30 UTC
+	{1962855000UL, -25},	//2032-03-14 05:30 UTC
+	{1983414600UL, -35},	//2032-11-07 04:30 UTC
+	{1994304600UL, -25},	//2033-03-13 05:30 UTC
+	{2014864200UL, -35},	//2033-11-06 04:30 UTC
+	{2025754200UL, -25},	//2034-03-12 05:30 UTC
+	{2046313800UL, -35},	//2034-11-05 04:30 UTC
+	{2057203800UL, -25},	//2035-03-11 05:30 UTC
+	{2077763400UL, -35},	//2035-11-04 04:30 UTC
+	{2088653400UL, -25},	//2036-03-09 05:30 UTC
+	{2109213000UL, -35},	//2036-11-02 04:30 UTC
+	{2120103000UL, -25},	//2037-03-08 05:30 UTC
+	{2140662600UL, -35},	//2037-11-01 04:30 UTC
+	{2152157400UL, -25},	//2038-03-14 05:30 UTC
+	{2172717000UL, -35},	//2038-11-07 04:30 UTC
+	{2183607000UL, -25},	//2039-03-13 05:30 UTC
+	{2204166600UL, -35},	//2039-11-06 04:30 UTC
+	{2215056600UL, -25},	//2040-03-11 05:30 UTC
+	{2235616200UL, -35},	//2040-11-04 04:30 UTC
+	//America/Halifax	AST4ADT,M3.2.0,M11.1.0
+	{1741500000UL, -30},	//2025-03-09 06:00 UTC
+	{1762059600UL, -40},	//2025-11-02 05:00 UTC
+	{1772949600UL, -30},	//2026-03-08 06:00 UTC
+	{1793509200UL, -40},	//2026-11-01 05:00 UTC
+	{1805004000UL, -30},	//2027-03-14 06:00 UTC
+	{1825563600UL, -40},	//2027-11-07 05:00 UTC
+	{1836453600UL, -30},	//2028-03-12 06:00 UTC
+	{1857013200UL, -40},	//2028-11-05 05:00 UTC
+	{1867903200UL, -30},	//2029-03-11 06:00 UTC
+	{1888462800UL, -40},	//2029-11-04 05:00 UTC
+	{1899352800UL, -30},	//2030-03-10 06:00 UTC
+	{1919912400UL, -40},	//2030-11-03 05:00 UTC
+	{1930802400UL, -30},	//2031-03-09 06:00 UTC
+	{1951362000UL, -40},	//2031-11-02 05:00 UTC
+	{1962856800UL, -30},	//2032-03-14 06:00 UTC
+	{1983416400UL, -40},	//2032-11-07 05:00 UTC
+	{1994306400UL, -30},	//2033-03-13 06:00 UTC
+	{2014866000UL, -40},	//2033-11-06 05:00 UTC
+	{2025756000UL, -30},	//2034-03-12 06:00 UTC
+	{2046315600UL, -40},	//2034-11-05 05:00 UTC
+	{2057205600UL, -30},	//2035-03-11 06:00 UTC
+	{2077765200UL, -40},	//2035-11-04 05:00 UTC
+	{2088655200UL, -30},	//2036-03-09 06:00 UTC
+	{2109214800UL, -40},	//2036-11-02 05:00 UTC
+	{2120104800UL, -30},	//2037-03-08 06:00 UTC
+	{2140664400UL, -40},	//2037-11-01 05:00 UTC
+	{2152159200UL, -30},	//2038-03-14 06:00 UTC
+	{2172718800UL, -40},	//2038-11-07 05:00 UTC
+	{2183608800UL, -30},	//2039-03-13 06:00 UTC
+	{2204168400UL, -40},	//2039-11-06 05:00 UTC
+	{2215058400UL, -30},	//2040-03-11 06:00 UTC
+	{2235618000UL, -40},	//2040-11-04 05:00 UTC
+	//America/New_York	EST5EDT,M3.2.0,M11.1.0
+	{1741503600UL, -40},	//2025-03-09 07:00 UTC
+	{1762063200UL, -50},	//2025-11-02 06:00 UTC
+	{1772953200UL, -40},	//2026-03-08 07:00 UTC
+	{1793512800UL, -50},	//2026-11-01 06:00 UTC
+	{1805007600UL, -40},	//2027-03-14 07:00 UTC
+	{1825567200UL, -50},	//2027-11-07 06:00 UTC
+	{1836457200UL, -40},	//2028-03-12 07:00 UTC
+	{1857016800UL, -50},	//2028-11-05 06:00 UTC
+	{1867906800UL, -40},	//2029-03-11 07:00 UTC
+	{1888466400UL, -50},	//2029-11-04 06:00 UTC
+	{1899356400UL, -40},	//2030-03-10 07:00 UTC
+	{1919916000UL, -50},	//2030-11-03 06:00 UTC
+	{1930806000UL, -40},	//2031-03-09 07:00 UTC
+	{1951365600UL, -50},	//2031-11-02 06:00 UTC
+	{1962860400UL, -40},	//2032-03-14 07:00 UTC
+	{1983420000UL, -50},	//2032-11-07 06:00 UTC
+	{1994310000UL, -40},	//2033-03-13 07:00 UTC
+	{2014869600UL, -50},	//2033-11-06 06:00 UTC
+	{2025759600UL, -40},	//2034-03-12 07:00 UTC
+	{2046319200UL, -50},	//2034-11-05 06:00 UTC
+	{2057209200UL, -40},	//2035-03-11 07:00 UTC
+	{2077768800UL, -50},	//2035-11-04 06:00 UTC
+	{2088658800UL, -40},	//2036-03-09 07:00 UTC
+	{2109218400UL, -50},	//2036-11-02 06:00 UTC
+	{2120108400UL, -40},	//2037-03-08 07:00 UTC
+	{2140668000UL, -50},	//2037-11-01 06:00 UTC
+	{2152162800UL, -40},	//2038-03-14 07:00 UTC
+	{2172722400UL, -50},	//2038-11-07 06:00 UTC
+	{2183612400UL, -40},	//2039-03-13 07:00 UTC
+	{2204172000UL, -50},	//2039-11-06 06:00 UTC
+	{2215062000UL, -40},	//2040-03-11 07:00 UTC
+	{2235621600UL, -50},	//2040-11-04 06:00 UTC
+	//America/Chicago	CST6CDT,M3.2.0,M11.1.0
+	{1741507200UL, -50},	//2025-03-09 08:00 UTC
+	{1762066800UL, -60},	//2025-11-02 07:00 UTC
+	{1772956800UL, -50},	//2026-03-08 08:00 UTC
+	{1793516400UL, -60},	//2026-11-01 07:00 UTC
+	{1805011200UL, -50},	//2027-03-14 08:00 UTC
+	{1825570800UL, -60},	//2027-11-07 07:00 UTC
+	{1836460800UL, -50},	//2028-03-12 08:00 UTC
+	{1857020400UL, -60},	//2028-11-05 07:00 UTC
+	{1867910400UL, -50},	//2029-03-11 08:00 UTC
+	{1888470000UL, -60},	//2029-11-04 07:00 UTC
+	{1899360000UL, -50},	//2030-03-10 08:00 UTC
+	{1919919600UL, -60},	//2030-11-03 07:00 UTC
+	{1930809600UL, -50},	//2031-03-09 08:00 UTC
+	{1951369200UL, -60},	//2031-11-02 07:00 UTC
+	{1962864000UL, -50},	//2032-03-14 08:00 UTC
+	{1983423600UL, -60},	//2032-11-07 07:00 UTC
+	{1994313600UL, -50},	//2033-03-13 08:00 UTC
+	{2014873200UL, -60},	//2033-11-06 07:00 UTC
+	{2025763200UL, -50},	//2034-03-12 08:00 UTC
+	{2046322800UL, -60},	//2034-11-05 07:00 UTC
+	{2057212800UL, -50},	//2035-03-11 08:00 UTC
+	{2077772400UL, -60},	//2035-11-04 07:00 UTC
+	{2088662400UL, -50},	//2036-03-09 08:00 UTC
+	{2109222000UL, -60},	//2036-11-02 07:00 UTC
+	{2120112000UL, -50},	//2037-03-08 08:00 UTC
+	{2140671600UL, -60},	//2037-11-01 07:00 UTC
+	{2152166400UL, -50},	//2038-03-14 08:00 UTC
+	{2172726000UL, -60},	//2038-11-07 07:00 UTC
+	{2183616000UL, -50},	//2039-03-13 08:00 UTC
+	{2204175600UL, -60},	//2039-11-06 07:00 UTC
+	{2215065600UL, -50},	//2040-03-11 08:00 UTC
+	{2235625200UL, -60},	//2040-11-04 07:00 UTC
+	//America/Denver	MST7MDT,M3.2.0,M11.1.0
+	{1741510800UL, -60},	//2025-03-09 09:00 UTC
+	{1762070400UL, -70},	//2025-11-02 08:00 UTC
+	{1772960400UL, -60},	//2026-03-08 09:00 UTC
+	{1793520000UL, -70},	//2026-11-01 08:00 UTC
+	{1805014800UL, -60},	//2027-03-14 09:00 UTC
+	{1825574400UL, -70},	//2027-11-07 08:00 UTC
+	{1836464400UL, -60},	//2028-03-12 09:00 UTC
+	{1857024000UL, -70},	//2028-11-05 08:00 UTC
+	{1867914000UL, -60},	//2029-03-11 09:00 UTC
+	{1888473600UL, -70},	//2029-11-04 08:00 UTC
+	{1899363600UL, -60},	//2030-03-10 09:00 UTC
+	{1919923200UL, -70},	//2030-11-03 08:00 UTC
+	{1930813200UL, -60},	//2031-03-09 09:00 UTC
+	{1951372800UL, -70},	//2031-11-02 08:00 UTC
+	{1962867600UL, -60},	//2032-03-14 09:00 UTC
+	{1983427200UL, -70},	//2032-11-07 08:00 UTC
+	{1994317200UL, -60},	//2033-03-13 09:00 UTC
+	{2014876800UL, -70},	//2033-11-06 08:00 UTC
+	{2025766800UL, -60},	//2034-03-12 09:00 UTC
+	{2046326400UL, -70},	//2034-11-05 08:00 UTC
+	{2057216400UL, -60},	//2035-03-11 09:00 UTC
+	{2077776000UL, -70},	//2035-11-04 08:00 UTC
+	{2088666000UL, -60},	//2036-03-09 09:00 UTC
+	{2109225600UL, -70},	//2036-11-02 08:00 UTC
+	{2120115600UL, -60},	//2037-03-08 09:00 UTC
+	{2140675200UL, -70},	//2037-11-01 08:00 UTC
+	{2152170000UL, -60},	//2038-03-14 09:00 UTC
+	{2172729600UL, -70},	//2038-11-07 08:00 UTC
+	{2183619600UL, -60},	//2039-03-13 09:00 UTC
+	{2204179200UL, -70},	//2039-11-06 08:00 UTC
+	{2215069200UL, -60},	//2040-03-11 09:00 UTC
+	{2235628800UL, -70},	//2040-11-04 08:00 UTC
+	//America/Los_Angeles	PST8PDT,M3.2.0,M11.1.0
+	{1741514400UL, -70},	//2025-03-09 10:00 UTC
+	{1762074000UL, -80},	//2025-11-02 09:00 UTC
+	{1772964000UL, -70},	//2026-03-08 10:00 UTC
+	{1793523600UL, -80},	//2026-11-01 09:00 UTC
+	{1805018400UL, -70},	//2027-03-14 10:00 UTC
+	{1825578000UL, -80},	//2027-11-07 09:00 UTC
+	{1836468000UL, -70},	//2028-03-12 10:00 UTC
+	{1857027600UL, -80},	//2028-11-05 09:00 UTC
+	{1867917600UL, -70},	//2029-03-11 10:00 UTC
+	{1888477200UL, -80},	//2029-11-04 09:00 UTC
+	{1899367200UL, -70},	//2030-03-10 10:00 UTC
+	{1919926800UL, -80},	//2030-11-03 09:00 UTC
+	{1930816800UL, -70},	//2031-03-09 10:00 UTC
+	{1951376400UL, -80},	//2031-11-02 09:00 UTC
+	{1962871200UL, -70},	//2032-03-14 10:00 UTC
+	{1983430800UL, -80},	//2032-11-07 09:00 UTC
+	{1994320800UL, -70},	//2033-03-13 10:00 UTC
+	{2014880400UL, -80},	//2033-11-06 09:00 UTC
+	{2025770400UL, -70},	//2034-03-12 10:00 UTC
+	{2046330000UL, -80},	//2034-11-05 09:00 UTC
+	{2057220000UL, -70},	//2035-03-11 10:00 UTC
+	{2077779600UL, -80},	//2035-11-04 09:00 UTC
+	{2088669600UL, -70},	//2036-03-09 10:00 UTC
+	{2109229200UL, -80},	//2036-11-02 09:00 UTC
+	{2120119200UL, -70},	//2037-03-08 10:00 UTC
+	{2140678800UL, -80},	//2037-11-01 09:00 UTC
+	{2152173600UL, -70},	//2038-03-14 10:00 UTC
+	{2172733200UL, -80},	//2038-11-07 09:00 UTC
+	{2183623200UL, -70},	//2039-03-13 10:00 UTC
+	{2204182800UL, -80},	//2039-11-06 09:00 UTC
+	{2215072800UL, -70},	//2040-03-11 10:00 UTC
+	{2235632400UL, -80},	//2040-11-04 09:00 UTC
+	//America/Anchorage	AKST9AKDT,M3.2.0,M11.1.0
+	{1741518000UL, -80},	//2025-03-09 11:00 UTC
+	{1762077600UL, -90},	//2025-11-02 10:00 UTC
+	{1772967600UL, -80},	//2026-03-08 11:00 UTC
+	{1793527200UL, -90},	//2026-11-01 10:00 UTC
+	{1805022000UL, -80},	//2027-03-14 11:00 UTC
+	{1825581600UL, -90},	//2027-11-07 10:00 UTC
+	{1836471600UL, -80},	//2028-03-12 11:00 UTC
+	{1857031200UL, -90},	//2028-11-05 10:00 UTC
+	{1867921200UL, -80},	//2029-03-11 11:00 UTC
+	{1888480800UL, -90},	//2029-11-04 10:00 UTC
+	{1899370800UL, -80},	//2030-03-10 11:00 UTC
+	{1919930400UL, -90},	//2030-11-03 10:00 UTC
+	{1930820400UL, -80},	//2031-03-09 11:00 UTC
+	{1951380000UL, -90},	//2031-11-02 10:00 UTC
+	{1962874800UL, -80},	//2032-03-14 11:00 UTC
+	{1983434400UL, -90},	//2032-11-07 10:00 UTC
+	{1994324400UL, -80},	//2033-03-13 11:00 UTC
+	{2014884000UL, -90},	//2033-11-06 10:00 UTC
+	{2025774000UL, -80},	//2034-03-12 11:00 UTC
+	{2046333600UL, -90},	//2034-11-05 10:00 UTC
+	{2057223600UL, -80},	//2035-03-11 11:00 UTC
+	{2077783200UL, -90},	//2035-11-04 10:00 UTC
+	{2088673200UL, -80},	//2036-03-09 11:00 UTC
+	{2109232800UL, -90},	//2036-11-02 10:00 UTC
+	{2120122800UL, -80},	//2037-03-08 11:00 UTC
+	{2140682400UL, -90},	//2037-11-01 10:00 UTC
+	{2152177200UL, -80},	//2038-03-14 11:00 UTC
+	{2172736800UL, -90},	//2038-11-07 10:00 UTC
+	{2183626800UL, -80},	//2039-03-13 11:00 UTC
+	{2204186400UL, -90},	//2039-11-06 10:00 UTC
+	{2215076400UL, -80},	//2040-03-11 11:00 UTC
+	{2235636000UL, -90},	//2040-11-04 10:00 UTC
+	//Australia/Adelaide	ACST-9:30ACDT,M10.1.0,M4.1.0/3
+	{1743870600UL, 95},	//2025-04-05 16:30 UTC
+	{1759595400UL, 105},	//2025-10-04 16:30 UTC
+	{1775320200UL, 95},	//2026-04-04 16:30 UTC
+	{1791045000UL, 105},	//2026-10-03 16:30 UTC
+	{1806769800UL, 95},	//2027-04-03 16:30 UTC
+	{1822494600UL, 105},	//2027-10-02 16:30 UTC
+	{1838219400UL, 95},	//2028-04-01 16:30 UTC
+	{1853944200UL, 105},	//2028-09-30 16:30 UTC
+	{1869669000UL, 95},	//2029-03-31 16:30 UTC
+	{1885998600UL, 105},	//2029-10-06 16:30 UTC
+	{1901723400UL, 95},	//2030-04-06 16:30 UTC
+	{1917448200UL, 105},	//2030-10-05 16:30 UTC
+	{1933173000UL, 95},	//2031-04-05 16:30 UTC
+	{1948897800UL, 105},	//2031-10-04 16:30 UTC
+	{1964622600UL, 95},	//2032-04-03 16:30 UTC
+	{1980347400UL, 105},	//2032-10-02 16:30 UTC
+	{1996072200UL, 95},	//2033-04-02 16:30 UTC
+	{2011797000UL, 105},	//2033-10-01 16:30 UTC
+	{2027521800UL, 95},	//2034-04-01 16:30 UTC
+	{2043246600UL, 105},	//2034-09-30 16:30 UTC
+	{2058971400UL, 95},	//2035-03-31 16:30 UTC
+	{2075301000UL, 105},	//2035-10-06 16:30 UTC
+	{2091025800UL, 95},	//2036-04-05 16:30 UTC
+	{2106750600UL, 105},	//2036-10-04 16:30 UTC
+	{2122475400UL, 95},	//2037-04-04 16:30 UTC
+	{2138200200UL, 105},	//2037-10-03 16:30 UTC
+	{2153925000UL, 95},	//2038-04-03 16:30 UTC
+	{2169649800UL, 105},	//2038-10-02 16:30 UTC
+	{2185374600UL, 95},	//2039-04-02 16:30 UTC
+	{2201099400UL, 105},	//2039-10-01 16:30 UTC
+	{2216824200UL, 95},	//2040-03-31 16:30 UTC
+	{2233153800UL, 105},	//2040-10-06 16:30 UTC
+	//Australia/Sydney	AEST-10AEDT,M10.1.0,M4.1.0/3
+	{1743868800UL, 100},	//2025-04-05 16:00 UTC
+	{1759593600UL, 110},	//2025-10-04 16:00 UTC
+	{1775318400UL, 100},	//2026-04-04 16:00 UTC
+	{1791043200UL, 110},	//2026-10-03 16:00 UTC
+	{1806768000UL, 100},	//2027-04-03 16:00 UTC
+	{1822492800UL, 110},	//2027-10-02 16:00 UTC
+	{1838217600UL, 100},	//2028-04-01 16:00 UTC
+	{1853942400UL, 110},	//2028-09-30 16:00 UTC
+	{1869667200UL, 100},	//2029-03-31 16:00 UTC
+	{1885996800UL, 110},	//2029-10-06 16:00 UTC
+	{1901721600UL, 100},	//2030-04-06 16:00 UTC
+	{1917446400UL, 110},	//2030-10-05 16:00 UTC
+	{1933171200UL, 100},	//2031-04-05 16:00 UTC
+	{1948896000UL, 110},	//2031-10-04 16:00 UTC
+	{1964620800UL, 100},	//2032-04-03 16:00 UTC
+	{1980345600UL, 110},	//2032-10-02 16:00 UTC
+	{1996070400UL, 100},	//2033-04-02 16:00 UTC
+	{2011795200UL, 110},	//2033-10-01 16:00 UTC
+	{2027520000UL, 100},	//2034-04-01 16:00 UTC
+	{2043244800UL, 110},	//2034-09-30 16:00 UTC
+	{2058969600UL, 100},	//2035-03-31 16:00 UTC
+	{2075299200UL, 110},	//2035-10-06 16:00 UTC
+	{2091024000UL, 100},	//2036-04-05 16:00 UTC
+	{2106748800UL, 110},	//2036-10-04 16:00 UTC
+	{2122473600UL, 100},	//2037-04-04 16:00 UTC
+	{2138198400UL, 110},	//2037-10-03 16:00 UTC
+	{2153923200UL, 100},	//2038-04-03 16:00 UTC
+	{2169648000UL, 110},	//2038-10-02 16:00 UTC
+	{2185372800UL, 100},	//2039-04-02 16:00 UTC
+	{2201097600UL, 110},	//2039-10-01 16:00 UTC
+	{2216822400UL, 100},	//2040-03-31 16:00 UTC
+	{2233152000UL, 110},	//2040-10-06 16:00 UTC
+};
+
+//Zones with daylight saving (zone ZONE_FIXED onwards).
+static const zone_info zone_infos[] PROGMEM =
+{
+	//Name		Initial	First	Count
+	{zone_name_0,	0,	0,	32},	//Zone 49: Europe/London
+	{zone_name_1,	10,	32,	32},	//Zone 50: Europe/Berlin
+	{zone_name_2,	20,	64,	32},	//Zone 51: Europe/Athens
+	{zone_name_3,	-35,	96,	32},	//Zone 52: America/St_Johns
+	{zone_name_4,	-40,	128,	32},	//Zone 53: America/Halifax
+	{zone_name_5,	-50,	160,	32},	//Zone 54: America/New_York
+	{zone_name_6,	-60,	192,	32},	//Zone 55: America/Chicago
+	{zone_name_7,	-70,	224,	32},	//Zone 56: America/Denver
+	{zone_name_8,	-80,	256,	32},	//Zone 57: America/Los_Angeles
+	{zone_name_9,	-90,	288,	32},	//Zone 58: America/Anchorage
+	{zone_name_10,	105,	320,	32},	//Zone 59: Australia/Adelaide
+	{zone_name_11,	110,	352,	32},	//Zone 60: Australia/Sydney
+};
+#endif
+
+#endif